@@ -0,0 +1,402 @@
+#include "AudioKernels.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cstdint>
+
+namespace
+{
+	// Frames [begin, end); the vector kernels finish their tails here.
+	void mixScalar(const float* src, int channels, float frac, float step, size_t begin, size_t end,
+		float gainL, float gainR, float gainStepL, float gainStepR, float* outL, float* outR)
+	{
+		for (size_t k = begin; k < end; ++k)
+		{
+			const float at = frac + (float)k * step;
+			const size_t i = (size_t)at;
+			const float t = at - (float)i;
+			const float wl = gainL + (float)k * gainStepL;
+			const float wr = gainR + (float)k * gainStepR;
+			if (channels == 1)
+			{
+				const float s = src[i] + (src[i + 1] - src[i]) * t;
+				outL[k] += s * wl;
+				outR[k] += s * wr;
+			}
+			else
+			{
+				const float* f = src + i * 2;
+				outL[k] += (f[0] + (f[2] - f[0]) * t) * wl;
+				outR[k] += (f[1] + (f[3] - f[1]) * t) * wr;
+			}
+		}
+	}
+
+	void interleaveScalar(const float* left, const float* right, float* out, size_t begin, size_t end)
+	{
+		for (size_t k = begin; k < end; ++k)
+		{
+			out[k * 2] = left[k] < -1.0f ? -1.0f : left[k] > 1.0f ? 1.0f : left[k];
+			out[k * 2 + 1] = right[k] < -1.0f ? -1.0f : right[k] > 1.0f ? 1.0f : right[k];
+		}
+	}
+
+	// Per-call constants of the distance model.
+	struct SpatialConstants
+	{
+		float edgeScale;	// 1 / fade length before maxDistance
+		float panScale;		// 1 / panWidth
+	};
+
+	SpatialConstants spatialConstants(const SpatialParams& params)
+	{
+		return { 4.0f / params.maxDistance, 1.0f / params.panWidth };
+	}
+
+	void spatialScalar(const float* x, const float* y, const float* gain, size_t begin, size_t end,
+		const SpatialParams& params, float* outL, float* outR)
+	{
+		const SpatialConstants c = spatialConstants(params);
+		for (size_t i = begin; i < end; ++i)
+		{
+			const float dx = x[i] - params.listenerX;
+			const float dy = y[i] - params.listenerY;
+			const float distance = SDL_sqrtf(dx * dx + dy * dy);
+			const float edge = SDL_clamp((params.maxDistance - distance) * c.edgeScale, 0.0f, 1.0f);
+			const float g = gain[i] * edge * params.refDistance / SDL_max(distance, params.refDistance);
+			const float pan = SDL_clamp(dx * c.panScale, -1.0f, 1.0f);
+			outL[i] = g * SDL_sqrtf(0.5f - 0.5f * pan);
+			outR[i] = g * SDL_sqrtf(0.5f + 0.5f * pan);
+		}
+	}
+
+#ifdef SDL_SSE2_INTRINSICS
+	struct GainsSSE2
+	{
+		__m128 left;
+		__m128 right;
+		__m128 stepLeft;
+		__m128 stepRight;
+	};
+
+	SDL_TARGETING("sse2") inline void accumulateSSE2(const GainsSSE2& gains, __m128 k, __m128 left, __m128 right,
+		float* outL, float* outR)
+	{
+		const __m128 wl = _mm_add_ps(gains.left, _mm_mul_ps(k, gains.stepLeft));
+		const __m128 wr = _mm_add_ps(gains.right, _mm_mul_ps(k, gains.stepRight));
+		_mm_storeu_ps(outL, _mm_add_ps(_mm_loadu_ps(outL), _mm_mul_ps(left, wl)));
+		_mm_storeu_ps(outR, _mm_add_ps(_mm_loadu_ps(outR), _mm_mul_ps(right, wr)));
+	}
+
+	SDL_TARGETING("sse2") void mixSSE2(const float* src, int channels, float frac, float step, size_t frames,
+		float gainL, float gainR, float gainStepL, float gainStepR, float* outL, float* outR)
+	{
+		const size_t vectorEnd = frames / 4 * 4;
+		const GainsSSE2 gains = { _mm_set1_ps(gainL), _mm_set1_ps(gainR), _mm_set1_ps(gainStepL), _mm_set1_ps(gainStepR) };
+		const __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+		const __m128 vfrac = _mm_set1_ps(frac);
+		const __m128 vstep = _mm_set1_ps(step);
+		if (step == 1.0f && channels == 1)
+		{
+			// Unpitched mono: both taps are plain loads.
+			for (size_t k = 0; k < vectorEnd; k += 4)
+			{
+				const __m128 a = _mm_loadu_ps(src + k);
+				const __m128 s = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(src + k + 1), a), vfrac));
+				accumulateSSE2(gains, _mm_add_ps(_mm_set1_ps((float)k), lane), s, s, outL + k, outR + k);
+			}
+		}
+		else if (step == 1.0f)
+		{
+			// Unpitched stereo: deinterleave four frames and their successors.
+			for (size_t k = 0; k < vectorEnd; k += 4)
+			{
+				const float* f = src + k * 2;
+				const __m128 p0 = _mm_loadu_ps(f);
+				const __m128 p1 = _mm_loadu_ps(f + 4);
+				const __m128 q0 = _mm_loadu_ps(f + 2);
+				const __m128 q1 = _mm_loadu_ps(f + 6);
+				const __m128 al = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 ar = _mm_shuffle_ps(p0, p1, _MM_SHUFFLE(3, 1, 3, 1));
+				const __m128 bl = _mm_shuffle_ps(q0, q1, _MM_SHUFFLE(2, 0, 2, 0));
+				const __m128 br = _mm_shuffle_ps(q0, q1, _MM_SHUFFLE(3, 1, 3, 1));
+				accumulateSSE2(gains, _mm_add_ps(_mm_set1_ps((float)k), lane),
+					_mm_add_ps(al, _mm_mul_ps(_mm_sub_ps(bl, al), vfrac)),
+					_mm_add_ps(ar, _mm_mul_ps(_mm_sub_ps(br, ar), vfrac)), outL + k, outR + k);
+			}
+		}
+		else
+		{
+			// Resampling: SSE2 has no gather, so the taps are fetched by index.
+			alignas(16) int32_t idx[4];
+			for (size_t k = 0; k < vectorEnd; k += 4)
+			{
+				const __m128 kv = _mm_add_ps(_mm_set1_ps((float)k), lane);
+				const __m128 at = _mm_add_ps(vfrac, _mm_mul_ps(kv, vstep));
+				const __m128i i = _mm_cvttps_epi32(at);
+				const __m128 t = _mm_sub_ps(at, _mm_cvtepi32_ps(i));
+				_mm_store_si128((__m128i*)idx, i);
+				if (channels == 1)
+				{
+					const __m128 a = _mm_setr_ps(src[idx[0]], src[idx[1]], src[idx[2]], src[idx[3]]);
+					const __m128 b = _mm_setr_ps(src[idx[0] + 1], src[idx[1] + 1], src[idx[2] + 1], src[idx[3] + 1]);
+					const __m128 s = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+					accumulateSSE2(gains, kv, s, s, outL + k, outR + k);
+				}
+				else
+				{
+					const float* f0 = src + idx[0] * 2;
+					const float* f1 = src + idx[1] * 2;
+					const float* f2 = src + idx[2] * 2;
+					const float* f3 = src + idx[3] * 2;
+					const __m128 al = _mm_setr_ps(f0[0], f1[0], f2[0], f3[0]);
+					const __m128 ar = _mm_setr_ps(f0[1], f1[1], f2[1], f3[1]);
+					const __m128 bl = _mm_setr_ps(f0[2], f1[2], f2[2], f3[2]);
+					const __m128 br = _mm_setr_ps(f0[3], f1[3], f2[3], f3[3]);
+					accumulateSSE2(gains, kv, _mm_add_ps(al, _mm_mul_ps(_mm_sub_ps(bl, al), t)),
+						_mm_add_ps(ar, _mm_mul_ps(_mm_sub_ps(br, ar), t)), outL + k, outR + k);
+				}
+			}
+		}
+		mixScalar(src, channels, frac, step, vectorEnd, frames, gainL, gainR, gainStepL, gainStepR, outL, outR);
+	}
+
+	SDL_TARGETING("sse2") void interleaveSSE2(const float* left, const float* right, float* out, size_t frames)
+	{
+		const size_t vectorEnd = frames / 4 * 4;
+		const __m128 lo = _mm_set1_ps(-1.0f);
+		const __m128 hi = _mm_set1_ps(1.0f);
+		for (size_t k = 0; k < vectorEnd; k += 4)
+		{
+			const __m128 l = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(left + k), lo), hi);
+			const __m128 r = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(right + k), lo), hi);
+			_mm_storeu_ps(out + k * 2, _mm_unpacklo_ps(l, r));
+			_mm_storeu_ps(out + k * 2 + 4, _mm_unpackhi_ps(l, r));
+		}
+		interleaveScalar(left, right, out, vectorEnd, frames);
+	}
+
+	SDL_TARGETING("sse2") void spatialSSE2(const float* x, const float* y, const float* gain, size_t count,
+		const SpatialParams& params, float* outL, float* outR)
+	{
+		const SpatialConstants c = spatialConstants(params);
+		const size_t vectorEnd = count / 4 * 4;
+		const __m128 lx = _mm_set1_ps(params.listenerX);
+		const __m128 ly = _mm_set1_ps(params.listenerY);
+		const __m128 ref = _mm_set1_ps(params.refDistance);
+		const __m128 maxDistance = _mm_set1_ps(params.maxDistance);
+		const __m128 edgeScale = _mm_set1_ps(c.edgeScale);
+		const __m128 panScale = _mm_set1_ps(c.panScale);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		for (size_t i = 0; i < vectorEnd; i += 4)
+		{
+			const __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), lx);
+			const __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), ly);
+			const __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+			const __m128 edge = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(maxDistance, distance), edgeScale), zero), one);
+			const __m128 g = _mm_div_ps(_mm_mul_ps(_mm_mul_ps(_mm_loadu_ps(gain + i), edge), ref), _mm_max_ps(distance, ref));
+			const __m128 pan = _mm_mul_ps(_mm_min_ps(_mm_max_ps(_mm_mul_ps(dx, panScale), _mm_sub_ps(zero, one)), one), half);
+			_mm_storeu_ps(outL + i, _mm_mul_ps(g, _mm_sqrt_ps(_mm_sub_ps(half, pan))));
+			_mm_storeu_ps(outR + i, _mm_mul_ps(g, _mm_sqrt_ps(_mm_add_ps(half, pan))));
+		}
+		spatialScalar(x, y, gain, vectorEnd, count, params, outL, outR);
+	}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+	struct GainsAVX2
+	{
+		__m256 left;
+		__m256 right;
+		__m256 stepLeft;
+		__m256 stepRight;
+	};
+
+	SDL_TARGETING("avx2") inline void accumulateAVX2(const GainsAVX2& gains, __m256 k, __m256 left, __m256 right,
+		float* outL, float* outR)
+	{
+		const __m256 wl = _mm256_add_ps(gains.left, _mm256_mul_ps(k, gains.stepLeft));
+		const __m256 wr = _mm256_add_ps(gains.right, _mm256_mul_ps(k, gains.stepRight));
+		_mm256_storeu_ps(outL, _mm256_add_ps(_mm256_loadu_ps(outL), _mm256_mul_ps(left, wl)));
+		_mm256_storeu_ps(outR, _mm256_add_ps(_mm256_loadu_ps(outR), _mm256_mul_ps(right, wr)));
+	}
+
+	// Splits eight interleaved stereo frames into left and right.
+	SDL_TARGETING("avx2") inline void deinterleaveAVX2(__m256 a, __m256 b, __m256& left, __m256& right)
+	{
+		// shuffle_ps works within 128-bit lanes; the permute restores order.
+		left = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, 0x88)), 0xd8));
+		right = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_shuffle_ps(a, b, 0xdd)), 0xd8));
+	}
+
+	SDL_TARGETING("avx2") void mixAVX2(const float* src, int channels, float frac, float step, size_t frames,
+		float gainL, float gainR, float gainStepL, float gainStepR, float* outL, float* outR)
+	{
+		const size_t vectorEnd = frames / 8 * 8;
+		const GainsAVX2 gains = { _mm256_set1_ps(gainL), _mm256_set1_ps(gainR), _mm256_set1_ps(gainStepL), _mm256_set1_ps(gainStepR) };
+		const __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+		const __m256 vfrac = _mm256_set1_ps(frac);
+		const __m256 vstep = _mm256_set1_ps(step);
+		if (step == 1.0f && channels == 1)
+		{
+			for (size_t k = 0; k < vectorEnd; k += 8)
+			{
+				const __m256 a = _mm256_loadu_ps(src + k);
+				const __m256 s = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(src + k + 1), a), vfrac));
+				accumulateAVX2(gains, _mm256_add_ps(_mm256_set1_ps((float)k), lane), s, s, outL + k, outR + k);
+			}
+		}
+		else if (step == 1.0f)
+		{
+			for (size_t k = 0; k < vectorEnd; k += 8)
+			{
+				const float* f = src + k * 2;
+				__m256 al, ar, bl, br;
+				deinterleaveAVX2(_mm256_loadu_ps(f), _mm256_loadu_ps(f + 8), al, ar);
+				deinterleaveAVX2(_mm256_loadu_ps(f + 2), _mm256_loadu_ps(f + 10), bl, br);
+				accumulateAVX2(gains, _mm256_add_ps(_mm256_set1_ps((float)k), lane),
+					_mm256_add_ps(al, _mm256_mul_ps(_mm256_sub_ps(bl, al), vfrac)),
+					_mm256_add_ps(ar, _mm256_mul_ps(_mm256_sub_ps(br, ar), vfrac)), outL + k, outR + k);
+			}
+		}
+		else
+		{
+			// Resampling gathers its taps.
+			for (size_t k = 0; k < vectorEnd; k += 8)
+			{
+				const __m256 kv = _mm256_add_ps(_mm256_set1_ps((float)k), lane);
+				const __m256 at = _mm256_add_ps(vfrac, _mm256_mul_ps(kv, vstep));
+				const __m256i i = _mm256_cvttps_epi32(at);
+				const __m256 t = _mm256_sub_ps(at, _mm256_cvtepi32_ps(i));
+				if (channels == 1)
+				{
+					const __m256 a = _mm256_i32gather_ps(src, i, 4);
+					const __m256 b = _mm256_i32gather_ps(src + 1, i, 4);
+					const __m256 s = _mm256_add_ps(a, _mm256_mul_ps(_mm256_sub_ps(b, a), t));
+					accumulateAVX2(gains, kv, s, s, outL + k, outR + k);
+				}
+				else
+				{
+					const __m256i i2 = _mm256_slli_epi32(i, 1);
+					const __m256 al = _mm256_i32gather_ps(src, i2, 4);
+					const __m256 ar = _mm256_i32gather_ps(src + 1, i2, 4);
+					const __m256 bl = _mm256_i32gather_ps(src + 2, i2, 4);
+					const __m256 br = _mm256_i32gather_ps(src + 3, i2, 4);
+					accumulateAVX2(gains, kv, _mm256_add_ps(al, _mm256_mul_ps(_mm256_sub_ps(bl, al), t)),
+						_mm256_add_ps(ar, _mm256_mul_ps(_mm256_sub_ps(br, ar), t)), outL + k, outR + k);
+				}
+			}
+		}
+		mixScalar(src, channels, frac, step, vectorEnd, frames, gainL, gainR, gainStepL, gainStepR, outL, outR);
+	}
+
+	SDL_TARGETING("avx2") void interleaveAVX2(const float* left, const float* right, float* out, size_t frames)
+	{
+		const size_t vectorEnd = frames / 8 * 8;
+		const __m256 lo = _mm256_set1_ps(-1.0f);
+		const __m256 hi = _mm256_set1_ps(1.0f);
+		for (size_t k = 0; k < vectorEnd; k += 8)
+		{
+			const __m256 l = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(left + k), lo), hi);
+			const __m256 r = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(right + k), lo), hi);
+			// unpack works within 128-bit lanes; the permutes restore order.
+			const __m256 a = _mm256_unpacklo_ps(l, r);
+			const __m256 b = _mm256_unpackhi_ps(l, r);
+			_mm256_storeu_ps(out + k * 2, _mm256_permute2f128_ps(a, b, 0x20));
+			_mm256_storeu_ps(out + k * 2 + 8, _mm256_permute2f128_ps(a, b, 0x31));
+		}
+		interleaveScalar(left, right, out, vectorEnd, frames);
+	}
+
+	SDL_TARGETING("avx2") void spatialAVX2(const float* x, const float* y, const float* gain, size_t count,
+		const SpatialParams& params, float* outL, float* outR)
+	{
+		const SpatialConstants c = spatialConstants(params);
+		const size_t vectorEnd = count / 8 * 8;
+		const __m256 lx = _mm256_set1_ps(params.listenerX);
+		const __m256 ly = _mm256_set1_ps(params.listenerY);
+		const __m256 ref = _mm256_set1_ps(params.refDistance);
+		const __m256 maxDistance = _mm256_set1_ps(params.maxDistance);
+		const __m256 edgeScale = _mm256_set1_ps(c.edgeScale);
+		const __m256 panScale = _mm256_set1_ps(c.panScale);
+		const __m256 zero = _mm256_setzero_ps();
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 half = _mm256_set1_ps(0.5f);
+		for (size_t i = 0; i < vectorEnd; i += 8)
+		{
+			const __m256 dx = _mm256_sub_ps(_mm256_loadu_ps(x + i), lx);
+			const __m256 dy = _mm256_sub_ps(_mm256_loadu_ps(y + i), ly);
+			const __m256 distance = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+			const __m256 edge = _mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(maxDistance, distance), edgeScale), zero), one);
+			const __m256 g = _mm256_div_ps(_mm256_mul_ps(_mm256_mul_ps(_mm256_loadu_ps(gain + i), edge), ref),
+				_mm256_max_ps(distance, ref));
+			const __m256 pan = _mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(dx, panScale), _mm256_sub_ps(zero, one)), one), half);
+			_mm256_storeu_ps(outL + i, _mm256_mul_ps(g, _mm256_sqrt_ps(_mm256_sub_ps(half, pan))));
+			_mm256_storeu_ps(outR + i, _mm256_mul_ps(g, _mm256_sqrt_ps(_mm256_add_ps(half, pan))));
+		}
+		spatialScalar(x, y, gain, vectorEnd, count, params, outL, outR);
+	}
+#endif
+}
+
+void mixVoice(SimdPath path, const float* src, int channels, float frac, float step, size_t frames,
+	float gainL, float gainR, float gainStepL, float gainStepR, float* outL, float* outR)
+{
+	switch (path)
+	{
+#ifdef SDL_AVX2_INTRINSICS
+	case SimdPath::AVX2:
+		mixAVX2(src, channels, frac, step, frames, gainL, gainR, gainStepL, gainStepR, outL, outR);
+		break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+	case SimdPath::SSE2:
+		mixSSE2(src, channels, frac, step, frames, gainL, gainR, gainStepL, gainStepR, outL, outR);
+		break;
+#endif
+	default:
+		mixScalar(src, channels, frac, step, 0, frames, gainL, gainR, gainStepL, gainStepR, outL, outR);
+		break;
+	}
+}
+
+void interleaveStereo(SimdPath path, const float* left, const float* right, float* out, size_t frames)
+{
+	switch (path)
+	{
+#ifdef SDL_AVX2_INTRINSICS
+	case SimdPath::AVX2:
+		interleaveAVX2(left, right, out, frames);
+		break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+	case SimdPath::SSE2:
+		interleaveSSE2(left, right, out, frames);
+		break;
+#endif
+	default:
+		interleaveScalar(left, right, out, 0, frames);
+		break;
+	}
+}
+
+void spatialGains(SimdPath path, const float* x, const float* y, const float* gain, size_t count,
+	const SpatialParams& params, float* outL, float* outR)
+{
+	switch (path)
+	{
+#ifdef SDL_AVX2_INTRINSICS
+	case SimdPath::AVX2:
+		spatialAVX2(x, y, gain, count, params, outL, outR);
+		break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+	case SimdPath::SSE2:
+		spatialSSE2(x, y, gain, count, params, outL, outR);
+		break;
+#endif
+	default:
+		spatialScalar(x, y, gain, 0, count, params, outL, outR);
+		break;
+	}
+}
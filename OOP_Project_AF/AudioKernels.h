@@ -0,0 +1,32 @@
+#pragma once
+#include "Simd.h"
+#include <cstddef>
+
+// Adds frames of one voice to planar stereo accumulators. src points at the
+// source frame the voice is on (channels 1 or 2, interleaved); output frame
+// k reads the source at src + frac + k * step, linearly interpolated, so
+// src must hold floor(frac + (frames - 1) * step) + 2 frames. Gains ramp
+// from gainL/gainR by gainStepL/gainStepR per frame and carry volume and
+// pan; a mono source feeds both sides.
+void mixVoice(SimdPath path, const float* src, int channels, float frac, float step, size_t frames,
+	float gainL, float gainR, float gainStepL, float gainStepR, float* outL, float* outR);
+
+// Interleaves planar accumulators into stereo frames, clamped to [-1, 1].
+void interleaveStereo(SimdPath path, const float* left, const float* right, float* out, size_t frames);
+
+// Listener and distance model for spatialGains, in world units.
+struct SpatialParams
+{
+	float listenerX;
+	float listenerY;
+	float refDistance;	// full gain within this radius, > 0
+	float maxDistance;	// silent from here; fades over the last quarter
+	float panWidth;		// horizontal offset that pans fully to one side
+};
+
+// Final left/right gains for count emitters: gain falls off as
+// refDistance / distance, pans by horizontal offset with a constant-power
+// law (left^2 + right^2 = 1 before attenuation) and reaches zero at
+// maxDistance.
+void spatialGains(SimdPath path, const float* x, const float* y, const float* gain, size_t count,
+	const SpatialParams& params, float* outL, float* outR);
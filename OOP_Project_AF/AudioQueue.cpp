@@ -0,0 +1,112 @@
+#include "AudioQueue.h"
+
+namespace
+{
+	const uint32_t GenerationShift = 8;
+	static_assert(AudioQueue::MaxVoices == 1u << GenerationShift, "voice ids keep the slot in the low bits");
+	static_assert(VoiceParamBlock::Capacity >= AudioQueue::MaxVoices, "a block covers every voice");
+}
+
+AudioQueue::AudioQueue()
+	: back(0), front(1), middle(2), freeCount(MaxVoices)
+{
+	for (VoiceParamBlock& block : params)
+	{
+		block.tick = 0;
+		block.count = 0;
+	}
+	for (uint32_t slot = 0; slot < MaxVoices; ++slot)
+	{
+		generation[slot] = 0;
+		live[slot] = false;
+		// Handed out from the back, lowest slot first.
+		freeSlots[slot] = MaxVoices - 1 - slot;
+	}
+}
+
+AudioQueue::AudioQueue(const AudioQueue&)
+	: AudioQueue()
+{
+}
+
+uint32_t AudioQueue::play(uint32_t sound, float gain, float pan, float pitch, bool loop, uint8_t priority)
+{
+	return start(VoiceCommand::Type::Play, sound, gain, pan, pitch, loop, priority);
+}
+
+uint32_t AudioQueue::playGains(uint32_t sound, float gainL, float gainR, float pitch, bool loop, uint8_t priority)
+{
+	return start(VoiceCommand::Type::PlayGains, sound, gainL, gainR, pitch, loop, priority);
+}
+
+uint32_t AudioQueue::start(VoiceCommand::Type type, uint32_t sound, float gain, float pan, float pitch, bool loop,
+	uint8_t priority)
+{
+	reclaim();
+	if (freeCount == 0)
+		return NoVoice;
+	const uint32_t slot = freeSlots[freeCount - 1];
+	const uint32_t voice = (generation[slot] << GenerationShift) | slot;
+	if (!commands.push(VoiceCommand{ type, loop, priority, voice, sound, gain, pan, pitch }))
+		return NoVoice;
+	--freeCount;
+	live[slot] = true;
+	return voice;
+}
+
+bool AudioQueue::stop(uint32_t voice)
+{
+	if (!playing(voice) || !commands.push(VoiceCommand{ VoiceCommand::Type::Stop, false, 0, voice, NoSound, 0.0f, 0.0f, 0.0f }))
+		return false;
+	release(slotOf(voice));
+	return true;
+}
+
+bool AudioQueue::set(uint32_t voice, float gain, float pan, float pitch)
+{
+	return playing(voice) && commands.push(VoiceCommand{ VoiceCommand::Type::Set, false, 0, voice, NoSound, gain, pan, pitch });
+}
+
+void AudioQueue::stopAll()
+{
+	if (!commands.push(VoiceCommand{ VoiceCommand::Type::StopAll, false, 0, NoVoice, NoSound, 0.0f, 0.0f, 0.0f }))
+		return;
+	for (uint32_t slot = 0; slot < MaxVoices; ++slot)
+		if (live[slot])
+			release(slot);
+}
+
+bool AudioQueue::playing(uint32_t voice) const
+{
+	const uint32_t slot = slotOf(voice);
+	return voice != NoVoice && live[slot] && generation[slot] == voice >> GenerationShift;
+}
+
+void AudioQueue::reclaim()
+{
+	uint32_t voice;
+	while (done.pop(voice))
+		if (playing(voice))
+			release(slotOf(voice));
+}
+
+void AudioQueue::publishParams()
+{
+	back = middle.exchange((uint8_t)(back | Fresh), std::memory_order_acq_rel) & (Fresh - 1);
+}
+
+const VoiceParamBlock* AudioQueue::takeParams()
+{
+	if (!(middle.load(std::memory_order_relaxed) & Fresh))
+		return nullptr;
+	front = middle.exchange(front, std::memory_order_acq_rel) & (Fresh - 1);
+	return &params[front];
+}
+
+void AudioQueue::release(uint32_t slot)
+{
+	live[slot] = false;
+	// One bit short of the id width, so no id equals NoVoice.
+	generation[slot] = (generation[slot] + 1) & (0xffffffffu >> (GenerationShift + 1));
+	freeSlots[freeCount++] = slot;
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct VoiceCommand
+{
+	// PlayGains carries final left and right gains in gain and pan, used
+	// as they are like a VoiceParamBlock's.
+	enum class Type : uint8_t { Play, PlayGains, Stop, Set, StopAll };
+
+	Type type;
+	bool loop;
+	uint8_t priority;	// higher keeps mixing longer when over budget
+	uint32_t voice;
+	uint32_t sound;
+	float gain;
+	float pan;		// -1 left .. 1 right
+	float pitch;	// playback rate multiplier
+};
+
+// Final left/right gains for many voices at once, e.g. every positional
+// voice after SpatialAudio's pass. The mixer uses them as the voices' new
+// targets as they are, without pan laws; stale voice ids are skipped.
+struct VoiceParamBlock
+{
+	static constexpr uint32_t Capacity = 256;
+
+	uint64_t tick;
+	uint32_t count;
+	uint32_t voice[Capacity];
+	float gainL[Capacity];
+	float gainR[Capacity];
+};
+
+// Voice requests from Model (the one producer thread) to the Mixer's audio
+// callback, and finished voices back, over two SpscQueues. Voice ids are
+// handed out here, so play() returns at once; an id is a slot plus a
+// generation, and a stale id is simply ignored.
+class AudioQueue
+{
+public:
+	static constexpr uint32_t MaxVoices = 256;
+	static constexpr uint32_t NoVoice = 0xffffffffu;
+	static constexpr uint32_t NoSound = 0xffffffffu;
+	static constexpr uint8_t DefaultPriority = 128;
+
+	AudioQueue();
+
+	// The queue is tied to the running mixer, not to simulation state:
+	// copies start empty and assignment keeps this queue as it is, so a
+	// Model swapped in from a save keeps talking to the same mixer.
+	AudioQueue(const AudioQueue&);
+	AudioQueue& operator=(const AudioQueue&) { return *this; }
+
+	// Producer side. play returns NoVoice when all voices are busy or the
+	// command ring is full. Voices past the mixer's budget keep their place
+	// in the sound but go silent, lowest priority and quietest first.
+	uint32_t play(uint32_t sound, float gain = 1.0f, float pan = 0.0f, float pitch = 1.0f, bool loop = false,
+		uint8_t priority = DefaultPriority);
+	// Starts at final left/right gains, without a pan law, for voices whose
+	// later gains come through parameter blocks.
+	uint32_t playGains(uint32_t sound, float gainL, float gainR, float pitch = 1.0f, bool loop = false,
+		uint8_t priority = DefaultPriority);
+	bool stop(uint32_t voice);
+	bool set(uint32_t voice, float gain, float pan, float pitch);
+	void stopAll();
+	bool playing(uint32_t voice) const;
+	size_t voiceCount() const { return MaxVoices - freeCount; }
+	// Frees the voices the mixer finished. play() does this itself.
+	void reclaim();
+
+	// Parameter blocks are latest-wins: the producer fills the block from
+	// beginParams() and publishes it, replacing one the mixer has not taken
+	// yet. Neither side ever waits.
+	VoiceParamBlock& beginParams() { return params[back]; }
+	void publishParams();
+
+	// Consumer side, audio thread only.
+	bool pop(VoiceCommand& command) { return commands.pop(command); }
+	void finished(uint32_t voice) { done.push(voice); }
+	// The newest published block, or null if there is none since last time.
+	const VoiceParamBlock* takeParams();
+
+	static uint32_t slotOf(uint32_t voice) { return voice & (MaxVoices - 1); }
+
+private:
+	uint32_t start(VoiceCommand::Type type, uint32_t sound, float gain, float pan, float pitch, bool loop,
+		uint8_t priority);
+	void release(uint32_t slot);
+
+	SpscQueue<VoiceCommand, 1024> commands;
+	// The mixer holds at most MaxVoices voices, each finishing once between
+	// two reclaims, so this never overflows.
+	SpscQueue<uint32_t, MaxVoices> done;
+
+	// Triple buffer: the producer owns params[back], the consumer
+	// params[front], and middle holds the third index plus a fresh flag.
+	static constexpr uint8_t Fresh = 4;
+	VoiceParamBlock params[3];
+	uint8_t back;
+	uint8_t front;
+	std::atomic<uint8_t> middle;
+
+	uint32_t generation[MaxVoices];
+	bool live[MaxVoices];
+	uint32_t freeSlots[MaxVoices];
+	uint32_t freeCount;
+};
@@ -0,0 +1,936 @@
+#include "Benchmark.h"
+#include "Collision.h"
+#include "EventBus.h"
+#include "HierarchicalPaths.h"
+#include "Integrate.h"
+#include "JobSystem.h"
+#include "Mixer.h"
+#include "ParticleSystem.h"
+#include "RenderQueue.h"
+#include "TransformHierarchy.h"
+#include "Model.h"
+#include "NavGrid.h"
+#include "PathService.h"
+#include "Simd.h"
+#include "SpatialAudio.h"
+#include "View.h"
+#include <SDL3/SDL_init.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <SDL3/SDL_video.h>
+#include <memory>
+#include <vector>
+
+namespace
+{
+	// Repeats body until at least minSeconds have elapsed; returns seconds per run.
+	template <typename Body>
+	double timeIt(Body body, double minSeconds = 0.5)
+	{
+		int runs = 0;
+		const Uint64 start = SDL_GetTicksNS();
+		Uint64 elapsed = 0;
+		do
+		{
+			body();
+			++runs;
+			elapsed = SDL_GetTicksNS() - start;
+		} while ((double)elapsed < minSeconds * 1e9);
+		return (double)elapsed / 1e9 / runs;
+	}
+
+	void populate(Model& model, size_t count, float maxSpeed)
+	{
+		model.clear();
+		for (size_t i = 0; i < count; ++i)
+			model.spawn(SDL_randf() * model.worldWidth, SDL_randf() * model.worldHeight,
+				(SDL_randf() - 0.5f) * maxSpeed, (SDL_randf() - 0.5f) * maxSpeed, 1.0f + SDL_randf() * 3.0f);
+	}
+
+	int benchCollision()
+	{
+		const SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+		const size_t counts[] = { 10000, 100000, 1000000 };
+		for (size_t count : counts)
+		{
+			// Density stays constant so candidate pairs scale with count.
+			const float side = SDL_sqrtf((float)count) * 8.0f;
+			Model model(side, side);
+			populate(model, count, 50.0f);
+
+			CollisionSystem system;
+			const double broad = timeIt([&] { system.broadphase(model); });
+			SDL_Log("%zu entities: broadphase %.2f ms, %zu candidate pairs",
+				count, broad * 1e3, system.candidateCount());
+
+			size_t expected = 0;
+			for (SimdPath path : paths)
+			{
+				if (!simdPathSupported(path))
+				{
+					SDL_Log("  %-6s unsupported on this CPU", simdPathName(path));
+					continue;
+				}
+				system.setPath(path);
+				const double narrow = timeIt([&] { system.narrowphase(model); });
+				if (path == SimdPath::Scalar)
+					expected = system.contactCount();
+				SDL_Log("  %-6s narrowphase %.3f ms, %.1f Mpairs/s, %zu contacts%s",
+					simdPathName(path), narrow * 1e3, system.candidateCount() / narrow / 1e6,
+					system.contactCount(), system.contactCount() == expected ? "" : " (MISMATCH)");
+			}
+		}
+		return 0;
+	}
+
+	int benchIntegrate()
+	{
+		const size_t count = 1000000;
+		Model model(4096.0f, 4096.0f);
+		populate(model, count, 100.0f);
+
+		MotionParams params;
+		params.dt = 1.0f / 60.0f;
+		params.damping = 0.999f;
+		params.minX = 0.0f;
+		params.minY = 0.0f;
+		params.maxX = model.worldWidth;
+		params.maxY = model.worldHeight;
+
+		JobSystem& jobs = JobSystem::shared();
+		const SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+		SDL_Log("%zu entities, %d threads", count, jobs.threadCount());
+		for (SimdPath path : paths)
+		{
+			if (!simdPathSupported(path))
+			{
+				SDL_Log("  %-6s unsupported on this CPU", simdPathName(path));
+				continue;
+			}
+			const double single = timeIt([&]
+				{
+					integrateMotion(path, model.posX.data(), model.posY.data(),
+						model.velX.data(), model.velY.data(), 0, count, params);
+				});
+			const double parallel = timeIt([&]
+				{
+					jobs.parallelFor(count, 32 * 1024, [&](size_t begin, size_t end)
+						{
+							integrateMotion(path, model.posX.data(), model.posY.data(),
+								model.velX.data(), model.velY.data(), begin, end, params);
+						});
+				});
+			SDL_Log("  %-6s %.3f ms single-threaded, %.3f ms parallel",
+				simdPathName(path), single * 1e3, parallel * 1e3);
+		}
+		return 0;
+	}
+
+	int benchParticles()
+	{
+		// Steady state around 500k live particles: emission matches expiry.
+		const size_t target = 500000;
+		const float lifetime = 2.0f;
+		ParticleSystem particles;
+		particles.gravity = 100.0f;
+		ParticleEmitter emitter = {};
+		emitter.pool = particles.createPool(nullptr, target + target / 4);
+		emitter.x = 2048.0f;
+		emitter.y = 2048.0f;
+		emitter.rate = target / (lifetime * 0.875f);
+		emitter.speed = 200.0f;
+		emitter.spread = 2.0f * SDL_PI_F;
+		emitter.lifetime = lifetime;
+		emitter.size = 3.0f;
+		emitter.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+		emitter.active = true;
+		particles.addEmitter(emitter);
+
+		const float dt = 1.0f / 60.0f;
+		for (int i = 0; i < 180; ++i)
+			particles.update(dt);
+		const double update = timeIt([&] { particles.update(dt); });
+		SDL_Log("%zu live particles, %d threads: update + vertex build %.3f ms (%s)",
+			particles.liveCount(), JobSystem::shared().threadCount(), update * 1e3,
+			simdPathName(bestSimdPath()));
+		return 0;
+	}
+
+	int benchRenderQueue()
+	{
+		// Fake texture handles: sorting only compares pointers, and the
+		// benchmark never submits.
+		static char textures[32];
+		const SDL_BlendMode blends[] = { SDL_BLENDMODE_NONE, SDL_BLENDMODE_BLEND, SDL_BLENDMODE_ADD };
+		const size_t count = 200000;
+		RenderQueue queue;
+		for (size_t i = 0; i < count; ++i)
+		{
+			SDL_Texture* texture = (SDL_Texture*)&textures[SDL_rand(32)];
+			const SDL_FRect dst = { SDL_randf() * 1280.0f, SDL_randf() * 720.0f, 8.0f, 8.0f };
+			queue.quad((uint8_t)SDL_rand(4), texture, blends[SDL_rand(3)], SDL_randf(), dst,
+				SDL_FColor{ 1.0f, 1.0f, 1.0f, 1.0f });
+		}
+		// Re-sorting the already sorted keys costs the same number of passes.
+		const double sortTime = timeIt([&] { queue.sort(); });
+		const RenderQueue::Stats& stats = queue.stats();
+		SDL_Log("%zu commands, 4 layers x 3 blends x 32 textures: sort %.3f ms, "
+			"state changes %zu recorded -> %zu sorted",
+			count, sortTime * 1e3, stats.stateChangesRecorded, stats.stateChangesSorted);
+		return 0;
+	}
+
+	int benchHandles()
+	{
+		// Steady churn: every frame destroys and respawns a slice of a
+		// fixed population, addressing victims only by handle.
+		const size_t count = 100000;
+		const size_t churn = 5000;
+		Model model(4096.0f, 4096.0f);
+		std::vector<EntityHandle> live(count);
+		for (size_t i = 0; i < count; ++i)
+			live[i] = model.spawn(SDL_randf() * model.worldWidth, SDL_randf() * model.worldHeight, 0.0f, 0.0f);
+
+		size_t stale = 0;
+		const auto frame = [&]
+			{
+				for (size_t n = 0; n < churn; ++n)
+				{
+					EntityHandle& victim = live[SDL_rand((Sint32)count)];
+					const EntityHandle old = victim;
+					model.destroy(victim);
+					victim = model.spawn(SDL_randf() * model.worldWidth, SDL_randf() * model.worldHeight, 0.0f, 0.0f);
+					stale += model.alive(old) ? 0 : 1;
+				}
+			};
+		for (int i = 0; i < 60; ++i)
+			frame();
+		const size_t capacity = model.posX.capacity();
+		stale = 0;
+		int frames = 0;
+		const double seconds = timeIt([&] { frame(); ++frames; });
+
+		size_t resolved = 0;
+		for (EntityHandle h : live)
+			resolved += model.indexOf(h) != Model::NoEntity ? 1 : 0;
+		SDL_Log("%zu entities, %zu destroy + spawn per frame: %.3f ms, %.1f ns per pair",
+			count, churn, seconds * 1e3, seconds * 1e9 / churn);
+		SDL_Log("  stale handles rejected %zu/%zu, live handles resolved %zu/%zu, columns %s",
+			stale, churn * frames, resolved, count,
+			model.posX.capacity() == capacity ? "never reallocated" : "REALLOCATED");
+		return 0;
+	}
+
+	int benchCompaction()
+	{
+		// Spawn order is random in space, which is what long churn leaves
+		// behind; compaction should bring the collision step to what a
+		// spatially ordered start gets.
+		const size_t counts[] = { 100000, 1000000 };
+		for (size_t count : counts)
+		{
+			const float side = SDL_sqrtf((float)count) * 8.0f;
+			Model model(side, side);
+			populate(model, count, 50.0f);
+			CollisionSystem& collisions = model.collisions;
+			const double before = timeIt([&] { collisions.step(model); });
+
+			Compactor& compactor = model.compactor;
+			compactor.intervalTicks = 0;
+			compactor.start();
+			Uint64 work = 0;
+			while (compactor.report().cycles == 0)
+			{
+				const Uint64 start = SDL_GetTicksNS();
+				compactor.step(model);
+				work += SDL_GetTicksNS() - start;
+				++model.tick;
+			}
+
+			const double after = timeIt([&] { collisions.step(model); });
+			SDL_Log("%zu entities: collision step %.3f ms -> %.3f ms after compaction (%.2fx)",
+				count, before * 1e3, after * 1e3, before / after);
+			SDL_Log("  %d slices of %.2f ms budget, %.1f ms total, %zu entities moved",
+				compactor.report().slices, compactor.budgetNs / 1e6, work / 1e6, compactor.report().moved);
+		}
+		return 0;
+	}
+
+	// Baseline for benchTransforms: heap nodes updated by recursion.
+	struct PointerNode
+	{
+		float localX, localY, localCos, localSin, localScale;
+		float worldX, worldY, worldCos, worldSin, worldScale;
+		size_t entity;
+		std::vector<PointerNode*> children;
+
+		void update(Model& model, const PointerNode& parent)
+		{
+			const float lx = localX * parent.worldScale;
+			const float ly = localY * parent.worldScale;
+			worldX = parent.worldX + parent.worldCos * lx - parent.worldSin * ly;
+			worldY = parent.worldY + parent.worldSin * lx + parent.worldCos * ly;
+			worldCos = parent.worldCos * localCos - parent.worldSin * localSin;
+			worldSin = parent.worldSin * localCos + parent.worldCos * localSin;
+			worldScale = parent.worldScale * localScale;
+			model.posX[entity] = worldX;
+			model.posY[entity] = worldY;
+			for (PointerNode* child : children)
+				child->update(model, *this);
+		}
+	};
+
+	int benchTransforms()
+	{
+		// Units carrying items carrying effects (fan-out 3, 2, 1), plus a
+		// few long attachment chains.
+		const size_t units = 20000;
+		const int fanOut[] = { 3, 2, 1 };
+		const size_t chains = 500;
+		const int chainDepth = 64;
+		Model model(8192.0f, 8192.0f);
+		TransformHierarchy& transforms = model.transforms;
+		std::vector<EntityHandle> roots;
+		std::vector<std::unique_ptr<PointerNode>> nodes;
+		std::vector<PointerNode*> pointerRoots;
+
+		const auto makeNode = [&](PointerNode* parent)
+			{
+				nodes.emplace_back(new PointerNode{ 4.0f, 0.0f, 0.995f, 0.0998f, 1.0f, 0, 0, 1, 0, 1, model.size() - 1, {} });
+				if (parent)
+					parent->children.push_back(nodes.back().get());
+				return nodes.back().get();
+			};
+		const auto spawnRoot = [&]
+			{
+				roots.push_back(model.spawn(SDL_randf() * model.worldWidth, SDL_randf() * model.worldHeight, 0.0f, 0.0f));
+				pointerRoots.push_back(makeNode(nullptr));
+				return roots.back();
+			};
+		const TransformHierarchy::Transform local = { 4.0f, 0.0f, 0.1f, 1.0f };
+
+		for (size_t u = 0; u < units; ++u)
+		{
+			std::vector<EntityHandle> level(1, spawnRoot());
+			std::vector<PointerNode*> pointerLevel(1, pointerRoots.back());
+			for (int fan : fanOut)
+			{
+				std::vector<EntityHandle> next;
+				std::vector<PointerNode*> pointerNext;
+				for (size_t p = 0; p < level.size(); ++p)
+					for (int c = 0; c < fan; ++c)
+					{
+						next.push_back(model.spawn(0.0f, 0.0f, 0.0f, 0.0f));
+						transforms.attach(model, next.back(), level[p], local);
+						pointerNext.push_back(makeNode(pointerLevel[p]));
+					}
+				level.swap(next);
+				pointerLevel.swap(pointerNext);
+			}
+		}
+		for (size_t c = 0; c < chains; ++c)
+		{
+			EntityHandle parent = spawnRoot();
+			PointerNode* pointerParent = pointerRoots.back();
+			for (int d = 0; d < chainDepth; ++d)
+			{
+				const EntityHandle child = model.spawn(0.0f, 0.0f, 0.0f, 0.0f);
+				transforms.attach(model, child, parent, local);
+				parent = child;
+				pointerParent = makeNode(pointerParent);
+			}
+		}
+		// Heap order in a long session is unrelated to the hierarchy.
+		for (size_t i = nodes.size(); i > 1; --i)
+			std::swap(nodes[i - 1], nodes[SDL_rand((Sint32)i)]);
+
+		transforms.propagate(model);
+		model.changes.flush();
+		SDL_Log("%zu nodes, %zu depth levels, %d threads", transforms.nodeCount(),
+			transforms.depthCount(), JobSystem::shared().threadCount());
+
+		const double fractions[] = { 1.0, 0.1, 0.01 };
+		for (double fraction : fractions)
+		{
+			const size_t movedRoots = (size_t)(roots.size() * fraction);
+			size_t recomputed = 0;
+			const double seconds = timeIt([&]
+				{
+					for (size_t r = 0; r < movedRoots; ++r)
+						model.changes.mark(Component::Transform, (uint32_t)model.indexOf(roots[r]));
+					transforms.propagate(model);
+					recomputed = transforms.lastRecomputed();
+					model.changes.flush();
+				});
+			SDL_Log("  %5.1f%% of roots moved: %.3f ms, %zu nodes recomputed",
+				fraction * 100.0, seconds * 1e3, recomputed);
+		}
+
+		const double recursive = timeIt([&]
+			{
+				for (PointerNode* root : pointerRoots)
+					for (PointerNode* child : root->children)
+						child->update(model, *root);
+			});
+		SDL_Log("  recursive pointer walk, everything: %.3f ms", recursive * 1e3);
+		return 0;
+	}
+
+	// Random tile costs 1..4 with 15% walls: well connected, but paths
+	// still have to weave.
+	void fillGrid(NavGrid& grid, int side)
+	{
+		grid.resize(side, side, 1.0f);
+		for (int y = 0; y < side; ++y)
+			for (int x = 0; x < side; ++x)
+				grid.setCost(x, y, SDL_randf() < 0.15f ? NavGrid::Blocked : (uint8_t)(1 + SDL_rand(4)));
+		grid.setCost(side / 2, side / 2, 1);
+	}
+
+	int benchPaths()
+	{
+		const int sides[] = { 256, 512, 1024, 2048 };
+		const size_t agents = 5000;
+		SDL_Log("%d threads", JobSystem::shared().threadCount());
+		for (int side : sides)
+		{
+			// Long A* searches on the big grids dominate the run time.
+			const size_t queries = side >= 1024 ? 20 : 100;
+			NavGrid grid;
+			fillGrid(grid, side);
+			FlowField field;
+			const double flow = timeIt([&] { field.build(grid, side / 2, side / 2); });
+
+			PathService service;
+			service.budgetNs = 2000000;
+			std::vector<uint32_t> tickets;
+			std::vector<int> ends;
+			for (size_t q = 0; q < queries; ++q)
+			{
+				int coords[4];
+				for (int& c : coords)
+					c = SDL_rand(side);
+				for (int k = 0; k < 4; k += 2)
+					grid.setCost(coords[k], coords[k + 1], SDL_max(grid.cost(coords[k], coords[k + 1]), (uint8_t)1));
+				ends.insert(ends.end(), coords, coords + 4);
+			}
+
+			const Uint64 start = SDL_GetTicksNS();
+			for (size_t q = 0; q < queries; ++q)
+				tickets.push_back(service.request(grid, ends[q * 4], ends[q * 4 + 1], ends[q * 4 + 2], ends[q * 4 + 3]));
+			int frames = 0;
+			size_t found = 0;
+			std::vector<uint32_t> path;
+			for (uint32_t ticket : tickets)
+			{
+				PathService::Status status;
+				while ((status = service.poll(ticket, path)) == PathService::Status::Pending)
+				{
+					service.update(grid);
+					++frames;
+				}
+				found += status == PathService::Status::Found ? 1 : 0;
+			}
+			const double astar = (double)(SDL_GetTicksNS() - start) / 1e9 / queries;
+
+			const Uint64 cachedStart = SDL_GetTicksNS();
+			for (size_t q = 0; q < queries; ++q)
+				service.poll(service.request(grid, ends[q * 4], ends[q * 4 + 1], ends[q * 4 + 2], ends[q * 4 + 3]), path);
+			const double hit = (double)(SDL_GetTicksNS() - cachedStart) / 1e9 / queries;
+
+			SDL_Log("%dx%d: flow field %.2f ms; A* %.3f ms per path (%zu/%zu found, %d frames of %.0f ms), "
+				"cached %.2f us",
+				side, side, flow * 1e3, astar * 1e3, found, queries, frames, service.budgetNs / 1e6, hit * 1e6);
+			SDL_Log("  %zu agents to one goal: 1 flow field %.2f ms vs per-agent A* ~%.0f ms",
+				agents, flow * 1e3, astar * agents * 1e3);
+		}
+		return 0;
+	}
+
+	// Open terrain with rough patches and wall segments, closer to a game map
+	// than fillGrid's noise.
+	void fillMap(NavGrid& grid, int side)
+	{
+		grid.resize(side, side, 1.0f);
+		for (int p = 0; p < side * side / 4096; ++p)
+		{
+			const int x0 = SDL_rand(side);
+			const int y0 = SDL_rand(side);
+			const int w = 4 + SDL_rand(28);
+			const int h = 4 + SDL_rand(28);
+			const uint8_t cost = (uint8_t)(2 + SDL_rand(3));
+			for (int y = y0; y < SDL_min(y0 + h, side); ++y)
+				for (int x = x0; x < SDL_min(x0 + w, side); ++x)
+					grid.setCost(x, y, cost);
+		}
+		for (int s = 0; s < side * side / 1024; ++s)
+		{
+			const int x0 = SDL_rand(side);
+			const int y0 = SDL_rand(side);
+			const int length = 8 + SDL_rand(56);
+			const bool horizontal = SDL_rand(2) == 0;
+			for (int i = 0; i < length; ++i)
+				grid.setCost(horizontal ? x0 + i : x0, horizontal ? y0 : y0 + i, NavGrid::Blocked);
+		}
+	}
+
+	uint64_t pathCost(const NavGrid& grid, const std::vector<uint32_t>& path)
+	{
+		uint64_t cost = 0;
+		for (size_t i = 1; i < path.size(); ++i)
+		{
+			const bool diagonal = path[i] % (uint32_t)grid.width() != path[i - 1] % (uint32_t)grid.width()
+				&& path[i] / (uint32_t)grid.width() != path[i - 1] / (uint32_t)grid.width();
+			cost += grid.data()[path[i]] * (diagonal ? 14u : 10u);
+		}
+		return cost;
+	}
+
+	int benchHierarchical()
+	{
+		const int sides[] = { 1024, 2048, 4096 };
+		for (int side : sides)
+		{
+			NavGrid grid;
+			fillMap(grid, side);
+			// Long flat searches dominate the run time on the big maps.
+			const size_t flatQueries = side >= 2048 ? 5 : 20;
+			const size_t queries = 200;
+			std::vector<uint32_t> ends;
+			for (size_t q = 0; q < queries; ++q)
+			{
+				for (int k = 0; k < 2; ++k)
+				{
+					const int x = SDL_rand(side);
+					const int y = SDL_rand(side);
+					grid.setCost(x, y, SDL_max(grid.cost(x, y), (uint8_t)1));
+					ends.push_back(grid.index(x, y));
+				}
+			}
+
+			HierarchicalPaths graph;
+			graph.sync(grid);
+			const double build = graph.stats().lastSyncNs / 1e9;
+
+			PathService flat;
+			flat.budgetNs = 1000000000;
+			std::vector<uint32_t> path;
+			uint64_t flatCost = 0;
+			uint64_t coarseCost = 0;
+			const Uint64 flatStart = SDL_GetTicksNS();
+			for (size_t q = 0; q < flatQueries; ++q)
+			{
+				const uint32_t ticket = flat.request(grid, (int)(ends[q * 2] % (uint32_t)side), (int)(ends[q * 2] / (uint32_t)side),
+					(int)(ends[q * 2 + 1] % (uint32_t)side), (int)(ends[q * 2 + 1] / (uint32_t)side));
+				while (flat.poll(ticket, path) == PathService::Status::Pending)
+					flat.update(grid);
+				flatCost += pathCost(grid, path);
+			}
+			const double flatTime = (double)(SDL_GetTicksNS() - flatStart) / 1e9 / flatQueries;
+			for (size_t q = 0; q < flatQueries; ++q)
+			{
+				graph.findPath(grid, ends[q * 2], ends[q * 2 + 1], path);
+				coarseCost += pathCost(grid, path);
+			}
+
+			size_t found = 0;
+			const size_t expandedBefore = graph.stats().expanded;
+			const Uint64 routeStart = SDL_GetTicksNS();
+			for (size_t q = 0; q < queries; ++q)
+				found += graph.findWaypoints(grid, ends[q * 2], ends[q * 2 + 1], path) ? 1 : 0;
+			const double route = (double)(SDL_GetTicksNS() - routeStart) / 1e9 / queries;
+			const size_t expanded = graph.stats().expanded - expandedBefore;
+			const Uint64 refineStart = SDL_GetTicksNS();
+			for (size_t q = 0; q < queries; ++q)
+				graph.findPath(grid, ends[q * 2], ends[q * 2 + 1], path);
+			const double refined = (double)(SDL_GetTicksNS() - refineStart) / 1e9 / queries;
+
+			// A burst of map edits, as when a building goes up.
+			const size_t rebuiltBefore = graph.stats().clustersRebuilt;
+			for (int e = 0; e < 100; ++e)
+				grid.setCost(SDL_rand(side), SDL_rand(side), NavGrid::Blocked);
+			graph.sync(grid);
+			const double edit = graph.stats().lastSyncNs / 1e9;
+
+			SDL_Log("%dx%d: %zu nodes, %zu edges, built in %.0f ms", side, side, graph.nodeCount(), graph.edgeCount(), build * 1e3);
+			SDL_Log("  flat A* %.1f ms per path vs hierarchical %.3f ms route, %.3f ms refined (%zu/%zu found, "
+				"%.0f nodes expanded, cost +%.1f%%)",
+				flatTime * 1e3, route * 1e3, refined * 1e3, found, queries, (double)expanded / queries,
+				100.0 * ((double)coarseCost / (double)SDL_max(flatCost, (uint64_t)1) - 1.0));
+			SDL_Log("  100 edits: %zu of %zu clusters relinked in %.2f ms", graph.stats().clustersRebuilt - rebuiltBefore,
+				(size_t)((side + 31) / 32) * (size_t)((side + 31) / 32), edit * 1e3);
+		}
+		return 0;
+	}
+
+	int benchMixer()
+	{
+		const size_t bufferFrames = 1024;
+		const int rate = 48000;
+		AudioQueue queue;
+		Mixer mixer(queue);
+		// A second of noise per sound: mono and stereo, at the mix rate and
+		// at 44.1 kHz so those voices resample even when unpitched.
+		std::vector<float> noise((size_t)rate * 2);
+		for (float& sample : noise)
+			sample = SDL_randf() * 2.0f - 1.0f;
+		const uint32_t sounds[] = {
+			mixer.addSound(noise.data(), (size_t)rate, 1, rate),
+			mixer.addSound(noise.data(), (size_t)rate, 2, rate),
+			mixer.addSound(noise.data(), 44100, 1, 44100),
+			mixer.addSound(noise.data(), 44100, 2, 44100),
+		};
+		std::vector<float> out(bufferFrames * 2);
+		const double budget = (double)bufferFrames / rate;
+		mixer.setVoiceBudget(AudioQueue::MaxVoices);
+
+		const SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+		const char* const kinds[] = { "unpitched", "resampled" };
+		for (int kind = 0; kind < 2; ++kind)
+		{
+			queue.stopAll();
+			for (uint32_t v = 0; v < AudioQueue::MaxVoices; ++v)
+			{
+				const uint32_t sound = kind == 0 ? sounds[v % 2] : sounds[v % 4];
+				const float pitch = kind == 0 ? 1.0f : 0.5f + SDL_randf();
+				queue.play(sound, 1.0f / AudioQueue::MaxVoices, SDL_randf() * 2.0f - 1.0f, pitch, true);
+			}
+			mixer.mix(out.data(), bufferFrames);
+			SDL_Log("%u %s voices, %zu-frame buffers (%.1f ms of audio):", AudioQueue::MaxVoices, kinds[kind],
+				bufferFrames, budget * 1e3);
+			for (SimdPath path : paths)
+			{
+				if (!simdPathSupported(path))
+				{
+					SDL_Log("  %-6s unsupported on this CPU", simdPathName(path));
+					continue;
+				}
+				mixer.simd = path;
+				const double seconds = timeIt([&] { mixer.mix(out.data(), bufferFrames); });
+				SDL_Log("  %-6s %.3f ms per buffer, %.2f%% of real time", simdPathName(path), seconds * 1e3,
+					100.0 * seconds / budget);
+			}
+		}
+
+		// A busy scene: every voice at its own loudness and one of four
+		// priorities, mixed within shrinking budgets on the best path.
+		queue.stopAll();
+		for (uint32_t v = 0; v < AudioQueue::MaxVoices; ++v)
+			queue.play(sounds[v % 4], SDL_randf() / 16.0f, SDL_randf() * 2.0f - 1.0f, 0.5f + SDL_randf(), true,
+				(uint8_t)(64 * (v % 4)));
+		mixer.simd = bestSimdPath();
+		SDL_Log("%u resampled voices by budget (%s):", AudioQueue::MaxVoices, simdPathName(mixer.simd));
+		const uint32_t budgets[] = { AudioQueue::MaxVoices, 128, 64, 32 };
+		for (uint32_t voices : budgets)
+		{
+			mixer.setVoiceBudget(voices);
+			mixer.mix(out.data(), bufferFrames);
+			const double seconds = timeIt([&] { mixer.mix(out.data(), bufferFrames); });
+			const Mixer::Stats stats = mixer.stats();
+			SDL_Log("  budget %3u: %3u mixed, %3u virtual, %.3f ms per buffer, %.2f%% of real time", voices,
+				stats.voices, stats.virtualVoices, seconds * 1e3, 100.0 * seconds / budget);
+		}
+		return 0;
+	}
+
+	int benchSpatial()
+	{
+		const SpatialParams params = { 2048.0f, 2048.0f, 64.0f, 4096.0f, 2048.0f };
+		const SimdPath paths[] = { SimdPath::Scalar, SimdPath::SSE2, SimdPath::AVX2 };
+		const size_t counts[] = { 256, 4096, 65536 };
+		for (size_t count : counts)
+		{
+			std::vector<float> x(count), y(count), gain(count), left(count), right(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				x[i] = SDL_randf() * 4096.0f;
+				y[i] = SDL_randf() * 4096.0f;
+				gain[i] = SDL_randf();
+			}
+			SDL_Log("%zu emitters:", count);
+			for (SimdPath path : paths)
+			{
+				if (!simdPathSupported(path))
+					continue;
+				const double seconds = timeIt([&]
+					{
+						spatialGains(path, x.data(), y.data(), gain.data(), count, params, left.data(), right.data());
+					});
+				SDL_Log("  %-6s %8.3f us, %.2f ns per emitter", simdPathName(path), seconds * 1e6, seconds * 1e9 / count);
+			}
+		}
+
+		// The whole tick: a voice on every one of 256 moving entities,
+		// gathered, computed and published.
+		Model model(4096.0f, 4096.0f);
+		for (uint32_t i = 0; i < AudioQueue::MaxVoices * 16; ++i)
+			model.spawn(SDL_randf() * 4096.0f, SDL_randf() * 4096.0f, 0.0f, 0.0f);
+		for (uint32_t v = 0; v < AudioQueue::MaxVoices; ++v)
+			model.spatial.follow(model.audio, model, 0, model.handles[v * 16], 1.0f, 1.0f, true);
+		const double seconds = timeIt([&] { model.spatial.update(model, model.audio); });
+		SDL_Log("SpatialAudio::update, %zu entity emitters (%s): %.3f us per tick", model.spatial.emitterCount(),
+			simdPathName(model.spatial.simd), seconds * 1e6);
+		return 0;
+	}
+
+	// Visible cells of every team straight from the positions, a circle
+	// test per unit and cell: the reference the counted spans must match.
+	// Unit i belongs to team i % MaxTeams, as benchVisibility watches them.
+	void naiveVisibility(const Model& model, size_t count, float radius, const Visibility& visibility,
+		std::vector<uint64_t> (&visible)[Visibility::MaxTeams])
+	{
+		const int columns = visibility.width();
+		const int rows = visibility.height();
+		const size_t words = (size_t)rows * visibility.wordsPerRow();
+		const float toCell = 1.0f / visibility.cellSize();
+		const float reach = radius * toCell;
+		for (std::vector<uint64_t>& team : visible)
+			team.assign(words, 0);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const int ux = SDL_clamp((int)(model.posX[i] * toCell), 0, columns - 1);
+			const int uy = SDL_clamp((int)(model.posY[i] * toCell), 0, rows - 1);
+			std::vector<uint64_t>& team = visible[i % Visibility::MaxTeams];
+			for (int y = SDL_max(uy - (int)reach, 0); y <= SDL_min(uy + (int)reach, rows - 1); ++y)
+				for (int x = SDL_max(ux - (int)reach, 0); x <= SDL_min(ux + (int)reach, columns - 1); ++x)
+				{
+					const float dx = (float)(x - ux);
+					const float dy = (float)(y - uy);
+					if (dx * dx + dy * dy <= reach * reach)
+						team[(size_t)y * visibility.wordsPerRow() + (x >> 6)] |= 1ull << (x & 63);
+				}
+		}
+	}
+
+	int benchVisibility()
+	{
+		// Units drift 2.5 world units a tick (150 per second at 60 Hz), so
+		// each crosses a fog cell every few ticks.
+		const float side = 2048.0f;
+		const float radius = 48.0f;
+		const size_t counts[] = { 1000, 10000 };
+		bool matched = true;
+		for (size_t count : counts)
+		{
+			Model model(side, side);
+			for (size_t i = 0; i < count; ++i)
+			{
+				model.spawn(SDL_randf() * side, SDL_randf() * side, 0.0f, 0.0f);
+				model.visibility.watch(model, model.handles[i], (int)(i % Visibility::MaxTeams), radius);
+			}
+			Visibility& visibility = model.visibility;
+			visibility.update(model);
+			size_t ticks = 0;
+			size_t moved = 0;
+			const double incremental = timeIt([&]
+				{
+					for (size_t i = 0; i < count; ++i)
+					{
+						model.posX[i] += 2.5f;
+						if (model.posX[i] >= side)
+							model.posX[i] -= side;
+					}
+					visibility.update(model);
+					moved += visibility.stats().moved;
+					++ticks;
+				});
+			std::vector<uint64_t> naive[Visibility::MaxTeams];
+			const double full = timeIt([&] { naiveVisibility(model, count, radius, visibility, naive); });
+
+			// Random steps and the odd jump across the map, checked tick by
+			// tick from a cleared grid so explored covers every tick too.
+			visibility.resize(visibility.width(), visibility.height(), visibility.cellSize());
+			std::vector<uint64_t> explored[Visibility::MaxTeams];
+			for (std::vector<uint64_t>& team : explored)
+				team.assign((size_t)visibility.height() * visibility.wordsPerRow(), 0);
+			size_t mismatches = 0;
+			for (int tick = 0; tick < 64; ++tick)
+			{
+				for (size_t i = 0; i < count; ++i)
+				{
+					if (SDL_rand(64) == 0)
+					{
+						model.posX[i] = SDL_randf() * side;
+						model.posY[i] = SDL_randf() * side;
+						continue;
+					}
+					model.posX[i] = SDL_clamp(model.posX[i] + (SDL_randf() - 0.5f) * 16.0f, 0.0f, side - 1.0f);
+					model.posY[i] = SDL_clamp(model.posY[i] + (SDL_randf() - 0.5f) * 16.0f, 0.0f, side - 1.0f);
+				}
+				visibility.update(model);
+				naiveVisibility(model, count, radius, visibility, naive);
+				for (int team = 0; team < Visibility::MaxTeams; ++team)
+					for (size_t w = 0; w < naive[team].size(); ++w)
+					{
+						explored[team][w] |= naive[team][w];
+						if (visibility.visible(team)[w] != naive[team][w]
+							|| visibility.explored(team)[w] != explored[team][w])
+							++mismatches;
+					}
+			}
+			matched = matched && mismatches == 0;
+			SDL_Log("%zu units on %dx%d cells: incremental %.3f ms per tick (%.0f units re-applied), "
+				"naive recompute %.3f ms, %zu words differ over 64 random ticks%s", count, visibility.width(),
+				visibility.height(), incremental * 1e3, (double)moved / ticks, full * 1e3, mismatches,
+				mismatches == 0 ? "" : " (MISMATCH)");
+		}
+		return matched ? 0 : 1;
+	}
+
+	// Whole frames through View in inline mode, vsync off, with the light
+	// map at full and at reduced resolution.
+	void benchLightingOn(const char* driver)
+	{
+		SDL_Window* window = SDL_CreateWindow("lighting benchmark", 1280, 720, SDL_WINDOW_HIDDEN);
+		SDL_Renderer* renderer = window ? SDL_CreateRenderer(window, driver) : nullptr;
+		if (!renderer)
+		{
+			SDL_Log("%s: no renderer: %s", driver ? driver : "default", SDL_GetError());
+			if (window)
+				SDL_DestroyWindow(window);
+			return;
+		}
+		{
+			Model model(1280.0f, 720.0f);
+			populate(model, 1000, 0.0f);
+			View view(renderer, false, "OOP_Project_AF", "OOP_Project_AF");
+			view.resize(1280, 720);
+			view.setVSync(0);
+			const auto frame = [&]
+				{
+					view.render(model, 0.0f);
+					view.present();
+				};
+			const double unlit = timeIt(frame);
+			SDL_Log("%s: %.3f ms per frame unlit", SDL_GetRendererName(renderer), unlit * 1e3);
+
+			view.lighting.enabled = true;
+			const size_t counts[] = { 1000, 10000 };
+			const int divisors[] = { 1, 2, 4 };
+			for (size_t count : counts)
+			{
+				view.lighting.lights.resize(count);
+				for (Lighting::Light& light : view.lighting.lights)
+					light = { SDL_randf() * 1280.0f, SDL_randf() * 720.0f, 16.0f + SDL_randf() * 48.0f,
+						{ SDL_randf(), SDL_randf(), SDL_randf(), 0.5f } };
+				for (int divisor : divisors)
+				{
+					view.lighting.divisor = divisor;
+					// The sprite and the light map exist from the second frame on.
+					frame();
+					frame();
+					const double lit = timeIt(frame);
+					SDL_Log("  %5zu lights, 1/%d resolution: %.3f ms per frame, +%.3f ms for lighting", count,
+						divisor, lit * 1e3, (lit - unlit) * 1e3);
+				}
+			}
+		}
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+	}
+
+	int benchLighting()
+	{
+		if (!SDL_Init(SDL_INIT_VIDEO))
+		{
+			SDL_Log("SDL_Init failed: %s", SDL_GetError());
+			return 1;
+		}
+		// Software first, then whatever SDL picks, normally a GPU backend.
+		benchLightingOn(SDL_SOFTWARE_RENDERER);
+		benchLightingOn(nullptr);
+		SDL_Quit();
+		return 0;
+	}
+
+	struct BenchEvent
+	{
+		uint32_t id;
+		float x;
+		float y;
+	};
+
+	struct BenchSubscriber
+	{
+		double sum = 0.0;
+		size_t received = 0;
+
+		void onEvent(const BenchEvent* events, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				sum += events[i].x * events[i].y;
+			received += count;
+		}
+	};
+
+	int benchEvents()
+	{
+		const size_t subscriberCount = 4;
+		const size_t total = 1000000;
+		const size_t batches[] = { 1000000, 16384, 256 };
+		EventBus bus;
+		BenchSubscriber subscribers[subscriberCount];
+		for (BenchSubscriber& subscriber : subscribers)
+			bus.subscribe<&BenchSubscriber::onEvent>(&subscriber);
+		bus.reserve<BenchEvent>(batches[0]);
+
+		for (size_t batch : batches)
+		{
+			// One batch per frame; 1M events are spread over as many frames
+			// as the batch size needs.
+			const double seconds = timeIt([&]
+				{
+					for (size_t sent = 0; sent < total; )
+					{
+						const size_t n = SDL_min(batch, total - sent);
+						for (size_t i = 0; i < n; ++i)
+							bus.publish(BenchEvent{ (uint32_t)(sent + i), (float)i, 1.0f });
+						bus.dispatch<BenchEvent>();
+						sent += n;
+					}
+				});
+			SDL_Log("%zu events in batches of %zu, %zu subscribers: %.3f ms, %.1f M events/s published, %.1f M deliveries/s",
+				total, batch, subscriberCount, seconds * 1e3, total / seconds / 1e6,
+				total * subscriberCount / seconds / 1e6);
+		}
+		// Keeps the handler loops from being optimised away.
+		SDL_Log("checksum %g", subscribers[0].sum + subscribers[subscriberCount - 1].sum);
+		return 0;
+	}
+}
+
+int runBenchmark(const char* name)
+{
+	if (SDL_strcmp(name, "collision") == 0)
+		return benchCollision();
+	if (SDL_strcmp(name, "integrate") == 0)
+		return benchIntegrate();
+	if (SDL_strcmp(name, "particles") == 0)
+		return benchParticles();
+	if (SDL_strcmp(name, "renderqueue") == 0)
+		return benchRenderQueue();
+	if (SDL_strcmp(name, "events") == 0)
+		return benchEvents();
+	if (SDL_strcmp(name, "handles") == 0)
+		return benchHandles();
+	if (SDL_strcmp(name, "compaction") == 0)
+		return benchCompaction();
+	if (SDL_strcmp(name, "transforms") == 0)
+		return benchTransforms();
+	if (SDL_strcmp(name, "paths") == 0)
+		return benchPaths();
+	if (SDL_strcmp(name, "hpa") == 0)
+		return benchHierarchical();
+	if (SDL_strcmp(name, "mixer") == 0)
+		return benchMixer();
+	if (SDL_strcmp(name, "spatial") == 0)
+		return benchSpatial();
+	if (SDL_strcmp(name, "fog") == 0)
+		return benchVisibility();
+	if (SDL_strcmp(name, "lighting") == 0)
+		return benchLighting();
+	SDL_Log("Unknown benchmark '%s'. Available: collision, integrate, particles, renderqueue, events, handles, "
+		"compaction, transforms, paths, hpa, mixer, spatial, fog, lighting", name);
+	return 1;
+}
@@ -0,0 +1,6 @@
+#pragma once
+
+// Micro-benchmarks, run with `OOP_Project_AF --bench <name>`. All are
+// headless except "lighting", which renders into hidden windows.
+// Returns the process exit code.
+int runBenchmark(const char* name);
@@ -0,0 +1,45 @@
+#pragma once
+#include <SDL3/SDL_rect.h>
+#include <SDL3/SDL_stdinc.h>
+
+// Maps world coordinates to output pixels: the world point center is drawn
+// in the middle of the output, zoom output pixels per world unit.
+struct Camera
+{
+	static constexpr float MinZoom = 1.0f / 16.0f;
+	static constexpr float MaxZoom = 4.0f;
+
+	float centerX = 0.0f;
+	float centerY = 0.0f;
+	float zoom = 1.0f;
+	int width = 0;	// output size in pixels
+	int height = 0;
+
+	// Where world (0, 0) lands on the output.
+	SDL_FPoint origin() const
+	{
+		return { width * 0.5f - centerX * zoom, height * 0.5f - centerY * zoom };
+	}
+
+	SDL_FPoint toWorld(float x, float y) const
+	{
+		const SDL_FPoint o = origin();
+		return { (x - o.x) / zoom, (y - o.y) / zoom };
+	}
+
+	// True when world units are output pixels, e.g. for incremental redraws.
+	bool identity() const
+	{
+		const SDL_FPoint o = origin();
+		return zoom == 1.0f && o.x == 0.0f && o.y == 0.0f;
+	}
+
+	// Scales by factor, keeping the world point under output (x, y) in place.
+	void zoomAt(float factor, float x, float y)
+	{
+		const SDL_FPoint anchor = toWorld(x, y);
+		zoom = SDL_clamp(zoom * factor, MinZoom, MaxZoom);
+		centerX = anchor.x - (x - width * 0.5f) / zoom;
+		centerY = anchor.y - (y - height * 0.5f) / zoom;
+	}
+};
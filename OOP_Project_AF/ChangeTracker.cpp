@@ -0,0 +1,75 @@
+#include "ChangeTracker.h"
+#include <algorithm>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace
+{
+	int lowestBit(uint64_t word)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward64(&index, word);
+		return (int)index;
+#else
+		return __builtin_ctzll(word);
+#endif
+	}
+}
+
+ChangeTracker::ChangeTracker()
+	: layoutPending(true), layout(false)
+{
+}
+
+void ChangeTracker::resize(size_t entities)
+{
+	const size_t wordCount = (entities + 63) / 64;
+	for (std::vector<uint64_t>& set : bits)
+	{
+		set.resize(wordCount, 0);
+		// After a shrink the last word may still mark entities past the end.
+		if (entities & 63)
+			set[wordCount - 1] &= ~0ull >> (64 - (entities & 63));
+	}
+}
+
+void ChangeTracker::flush()
+{
+	for (size_t c = 0; c < ComponentCount; ++c)
+	{
+		std::vector<uint64_t>& set = bits[c];
+		std::vector<uint32_t>& list = lists[c];
+		list.clear();
+		for (size_t w = 0; w < set.size(); ++w)
+		{
+			uint64_t word = set[w];
+			set[w] = 0;
+			while (word)
+			{
+				list.push_back((uint32_t)(w * 64 + lowestBit(word)));
+				word &= word - 1;
+			}
+		}
+	}
+	layout = layoutPending;
+	layoutPending = false;
+}
+
+void ObserverList::add(ModelObserver* observer)
+{
+	if (std::find(observers.begin(), observers.end(), observer) == observers.end())
+		observers.push_back(observer);
+}
+
+void ObserverList::remove(ModelObserver* observer)
+{
+	observers.erase(std::remove(observers.begin(), observers.end(), observer), observers.end());
+}
+
+void ObserverList::notify(const Model& model, const ChangeTracker& changes) const
+{
+	for (ModelObserver* observer : observers)
+		observer->onModelChanged(model, changes);
+}
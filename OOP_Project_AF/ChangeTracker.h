@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Entity components whose changes are tracked separately.
+enum class Component : uint8_t { Transform, Velocity, Shape, Count };
+
+// Per-component dirty bitsets over entity indices. Writers set bits (a whole
+// 64-entity word at a time where they can); once per tick flush() turns the
+// bits into sorted, duplicate-free index lists that stay readable until the
+// next flush.
+class ChangeTracker
+{
+public:
+	ChangeTracker();
+
+	void resize(size_t entities);
+
+	void mark(Component c, uint32_t entity)
+	{
+		bits[(size_t)c][entity >> 6] |= 1ull << (entity & 63);
+	}
+	// Raw words for bulk marking; word w covers entities [64w, 64w + 64).
+	uint64_t* words(Component c) { return bits[(size_t)c].data(); }
+
+	// Entities were added, removed or reordered: per-entity lists from before
+	// are meaningless and observers should resynchronise completely.
+	void markLayout() { layoutPending = true; }
+
+	void flush();
+
+	const std::vector<uint32_t>& changed(Component c) const { return lists[(size_t)c]; }
+	bool layoutChanged() const { return layout; }
+
+private:
+	static const size_t ComponentCount = (size_t)Component::Count;
+
+	std::vector<uint64_t> bits[ComponentCount];
+	std::vector<uint32_t> lists[ComponentCount];
+	bool layoutPending;
+	bool layout;
+};
+
+// Receives one batched notification per Model tick, never per field write.
+class ModelObserver
+{
+public:
+	virtual ~ModelObserver() {}
+	virtual void onModelChanged(const Model& model, const ChangeTracker& changes) = 0;
+};
+
+// Observer registrations belong to a Model object, not to its state: copies
+// start empty and assignment (including std::swap) leaves them in place, so
+// a snapshot or a swapped-in save never steals or duplicates observers.
+class ObserverList
+{
+public:
+	ObserverList() {}
+	ObserverList(const ObserverList&) {}
+	ObserverList& operator=(const ObserverList&) { return *this; }
+
+	void add(ModelObserver* observer);
+	void remove(ModelObserver* observer);
+	void notify(const Model& model, const ChangeTracker& changes) const;
+
+private:
+	std::vector<ModelObserver*> observers;
+};
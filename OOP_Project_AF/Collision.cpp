@@ -0,0 +1,294 @@
+#include "Collision.h"
+#include "Model.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <cmath>
+
+namespace
+{
+	// Caps the grid at a few cells per entity so sparse worlds stay cheap.
+	const size_t MaxCellsPerEntity = 4;
+
+	bool overlaps(float ax, float ay, float ar, float bx, float by, float br)
+	{
+		const float dx = bx - ax;
+		const float dy = by - ay;
+		const float rs = ar + br;
+		if (std::fabs(dx) >= rs || std::fabs(dy) >= rs)
+			return false;
+		return dx * dx + dy * dy < rs * rs;
+	}
+
+	size_t testScalar(const float* x, const float* y, const float* r,
+		const uint32_t* a, const uint32_t* b, size_t begin, size_t n, uint32_t* hits, size_t count)
+	{
+		for (size_t i = begin; i < n; ++i)
+		{
+			if (overlaps(x[a[i]], y[a[i]], r[a[i]], x[b[i]], y[b[i]], r[b[i]]))
+				hits[count++] = (uint32_t)i;
+		}
+		return count;
+	}
+
+#ifdef SDL_SSE2_INTRINSICS
+	SDL_TARGETING("sse2") size_t testSSE2(const float* x, const float* y, const float* r,
+		const uint32_t* a, const uint32_t* b, size_t n, uint32_t* hits)
+	{
+		const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+		size_t count = 0;
+		size_t i = 0;
+		for (; i + 4 <= n; i += 4)
+		{
+			const uint32_t* ia = a + i;
+			const uint32_t* ib = b + i;
+			const __m128 ax = _mm_set_ps(x[ia[3]], x[ia[2]], x[ia[1]], x[ia[0]]);
+			const __m128 ay = _mm_set_ps(y[ia[3]], y[ia[2]], y[ia[1]], y[ia[0]]);
+			const __m128 ar = _mm_set_ps(r[ia[3]], r[ia[2]], r[ia[1]], r[ia[0]]);
+			const __m128 bx = _mm_set_ps(x[ib[3]], x[ib[2]], x[ib[1]], x[ib[0]]);
+			const __m128 by = _mm_set_ps(y[ib[3]], y[ib[2]], y[ib[1]], y[ib[0]]);
+			const __m128 br = _mm_set_ps(r[ib[3]], r[ib[2]], r[ib[1]], r[ib[0]]);
+
+			const __m128 dx = _mm_sub_ps(bx, ax);
+			const __m128 dy = _mm_sub_ps(by, ay);
+			const __m128 rs = _mm_add_ps(ar, br);
+			const __m128 box = _mm_and_ps(
+				_mm_cmplt_ps(_mm_and_ps(dx, absMask), rs),
+				_mm_cmplt_ps(_mm_and_ps(dy, absMask), rs));
+			const __m128 circle = _mm_cmplt_ps(
+				_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(rs, rs));
+			const int mask = _mm_movemask_ps(_mm_and_ps(box, circle));
+
+			// Branchless compaction: always write, only advance on a hit.
+			for (int k = 0; k < 4; ++k)
+			{
+				hits[count] = (uint32_t)(i + k);
+				count += (mask >> k) & 1;
+			}
+		}
+		return testScalar(x, y, r, a, b, i, n, hits, count);
+	}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+	SDL_TARGETING("avx2") size_t testAVX2(const float* x, const float* y, const float* r,
+		const uint32_t* a, const uint32_t* b, size_t n, uint32_t* hits)
+	{
+		const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+		size_t count = 0;
+		size_t i = 0;
+		for (; i + 8 <= n; i += 8)
+		{
+			const __m256i ia = _mm256_loadu_si256((const __m256i*)(a + i));
+			const __m256i ib = _mm256_loadu_si256((const __m256i*)(b + i));
+			const __m256 ax = _mm256_i32gather_ps(x, ia, 4);
+			const __m256 ay = _mm256_i32gather_ps(y, ia, 4);
+			const __m256 ar = _mm256_i32gather_ps(r, ia, 4);
+			const __m256 bx = _mm256_i32gather_ps(x, ib, 4);
+			const __m256 by = _mm256_i32gather_ps(y, ib, 4);
+			const __m256 br = _mm256_i32gather_ps(r, ib, 4);
+
+			const __m256 dx = _mm256_sub_ps(bx, ax);
+			const __m256 dy = _mm256_sub_ps(by, ay);
+			const __m256 rs = _mm256_add_ps(ar, br);
+			const __m256 box = _mm256_and_ps(
+				_mm256_cmp_ps(_mm256_and_ps(dx, absMask), rs, _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_and_ps(dy, absMask), rs, _CMP_LT_OQ));
+			const __m256 circle = _mm256_cmp_ps(
+				_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+				_mm256_mul_ps(rs, rs), _CMP_LT_OQ);
+			const int mask = _mm256_movemask_ps(_mm256_and_ps(box, circle));
+
+			for (int k = 0; k < 8; ++k)
+			{
+				hits[count] = (uint32_t)(i + k);
+				count += (mask >> k) & 1;
+			}
+		}
+		return testScalar(x, y, r, a, b, i, n, hits, count);
+	}
+#endif
+}
+
+CollisionSystem::CollisionSystem()
+	: simd(bestSimdPath()), stepNs(0)
+{
+}
+
+CollisionSystem::CollisionSystem(const CollisionSystem& other)
+	: simd(other.simd), stepNs(0)
+{
+}
+
+CollisionSystem& CollisionSystem::operator=(const CollisionSystem& other)
+{
+	simd = other.simd;
+	return *this;
+}
+
+size_t CollisionSystem::testPairs(SimdPath path, const float* x, const float* y, const float* r,
+	const uint32_t* a, const uint32_t* b, size_t n, uint32_t* hits)
+{
+	switch (path)
+	{
+#ifdef SDL_AVX2_INTRINSICS
+	case SimdPath::AVX2:
+		return testAVX2(x, y, r, a, b, n, hits);
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+	case SimdPath::SSE2:
+		return testSSE2(x, y, r, a, b, n, hits);
+#endif
+	default:
+		return testScalar(x, y, r, a, b, 0, n, hits, 0);
+	}
+}
+
+void CollisionSystem::step(Model& model)
+{
+	const Uint64 start = SDL_GetTicksNS();
+	broadphase(model);
+	narrowphase(model);
+	resolve(model);
+	stepNs = SDL_GetTicksNS() - start;
+}
+
+void CollisionSystem::broadphase(const Model& model)
+{
+	pairA.clear();
+	pairB.clear();
+	const size_t n = model.size();
+	if (n < 2)
+		return;
+
+	float maxRadius = 0.0f;
+	for (size_t i = 0; i < n; ++i)
+		maxRadius = SDL_max(maxRadius, model.radius[i]);
+
+	// Cells at least one diameter wide: overlapping circles are then always
+	// in the same or an adjacent cell.
+	float cell = SDL_max(2.0f * maxRadius, 1.0f);
+	size_t gridW = (size_t)(model.worldWidth / cell) + 1;
+	size_t gridH = (size_t)(model.worldHeight / cell) + 1;
+	while (gridW * gridH > n * MaxCellsPerEntity && gridW > 1 && gridH > 1)
+	{
+		cell *= 2.0f;
+		gridW = (size_t)(model.worldWidth / cell) + 1;
+		gridH = (size_t)(model.worldHeight / cell) + 1;
+	}
+	const float inv = 1.0f / cell;
+	const size_t cells = gridW * gridH;
+
+	// Counting sort of entities into cells: no per-cell containers.
+	cellOf.resize(n);
+	cellStart.assign(cells + 1, 0);
+	for (size_t i = 0; i < n; ++i)
+	{
+		const size_t cx = (size_t)SDL_clamp(model.posX[i] * inv, 0.0f, (float)(gridW - 1));
+		const size_t cy = (size_t)SDL_clamp(model.posY[i] * inv, 0.0f, (float)(gridH - 1));
+		cellOf[i] = (uint32_t)(cy * gridW + cx);
+		++cellStart[cellOf[i] + 1];
+	}
+	for (size_t c = 0; c < cells; ++c)
+		cellStart[c + 1] += cellStart[c];
+	sorted.resize(n);
+	cellCursor.assign(cellStart.begin(), cellStart.end() - 1);
+	for (size_t i = 0; i < n; ++i)
+		sorted[cellCursor[cellOf[i]]++] = (uint32_t)i;
+
+	// Each cell pairs with itself and a half neighbourhood (E, SW, S, SE),
+	// which visits every adjacent cell pair exactly once.
+	for (size_t cy = 0; cy < gridH; ++cy)
+	{
+		for (size_t cx = 0; cx < gridW; ++cx)
+		{
+			const size_t c = cy * gridW + cx;
+			const uint32_t begin = cellStart[c];
+			const uint32_t end = cellStart[c + 1];
+			if (begin == end)
+				continue;
+
+			for (uint32_t i = begin; i < end; ++i)
+			{
+				for (uint32_t j = i + 1; j < end; ++j)
+				{
+					pairA.push_back(sorted[i]);
+					pairB.push_back(sorted[j]);
+				}
+			}
+
+			size_t neighbours[4];
+			int count = 0;
+			if (cx + 1 < gridW)
+				neighbours[count++] = c + 1;
+			if (cy + 1 < gridH)
+			{
+				if (cx > 0)
+					neighbours[count++] = c + gridW - 1;
+				neighbours[count++] = c + gridW;
+				if (cx + 1 < gridW)
+					neighbours[count++] = c + gridW + 1;
+			}
+			for (int k = 0; k < count; ++k)
+			{
+				const uint32_t otherBegin = cellStart[neighbours[k]];
+				const uint32_t otherEnd = cellStart[neighbours[k] + 1];
+				for (uint32_t i = begin; i < end; ++i)
+				{
+					for (uint32_t j = otherBegin; j < otherEnd; ++j)
+					{
+						pairA.push_back(sorted[i]);
+						pairB.push_back(sorted[j]);
+					}
+				}
+			}
+		}
+	}
+}
+
+void CollisionSystem::narrowphase(const Model& model)
+{
+	contacts.resize(pairA.size());
+	const size_t hits = testPairs(simd, model.posX.data(), model.posY.data(), model.radius.data(),
+		pairA.data(), pairB.data(), pairA.size(), contacts.data());
+	contacts.resize(hits);
+}
+
+void CollisionSystem::resolve(Model& model)
+{
+	for (uint32_t pair : contacts)
+	{
+		const uint32_t a = pairA[pair];
+		const uint32_t b = pairB[pair];
+		float dx = model.posX[b] - model.posX[a];
+		float dy = model.posY[b] - model.posY[a];
+		const float dist = std::sqrt(dx * dx + dy * dy);
+		float nx = 1.0f;
+		float ny = 0.0f;
+		if (dist > 1e-6f)
+		{
+			nx = dx / dist;
+			ny = dy / dist;
+		}
+
+		// Split the penetration evenly between both entities.
+		const float push = 0.5f * (model.radius[a] + model.radius[b] - dist);
+		model.posX[a] -= nx * push;
+		model.posY[a] -= ny * push;
+		model.posX[b] += nx * push;
+		model.posY[b] += ny * push;
+		model.changes.mark(Component::Transform, a);
+		model.changes.mark(Component::Transform, b);
+
+		// Equal masses: exchange the normal velocity components if approaching.
+		const float vn = (model.velX[b] - model.velX[a]) * nx + (model.velY[b] - model.velY[a]) * ny;
+		if (vn < 0.0f)
+		{
+			model.velX[a] += vn * nx;
+			model.velY[a] += vn * ny;
+			model.velX[b] -= vn * nx;
+			model.velY[b] -= vn * ny;
+			model.changes.mark(Component::Velocity, a);
+			model.changes.mark(Component::Velocity, b);
+		}
+	}
+}
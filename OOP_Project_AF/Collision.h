@@ -0,0 +1,55 @@
+#pragma once
+#include "Simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Three-stage collision pipeline for circle-shaped entities:
+//   broadphase  - uniform grid, counting-sorted, emits candidate pairs
+//   narrowphase - AABB + circle test in batches of 4 (SSE2) or 8 (AVX2)
+//   resolve     - positional separation and elastic velocity exchange
+class CollisionSystem
+{
+public:
+	CollisionSystem();
+
+	// Scratch buffers are rebuilt every tick, so copies (e.g. the save
+	// snapshot) start empty instead of duplicating them.
+	CollisionSystem(const CollisionSystem& other);
+	CollisionSystem& operator=(const CollisionSystem& other);
+	CollisionSystem(CollisionSystem&&) = default;
+	CollisionSystem& operator=(CollisionSystem&&) = default;
+
+	void step(Model& model);
+
+	void broadphase(const Model& model);
+	void narrowphase(const Model& model);
+	void resolve(Model& model);
+
+	void setPath(SimdPath path) { simd = simdPathSupported(path) ? path : SimdPath::Scalar; }
+	SimdPath path() const { return simd; }
+
+	// Wall time of the last step(), all three stages.
+	uint64_t lastStepNs() const { return stepNs; }
+	size_t candidateCount() const { return pairA.size(); }
+	size_t contactCount() const { return contacts.size(); }
+
+	// Tests pairs (a[i], b[i]) for overlap and writes the indices i that hit
+	// into hits, which must hold n entries. Returns the number of hits.
+	static size_t testPairs(SimdPath path, const float* x, const float* y, const float* r,
+		const uint32_t* a, const uint32_t* b, size_t n, uint32_t* hits);
+
+private:
+	SimdPath simd;
+	uint64_t stepNs;
+
+	std::vector<uint32_t> cellOf;
+	std::vector<uint32_t> cellStart;
+	std::vector<uint32_t> cellCursor;
+	std::vector<uint32_t> sorted;
+	std::vector<uint32_t> pairA;
+	std::vector<uint32_t> pairB;
+	std::vector<uint32_t> contacts;
+};
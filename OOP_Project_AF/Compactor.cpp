@@ -0,0 +1,218 @@
+#include "Compactor.h"
+#include "Model.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+
+namespace
+{
+	// Work between deadline checks.
+	const size_t Chunk = 2048;
+
+	// Keys are 33 bits: archetype above a 32-bit Morton code. Three 11-bit
+	// LSD passes cover them.
+	const int DigitBits = 11;
+	const uint32_t Digits = 1u << DigitBits;
+	const int Passes = 3;
+
+	// Ticks to let the smoothed collision time adapt before reporting.
+	const uint64_t SettleTicks = 60;
+	const float Smoothing = 0.1f;
+
+	uint32_t spreadBits(uint32_t v)
+	{
+		v &= 0xffff;
+		v = (v | (v << 8)) & 0x00ff00ff;
+		v = (v | (v << 4)) & 0x0f0f0f0f;
+		v = (v | (v << 2)) & 0x33333333;
+		v = (v | (v << 1)) & 0x55555555;
+		return v;
+	}
+
+	uint32_t quantize(float v, float extent)
+	{
+		const float t = extent > 0.0f ? SDL_clamp(v / extent, 0.0f, 1.0f) : 0.0f;
+		return (uint32_t)(t * 65535.0f);
+	}
+}
+
+Compactor::Compactor()
+	: intervalTicks(600), budgetNs(500000), phase(Phase::Idle), requested(false),
+	  nextCycle(0), settleUntil(0), collisionMs(0.0f), count(0), cursor(0), pass(0),
+	  placed(0), moved(0), slices(0), beforeMs(0.0f), last()
+{
+}
+
+Compactor::Compactor(const Compactor& other)
+	: Compactor()
+{
+	intervalTicks = other.intervalTicks;
+	budgetNs = other.budgetNs;
+}
+
+Compactor& Compactor::operator=(const Compactor& other)
+{
+	intervalTicks = other.intervalTicks;
+	budgetNs = other.budgetNs;
+	phase = Phase::Idle;
+	return *this;
+}
+
+void Compactor::reset()
+{
+	phase = Phase::Idle;
+	nextCycle = 0;
+	settleUntil = 0;
+}
+
+void Compactor::step(Model& model)
+{
+	const float sample = (float)model.collisions.lastStepNs() / 1e6f;
+	collisionMs = collisionMs > 0.0f ? collisionMs + (sample - collisionMs) * Smoothing : sample;
+
+	if (phase == Phase::Idle)
+	{
+		if (nextCycle == 0)
+			nextCycle = model.tick + intervalTicks;
+		if (!requested && (intervalTicks == 0 || model.tick < nextCycle))
+			return;
+		begin(model);
+	}
+
+	if (phase == Phase::Settle)
+	{
+		if (model.tick < settleUntil)
+			return;
+		last.cycles++;
+		last.moved = moved;
+		last.slices = slices;
+		last.beforeMs = beforeMs;
+		last.afterMs = collisionMs;
+		SDL_Log("Compaction: moved %zu of %zu entities in %d slices, collision step %.3f -> %.3f ms",
+			moved, count, slices, beforeMs, collisionMs);
+		phase = Phase::Idle;
+		nextCycle = model.tick + intervalTicks;
+		return;
+	}
+
+	const Uint64 deadline = SDL_GetTicksNS() + budgetNs;
+	++slices;
+	do
+	{
+		switch (phase)
+		{
+		case Phase::Keys: gatherKeys(model); break;
+		case Phase::Histogram: histogramChunk(); break;
+		case Phase::Scatter: scatterChunk(); break;
+		case Phase::Apply: applyChunk(model); break;
+		default: break;
+		}
+	} while (phase != Phase::Settle && SDL_GetTicksNS() < deadline);
+
+	if (phase == Phase::Settle)
+		settleUntil = model.tick + SettleTicks;
+}
+
+void Compactor::begin(Model& model)
+{
+	requested = false;
+	count = model.size();
+	keys.resize(count);
+	keysTmp.resize(count);
+	order.resize(count);
+	orderTmp.resize(count);
+	histogram.assign(Digits, 0);
+	cursor = 0;
+	pass = 0;
+	placed = 0;
+	moved = 0;
+	slices = 0;
+	beforeMs = collisionMs;
+	phase = Phase::Keys;
+}
+
+void Compactor::gatherKeys(const Model& model)
+{
+	// Entities destroyed since the cycle began shrink the range; duplicates
+	// or misses from swap-removal only cost some locality.
+	count = SDL_min(count, model.size());
+	const size_t end = SDL_min(cursor + Chunk, count);
+	for (size_t i = cursor; i < end; ++i)
+	{
+		const uint32_t x = quantize(model.posX[i], model.worldWidth);
+		const uint32_t y = quantize(model.posY[i], model.worldHeight);
+		const uint64_t resting = model.velX[i] == 0.0f && model.velY[i] == 0.0f;
+		keys[i] = (resting << 32) | spreadBits(x) | (spreadBits(y) << 1);
+		order[i] = model.handles[i];
+	}
+	cursor = end;
+	if (cursor == count)
+	{
+		cursor = 0;
+		phase = Phase::Histogram;
+	}
+}
+
+void Compactor::histogramChunk()
+{
+	const int shift = pass * DigitBits;
+	const size_t end = SDL_min(cursor + Chunk, count);
+	for (size_t i = cursor; i < end; ++i)
+		++histogram[(keys[i] >> shift) & (Digits - 1)];
+	cursor = end;
+	if (cursor < count)
+		return;
+
+	uint32_t sum = 0;
+	for (uint32_t& bucket : histogram)
+	{
+		const uint32_t n = bucket;
+		bucket = sum;
+		sum += n;
+	}
+	cursor = 0;
+	phase = Phase::Scatter;
+}
+
+void Compactor::scatterChunk()
+{
+	const int shift = pass * DigitBits;
+	const size_t end = SDL_min(cursor + Chunk, count);
+	for (size_t i = cursor; i < end; ++i)
+	{
+		const uint32_t j = histogram[(keys[i] >> shift) & (Digits - 1)]++;
+		keysTmp[j] = keys[i];
+		orderTmp[j] = order[i];
+	}
+	cursor = end;
+	if (cursor < count)
+		return;
+
+	keys.swap(keysTmp);
+	order.swap(orderTmp);
+	cursor = 0;
+	histogram.assign(Digits, 0);
+	phase = ++pass == Passes ? Phase::Apply : Phase::Histogram;
+}
+
+void Compactor::applyChunk(Model& model)
+{
+	const size_t end = SDL_min(cursor + Chunk, count);
+	for (size_t t = cursor; t < end && placed < model.size(); ++t)
+	{
+		// Stale handles were destroyed mid-cycle; lower indices were moved
+		// into the finished prefix by a swap-remove and stay put.
+		const size_t i = model.indexOf(order[t]);
+		if (i == Model::NoEntity || i < placed)
+			continue;
+		if (i != placed)
+		{
+			model.swapEntities(placed, i);
+			++moved;
+		}
+		++placed;
+	}
+	cursor = end;
+	if (cursor == count || placed >= model.size())
+		phase = Phase::Settle;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "EntityHandle.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Incrementally reorders Model's columns by archetype (moving before
+// resting) and then Morton order of position, so entities that are close in
+// the world are close in memory again after churn and drift. A cycle runs in
+// resumable phases - gather keys, radix sort, apply swaps - each call
+// spending at most budgetNs. Entities are moved with Model::swapEntities, so
+// handles stay valid and observers see the swaps as ordinary changes.
+class Compactor
+{
+public:
+	struct Report
+	{
+		uint64_t cycles;
+		size_t moved;		// entities moved by the last cycle
+		int slices;			// step() calls the last cycle took
+		float beforeMs;		// smoothed collision step before the cycle
+		float afterMs;		// and once the new order has settled
+	};
+
+	Compactor();
+
+	// Cycle state is scratch: copies start idle with the same settings.
+	Compactor(const Compactor& other);
+	Compactor& operator=(const Compactor& other);
+
+	// Called once per Model::update, before anything reads the columns.
+	void step(Model& model);
+	// Starts a cycle on the next step regardless of intervalTicks.
+	void start() { requested = true; }
+	bool running() const { return phase != Phase::Idle; }
+	// Drops a cycle in flight and plans the next from the model's current
+	// tick, for when the rows were replaced, e.g. by a load.
+	void reset();
+	const Report& report() const { return last; }
+
+	uint64_t intervalTicks;	// ticks between cycles, 0 = only on start()
+	uint64_t budgetNs;		// per step()
+
+private:
+	enum class Phase { Idle, Keys, Histogram, Scatter, Apply, Settle };
+
+	void begin(Model& model);
+	void gatherKeys(const Model& model);
+	void histogramChunk();
+	void scatterChunk();
+	void applyChunk(Model& model);
+
+	Phase phase;
+	bool requested;
+	uint64_t nextCycle;
+	uint64_t settleUntil;
+	float collisionMs;
+
+	size_t count;
+	size_t cursor;
+	int pass;
+	size_t placed;
+	size_t moved;
+	int slices;
+	float beforeMs;
+	Report last;
+
+	std::vector<uint64_t> keys;
+	std::vector<uint64_t> keysTmp;
+	std::vector<EntityHandle> order;
+	std::vector<EntityHandle> orderTmp;
+	std::vector<uint32_t> histogram;
+};
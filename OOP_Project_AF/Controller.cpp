@@ -0,0 +1,78 @@
+#include "Controller.h"
+#include "Events.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+
+namespace
+{
+	const char* QuickSlot = "quicksave.sav";
+	const int SpawnBurst = 100;
+	const float ZoomStep = 1.25f;	// per wheel notch
+}
+
+Controler::Controler(EventBus& bus, FramePacer& pacer, const Camera& camera)
+	: bus(bus), pacer(pacer), camera(camera)
+{
+}
+
+bool Controler::handleEvent(const SDL_Event& event)
+{
+	switch (event.type)
+	{
+	case SDL_EVENT_QUIT:
+		return false;
+	case SDL_EVENT_WINDOW_PIXEL_SIZE_CHANGED:
+		bus.publish(ViewResized{ event.window.data1, event.window.data2 });
+		break;
+	case SDL_EVENT_WINDOW_EXPOSED:
+		bus.publish(RedrawRequested{});
+		break;
+	case SDL_EVENT_MOUSE_BUTTON_DOWN:
+	{
+		const SDL_FPoint world = camera.toWorld(event.button.x, event.button.y);
+		if (event.button.button == SDL_BUTTON_LEFT)
+			bus.publish(SpawnRequested{ world.x, world.y, SpawnBurst });
+		if (event.button.button == SDL_BUTTON_RIGHT)
+			bus.publish(GoalRequested{ world.x, world.y });
+		break;
+	}
+	case SDL_EVENT_MOUSE_WHEEL:
+		bus.publish(ZoomRequested{ SDL_powf(ZoomStep, event.wheel.y), event.wheel.mouse_x, event.wheel.mouse_y });
+		break;
+	case SDL_EVENT_KEY_DOWN:
+		if (event.key.repeat)
+			break;
+		if (event.key.key == SDLK_ESCAPE)
+			return false;
+		if (event.key.key == SDLK_F5)
+			bus.publish(SaveRequested{ QuickSlot });
+		if (event.key.key == SDLK_F9)
+			bus.publish(LoadRequested{ QuickSlot });
+		if (event.key.key == SDLK_F3)
+		{
+			bus.publish(StatsRequested{});
+			const FramePacer::Stats pacing = pacer.stats();
+			SDL_Log("Pacing (%s): frame %.2f ms, jitter %.2f ms, work %.2f ms, input latency ~%.1f ms",
+				FramePacer::modeName(pacer.mode()), pacing.frameMs, pacing.jitterMs,
+				pacing.workMs, pacing.inputLatencyMs);
+		}
+		if (event.key.key == SDLK_F6)
+		{
+			pacer.setMode((FramePacer::Mode)(((int)pacer.mode() + 1) % 4));
+			bus.publish(VSyncChanged{ pacer.vsyncSetting() });
+			SDL_Log("Frame pacing: %s", FramePacer::modeName(pacer.mode()));
+		}
+		if (event.key.key == SDLK_F4)
+			bus.publish(IncrementalToggled{});
+		if (event.key.key == SDLK_F7)
+			bus.publish(CompactRequested{});
+		if (event.key.key == SDLK_F8)
+			bus.publish(DirtyOverlayToggled{});
+		if (event.key.key == SDLK_F2)
+			bus.publish(MinimapToggled{});
+		break;
+	default:
+		break;
+	}
+	return true;
+}
@@ -1,5 +1,21 @@
 #pragma once
+#include "Camera.h"
+#include "EventBus.h"
+#include "FramePacer.h"
+#include <SDL3/SDL_events.h>
+
+// Turns SDL input into bus events; it holds no reference to Model or View.
+// Clicks are mapped to world coordinates through the view's camera.
 class Controler
 {
+public:
+	Controler(EventBus& bus, FramePacer& pacer, const Camera& camera);
+
+	// Returns false once the application should quit.
+	bool handleEvent(const SDL_Event& event);
 
-};
\ No newline at end of file
+private:
+	EventBus& bus;
+	FramePacer& pacer;
+	const Camera& camera;
+};
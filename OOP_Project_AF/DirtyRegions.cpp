@@ -0,0 +1,119 @@
+#include "DirtyRegions.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+
+DirtyRegions::DirtyRegions(int tileSize)
+	: tileSize(tileSize), pixelWidth(0), pixelHeight(0), columns(0), rows(0), dirtyCount(0)
+{
+}
+
+void DirtyRegions::resize(int width, int height)
+{
+	pixelWidth = width;
+	pixelHeight = height;
+	columns = (width + tileSize - 1) / tileSize;
+	rows = (height + tileSize - 1) / tileSize;
+	tiles.assign((size_t)columns * rows, 0);
+	invalidateAll();
+}
+
+void DirtyRegions::invalidateAll()
+{
+	std::fill(tiles.begin(), tiles.end(), (uint8_t)1);
+	dirtyCount = tiles.size();
+}
+
+void DirtyRegions::clear()
+{
+	std::fill(tiles.begin(), tiles.end(), (uint8_t)0);
+	dirtyCount = 0;
+}
+
+bool DirtyRegions::tileRange(const SDL_FRect& rect, int& x0, int& y0, int& x1, int& y1) const
+{
+	if (rect.w <= 0.0f || rect.h <= 0.0f)
+		return false;
+	x0 = SDL_max((int)SDL_floorf(rect.x / tileSize), 0);
+	y0 = SDL_max((int)SDL_floorf(rect.y / tileSize), 0);
+	x1 = SDL_min((int)SDL_floorf((rect.x + rect.w) / tileSize), columns - 1);
+	y1 = SDL_min((int)SDL_floorf((rect.y + rect.h) / tileSize), rows - 1);
+	return x0 <= x1 && y0 <= y1;
+}
+
+void DirtyRegions::invalidate(const SDL_FRect& rect)
+{
+	int x0, y0, x1, y1;
+	if (!tileRange(rect, x0, y0, x1, y1))
+		return;
+	for (int y = y0; y <= y1; ++y)
+	{
+		uint8_t* row = &tiles[(size_t)y * columns];
+		for (int x = x0; x <= x1; ++x)
+		{
+			dirtyCount += row[x] ^ 1;
+			row[x] = 1;
+		}
+	}
+}
+
+bool DirtyRegions::intersects(const SDL_FRect& rect) const
+{
+	int x0, y0, x1, y1;
+	if (dirtyCount == 0 || !tileRange(rect, x0, y0, x1, y1))
+		return false;
+	for (int y = y0; y <= y1; ++y)
+	{
+		const uint8_t* row = &tiles[(size_t)y * columns];
+		for (int x = x0; x <= x1; ++x)
+		{
+			if (row[x])
+				return true;
+		}
+	}
+	return false;
+}
+
+void DirtyRegions::collect(std::vector<SDL_Rect>& out)
+{
+	out.clear();
+	open.clear();
+	for (int y = 0; y < rows; ++y)
+	{
+		const uint8_t* row = &tiles[(size_t)y * columns];
+		stillOpen.clear();
+		for (int x = 0; x < columns;)
+		{
+			if (!row[x])
+			{
+				++x;
+				continue;
+			}
+			const int start = x;
+			while (x < columns && row[x])
+				++x;
+
+			const SDL_Rect span = { start * tileSize, y * tileSize, (x - start) * tileSize, tileSize };
+			size_t grown = out.size();
+			for (size_t i : open)
+			{
+				if (out[i].x == span.x && out[i].w == span.w)
+				{
+					out[i].h += tileSize;
+					grown = i;
+					break;
+				}
+			}
+			if (grown == out.size())
+				out.push_back(span);
+			stillOpen.push_back(grown);
+		}
+		open.swap(stillOpen);
+	}
+
+	// Clip the last row/column of tiles to the screen.
+	for (SDL_Rect& r : out)
+	{
+		r.w = SDL_min(r.w, pixelWidth - r.x);
+		r.h = SDL_min(r.h, pixelHeight - r.y);
+	}
+}
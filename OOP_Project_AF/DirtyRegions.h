@@ -0,0 +1,45 @@
+#pragma once
+#include <SDL3/SDL_rect.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Screen-space set of changed areas, kept as a coarse tile bitmap. Marking is
+// O(tiles covered); collect() merges the dirty tiles into a few rectangles.
+class DirtyRegions
+{
+public:
+	explicit DirtyRegions(int tileSize = 32);
+
+	void resize(int width, int height);
+	void invalidateAll();
+	void invalidate(const SDL_FRect& rect);
+	void clear();
+
+	bool empty() const { return dirtyCount == 0; }
+	float coverage() const { return tiles.empty() ? 0.0f : (float)dirtyCount / (float)tiles.size(); }
+	// True if any dirty tile lies under rect.
+	bool intersects(const SDL_FRect& rect) const;
+
+	// Horizontal runs of dirty tiles, merged downwards while they line up.
+	void collect(std::vector<SDL_Rect>& out);
+
+	int width() const { return pixelWidth; }
+	int height() const { return pixelHeight; }
+
+private:
+	bool tileRange(const SDL_FRect& rect, int& x0, int& y0, int& x1, int& y1) const;
+
+	int tileSize;
+	int pixelWidth;
+	int pixelHeight;
+	int columns;
+	int rows;
+	std::vector<uint8_t> tiles;
+	size_t dirtyCount;
+
+	// collect() scratch: indices of rects reaching the previous row, which
+	// are the only ones that can grow, and those reaching the current one.
+	std::vector<size_t> open;
+	std::vector<size_t> stillOpen;
+};
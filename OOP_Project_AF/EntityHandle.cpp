@@ -0,0 +1,91 @@
+#include "EntityHandle.h"
+
+HandlePool::HandlePool()
+	: freeHead(NoSlot), freeTail(NoSlot)
+{
+}
+
+void HandlePool::pushFree(uint32_t slot)
+{
+	slots[slot].nextFree = NoSlot;
+	if (freeTail == NoSlot)
+		freeHead = slot;
+	else
+		slots[freeTail].nextFree = slot;
+	freeTail = slot;
+}
+
+EntityHandle HandlePool::create(uint32_t dense)
+{
+	uint32_t s;
+	if (freeHead != NoSlot)
+	{
+		s = freeHead;
+		freeHead = slots[s].nextFree;
+		if (freeHead == NoSlot)
+			freeTail = NoSlot;
+	}
+	else
+	{
+		if (slots.size() >= MaxSlots)
+			return NullEntity;
+		s = (uint32_t)slots.size();
+		slots.push_back(Slot{ 0, NoSlot, 0, false });
+	}
+
+	Slot& slot = slots[s];
+	slot.dense = dense;
+	slot.live = true;
+	return EntityHandle{ ((uint32_t)slot.generation << EntityHandle::IndexBits) | s };
+}
+
+void HandlePool::destroy(EntityHandle handle)
+{
+	const uint32_t s = handle.slot();
+	slots[s].live = false;
+	slots[s].generation = (uint16_t)((slots[s].generation + 1) & EntityHandle::GenerationMask);
+	pushFree(s);
+}
+
+void HandlePool::clear()
+{
+	freeHead = NoSlot;
+	freeTail = NoSlot;
+	for (uint32_t s = 0; s < (uint32_t)slots.size(); ++s)
+	{
+		if (slots[s].live)
+		{
+			slots[s].live = false;
+			slots[s].generation = (uint16_t)((slots[s].generation + 1) & EntityHandle::GenerationMask);
+		}
+		pushFree(s);
+	}
+}
+
+bool HandlePool::rebuild(const uint32_t* generations, size_t slotCount, const EntityHandle* handles, size_t count)
+{
+	if (slotCount > MaxSlots || count > slotCount)
+		return false;
+	slots.assign(slotCount, Slot{ 0, NoSlot, 0, false });
+	for (size_t s = 0; s < slotCount; ++s)
+	{
+		if (generations[s] > EntityHandle::GenerationMask)
+			return false;
+		slots[s].generation = (uint16_t)generations[s];
+	}
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t s = handles[i].slot();
+		if (s >= slotCount || slots[s].live || slots[s].generation != handles[i].generation())
+			return false;
+		slots[s].dense = (uint32_t)i;
+		slots[s].live = true;
+	}
+
+	freeHead = NoSlot;
+	freeTail = NoSlot;
+	for (uint32_t s = 0; s < (uint32_t)slotCount; ++s)
+		if (!slots[s].live)
+			pushFree(s);
+	return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 32-bit generational handle: low 22 bits pick a slot, high 10 bits hold the
+// slot's generation when the handle was issued. Destroying an entity bumps
+// its slot's generation, so every older handle to that slot stops resolving.
+struct EntityHandle
+{
+	static const uint32_t IndexBits = 22;
+	static const uint32_t IndexMask = (1u << IndexBits) - 1;
+	static const uint32_t GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+	uint32_t value;
+
+	uint32_t slot() const { return value & IndexMask; }
+	uint32_t generation() const { return value >> IndexBits; }
+
+	bool operator==(EntityHandle other) const { return value == other.value; }
+	bool operator!=(EntityHandle other) const { return value != other.value; }
+};
+
+// Slot IndexMask is never handed out, so this never resolves.
+const EntityHandle NullEntity = { 0xffffffffu };
+
+// Maps handles to dense column indices. Freed slots go on a FIFO free list
+// threaded through the slot table, so create and destroy are O(1) and a slot
+// is reused as late as possible, which stretches the 10-bit generation.
+// The table only grows when the free list is empty.
+class HandlePool
+{
+public:
+	static const uint32_t MaxSlots = EntityHandle::IndexMask;
+
+	HandlePool();
+
+	// NullEntity once MaxSlots entities are alive.
+	EntityHandle create(uint32_t dense);
+	// handle must be valid.
+	void destroy(EntityHandle handle);
+	// Drops every entity; all outstanding handles go stale.
+	void clear();
+
+	bool valid(EntityHandle handle) const
+	{
+		const uint32_t s = handle.slot();
+		return s < slots.size() && slots[s].live && slots[s].generation == handle.generation();
+	}
+	// handle must be valid.
+	uint32_t dense(EntityHandle handle) const { return slots[handle.slot()].dense; }
+	void relocate(EntityHandle handle, uint32_t dense) { slots[handle.slot()].dense = dense; }
+
+	// Save support: generations of every slot, and the inverse rebuild from
+	// them plus the handle of each dense entity. rebuild returns false if the
+	// data is inconsistent.
+	size_t slotCount() const { return slots.size(); }
+	uint32_t generation(size_t slot) const { return slots[slot].generation; }
+	bool rebuild(const uint32_t* generations, size_t slotCount, const EntityHandle* handles, size_t count);
+
+private:
+	static const uint32_t NoSlot = 0xffffffffu;
+
+	struct Slot
+	{
+		uint32_t dense;
+		uint32_t nextFree;
+		uint16_t generation;
+		bool live;
+	};
+
+	void pushFree(uint32_t slot);
+
+	std::vector<Slot> slots;
+	uint32_t freeHead;
+	uint32_t freeTail;
+};
@@ -0,0 +1,28 @@
+#include "EventBus.h"
+#include <algorithm>
+
+size_t EventBus::nextTypeIndex()
+{
+	static size_t next = 0;
+	return next++;
+}
+
+void EventBus::unsubscribe(void* subscriber)
+{
+	for (std::unique_ptr<ChannelBase>& channel : channels)
+	{
+		if (!channel)
+			continue;
+		std::vector<Subscriber>& list = channel->subscribers;
+		list.erase(std::remove_if(list.begin(), list.end(),
+			[subscriber](const Subscriber& s) { return s.object == subscriber; }), list.end());
+	}
+}
+
+void EventBus::dispatchAll()
+{
+	// Index loop: a handler may create a channel by publishing a new type.
+	for (size_t i = 0; i < channels.size(); ++i)
+		if (channels[i])
+			channels[i]->dispatch();
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Typed publish/subscribe between Controler, Model and View. Every event type
+// has its own contiguous queue; publish() only appends to it. Nothing is
+// delivered until a phase point calls dispatch<E>() or dispatchAll(), which
+// hands each subscriber the whole queue as one span. Handlers are plain
+// member functions bound at compile time, so there is no std::function and
+// one indirect call per subscriber per batch, not per event.
+//
+// Queues keep their capacity between frames, so once warmed up publishing
+// and dispatching never allocate. Main thread only.
+class EventBus
+{
+public:
+	EventBus() {}
+	EventBus(const EventBus&) = delete;
+	EventBus& operator=(const EventBus&) = delete;
+
+	template <typename E>
+	void publish(const E& event) { channel<E>().pending.push_back(event); }
+
+	// Handler is a member function void S::handler(const E* events, size_t count):
+	//   bus.subscribe<&View::onResized>(this);
+	template <auto Handler, typename S>
+	void subscribe(S* subscriber)
+	{
+		using E = typename HandlerTraits<decltype(Handler)>::Event;
+		channel<E>().subscribers.push_back({ subscriber, &invoke<E, S, Handler> });
+	}
+	// Drops every subscription of subscriber. Not allowed during a dispatch.
+	void unsubscribe(void* subscriber);
+
+	// Events published by handlers while their own type is being delivered
+	// wait for the next phase point.
+	template <typename E>
+	void dispatch() { channel<E>().dispatch(); }
+	void dispatchAll();
+
+	template <typename E>
+	void reserve(size_t count) { channel<E>().pending.reserve(count); }
+	template <typename E>
+	size_t pending() { return channel<E>().pending.size(); }
+
+private:
+	typedef void (*Invoke)(void* subscriber, const void* events, size_t count);
+
+	struct Subscriber
+	{
+		void* object;
+		Invoke call;
+	};
+
+	struct ChannelBase
+	{
+		virtual ~ChannelBase() {}
+		virtual void dispatch() = 0;
+		std::vector<Subscriber> subscribers;
+	};
+
+	template <typename E>
+	struct Channel : ChannelBase
+	{
+		// Swapped with pending before delivery, so handlers may publish.
+		std::vector<E> pending;
+		std::vector<E> delivering;
+
+		void dispatch() override
+		{
+			if (pending.empty())
+				return;
+			pending.swap(delivering);
+			for (size_t i = 0; i < subscribers.size(); ++i)
+				subscribers[i].call(subscribers[i].object, delivering.data(), delivering.size());
+			delivering.clear();
+		}
+	};
+
+	template <typename T>
+	struct HandlerTraits;
+	template <typename S, typename E>
+	struct HandlerTraits<void (S::*)(const E*, size_t)>
+	{
+		using Event = E;
+	};
+
+	template <typename E, typename S, void (S::*Handler)(const E*, size_t)>
+	static void invoke(void* subscriber, const void* events, size_t count)
+	{
+		(static_cast<S*>(subscriber)->*Handler)(static_cast<const E*>(events), count);
+	}
+
+	// Dense per-process index per event type, assigned on first use.
+	static size_t nextTypeIndex();
+	template <typename E>
+	static size_t typeIndex()
+	{
+		static const size_t index = nextTypeIndex();
+		return index;
+	}
+
+	template <typename E>
+	Channel<E>& channel()
+	{
+		const size_t index = typeIndex<E>();
+		if (index >= channels.size())
+			channels.resize(index + 1);
+		if (!channels[index])
+			channels[index].reset(new Channel<E>());
+		return *static_cast<Channel<E>*>(channels[index].get());
+	}
+
+	std::vector<std::unique_ptr<ChannelBase>> channels;
+};
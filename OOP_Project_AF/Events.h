@@ -0,0 +1,23 @@
+#pragma once
+
+// Events carried by EventBus. Plain copyable structs: they are stored by
+// value in per-type queues. Slot names must outlive the frame.
+
+// Controler -> View
+struct ViewResized { int width; int height; };
+struct RedrawRequested {};
+struct VSyncChanged { int vsync; };
+struct IncrementalToggled {};
+struct DirtyOverlayToggled {};
+struct MinimapToggled {};
+struct StatsRequested {};
+struct ZoomRequested { float factor; float x; float y; };	// around output pixel (x, y)
+
+// Controler -> Model
+struct SpawnRequested { float x; float y; int count; };
+struct CompactRequested {};
+struct GoalRequested { float x; float y; };
+
+// Controler -> SaveSystem
+struct SaveRequested { const char* slot; };
+struct LoadRequested { const char* slot; };
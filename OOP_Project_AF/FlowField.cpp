@@ -0,0 +1,155 @@
+#include "FlowField.h"
+#include "JobSystem.h"
+#include <SDL3/SDL_stdinc.h>
+
+namespace
+{
+	// Frontier tiles per job; small frontiers stay on the calling thread.
+	const size_t FrontierGrain = 1024;
+	const size_t RowGrain = 16;
+
+	const float Diagonal = 0.70710678f;
+}
+
+const int FlowField::OffsetX[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int FlowField::OffsetY[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+FlowField::FlowField()
+	: width(0), height(0), goalTileX(-1), goalTileY(-1), version(0), distCapacity(0)
+{
+}
+
+bool FlowField::build(const NavGrid& grid, int goalX, int goalY)
+{
+	width = grid.width();
+	height = grid.height();
+	goalTileX = goalX;
+	goalTileY = goalY;
+	version = grid.version();
+	const size_t count = grid.tileCount();
+	if (count > distCapacity)
+	{
+		dist.reset(new std::atomic<uint32_t>[count]);
+		distCapacity = count;
+	}
+	dirs.assign(count, NoDirection);
+	JobSystem& jobs = JobSystem::shared();
+	jobs.parallelFor(count, 64 * 1024, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+				dist[i].store(Unreachable, std::memory_order_relaxed);
+		});
+	if (!grid.passable(goalX, goalY))
+		return false;
+
+	for (std::vector<uint32_t>& bucket : buckets)
+		bucket.clear();
+	const uint32_t goal = grid.index(goalX, goalY);
+	dist[goal].store(0, std::memory_order_relaxed);
+	buckets[0].push_back(goal);
+	size_t queued = 1;
+
+	const uint8_t* costs = grid.data();
+	const int w = width;
+	const int h = height;
+	for (uint32_t d = 0; queued > 0; ++d)
+	{
+		std::vector<uint32_t>& frontier = buckets[d % Ring];
+		if (frontier.empty())
+			continue;
+		queued -= frontier.size();
+
+		const size_t chunks = (frontier.size() + FrontierGrain - 1) / FrontierGrain;
+		if (found.size() < chunks)
+			found.resize(chunks);
+		jobs.parallelFor(frontier.size(), FrontierGrain, [&](size_t begin, size_t end)
+			{
+				std::vector<uint64_t>& out = found[begin / FrontierGrain];
+				for (size_t k = begin; k < end; ++k)
+				{
+					const uint32_t tile = frontier[k];
+					// Stale entry: the tile was reached more cheaply since.
+					if (dist[tile].load(std::memory_order_relaxed) != d)
+						continue;
+					const int x = (int)(tile % (uint32_t)w);
+					const int y = (int)(tile / (uint32_t)w);
+					for (int dir = 0; dir < 8; dir += 2)
+					{
+						const int nx = x + OffsetX[dir];
+						const int ny = y + OffsetY[dir];
+						if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+							continue;
+						const uint32_t next = (uint32_t)ny * (uint32_t)w + (uint32_t)nx;
+						if (costs[next] == NavGrid::Blocked)
+							continue;
+						const uint32_t nd = d + costs[next];
+						uint32_t current = dist[next].load(std::memory_order_relaxed);
+						while (nd < current && !dist[next].compare_exchange_weak(current, nd, std::memory_order_relaxed))
+						{
+						}
+						if (nd < current)
+							out.push_back(((uint64_t)nd << 32) | next);
+					}
+				}
+			});
+
+		frontier.clear();
+		for (size_t c = 0; c < chunks; ++c)
+		{
+			for (uint64_t entry : found[c])
+				buckets[(entry >> 32) % Ring].push_back((uint32_t)entry);
+			queued += found[c].size();
+			found[c].clear();
+		}
+	}
+
+	// Downhill direction over all eight neighbours; diagonals may not cut
+	// a blocked corner.
+	jobs.parallelFor((size_t)h, RowGrain, [&](size_t begin, size_t end)
+		{
+			for (int y = (int)begin; y < (int)end; ++y)
+			{
+				for (int x = 0; x < w; ++x)
+				{
+					const uint32_t tile = (uint32_t)y * (uint32_t)w + (uint32_t)x;
+					uint32_t best = dist[tile].load(std::memory_order_relaxed);
+					if (best == Unreachable)
+						continue;
+					uint8_t bestDir = NoDirection;
+					for (int dir = 0; dir < 8; ++dir)
+					{
+						const int nx = x + OffsetX[dir];
+						const int ny = y + OffsetY[dir];
+						if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+							continue;
+						if ((dir & 1) && (costs[(uint32_t)y * w + nx] == NavGrid::Blocked
+							|| costs[(uint32_t)ny * w + x] == NavGrid::Blocked))
+							continue;
+						const uint32_t nd = dist[(uint32_t)ny * (uint32_t)w + (uint32_t)nx].load(std::memory_order_relaxed);
+						if (nd < best)
+						{
+							best = nd;
+							bestDir = (uint8_t)dir;
+						}
+					}
+					dirs[tile] = bestDir;
+				}
+			}
+		});
+	return true;
+}
+
+bool FlowField::sample(const NavGrid& grid, float worldX, float worldY, float& dirX, float& dirY) const
+{
+	int x;
+	int y;
+	if (grid.width() != width || grid.height() != height || !grid.tileAt(worldX, worldY, x, y))
+		return false;
+	const uint8_t dir = dirs[grid.index(x, y)];
+	if (dir == NoDirection)
+		return false;
+	const float scale = (dir & 1) ? Diagonal : 1.0f;
+	dirX = OffsetX[dir] * scale;
+	dirY = OffsetY[dir] * scale;
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "NavGrid.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Distance-to-goal and downhill direction for every tile of a NavGrid, so
+// any number of agents heading to the same goal share one search.
+//
+// build() is Dijkstra with a ring of 256 distance buckets (edge weights are
+// tile costs, at most 255). Each bucket's frontier is relaxed in parallel on
+// the JobSystem with atomic-min distance updates; improved tiles go to
+// per-chunk lists that are merged into the ring between buckets. The
+// direction pass afterwards is parallel over rows.
+class FlowField
+{
+public:
+	static constexpr uint32_t Unreachable = 0xffffffffu;
+	// Directions 0..7 start east and turn clockwise (y points down).
+	static constexpr uint8_t NoDirection = 8;
+
+	FlowField();
+
+	// Returns false if the goal is not a passable tile.
+	bool build(const NavGrid& grid, int goalX, int goalY);
+
+	int goalX() const { return goalTileX; }
+	int goalY() const { return goalTileY; }
+	uint64_t gridVersion() const { return version; }
+
+	uint32_t distance(uint32_t tile) const { return dist[tile].load(std::memory_order_relaxed); }
+	uint8_t direction(uint32_t tile) const { return dirs[tile]; }
+
+	// Unit steering vector for a world position; false at the goal, on
+	// unreachable tiles and off the grid.
+	bool sample(const NavGrid& grid, float worldX, float worldY, float& dirX, float& dirY) const;
+
+	static const int OffsetX[8];
+	static const int OffsetY[8];
+
+private:
+	static constexpr size_t Ring = 256;
+
+	int width;
+	int height;
+	int goalTileX;
+	int goalTileY;
+	uint64_t version;
+
+	std::unique_ptr<std::atomic<uint32_t>[]> dist;
+	size_t distCapacity;
+	std::vector<uint8_t> dirs;
+	std::vector<uint32_t> buckets[Ring];
+	// (distance << 32 | tile) pairs found by each job of one bucket.
+	std::vector<std::vector<uint64_t>> found;
+};
@@ -0,0 +1,139 @@
+#include "FramePacer.h"
+#include <SDL3/SDL_render.h>
+#include <SDL3/SDL_timer.h>
+#include <cmath>
+
+namespace
+{
+	// Wake this much before the predicted deadline to absorb scheduler noise.
+	const Uint64 WakeMarginNs = 1000000;
+}
+
+FramePacer::FramePacer(Mode mode, float refreshHz)
+	: current(mode), periodNs(0), frameStartNs(0), lastFrameStartNs(0),
+	  predictedWorkNs(0), lastSubmitNs(0), measuring(false), intervals(), work(), samples(0), cursor(0)
+{
+	setRefreshRate(refreshHz);
+}
+
+void FramePacer::setRefreshRate(float hz)
+{
+	if (hz <= 0.0f)
+		hz = 60.0f;
+	periodNs = (Uint64)(1e9 / hz);
+}
+
+int FramePacer::vsyncSetting() const
+{
+	switch (current)
+	{
+	case Mode::Adaptive: return SDL_RENDERER_VSYNC_ADAPTIVE;
+	case Mode::Uncapped: return SDL_RENDERER_VSYNC_DISABLED;
+	default: return 1;
+	}
+}
+
+void FramePacer::beginFrame(Uint64 lastPresentNs, Uint64 submitNs)
+{
+	lastSubmitNs = submitNs;
+	if (current == Mode::LowLatency && lastPresentNs != 0)
+	{
+		// The next vblank follows the last completed present by whole periods.
+		// Start just early enough that work plus submission still makes it.
+		Uint64 now = SDL_GetTicksNS();
+		Uint64 deadline = lastPresentNs + periodNs;
+		while (deadline < now)
+			deadline += periodNs;
+		const Uint64 budget = predictedWorkNs + submitNs + WakeMarginNs;
+		if (deadline > now + budget)
+			SDL_DelayPrecise(deadline - budget - now);
+	}
+
+	frameStartNs = SDL_GetTicksNS();
+	measuring = lastFrameStartNs != 0;
+	if (measuring)
+		intervals[cursor] = (double)(frameStartNs - lastFrameStartNs) / 1e6;
+	lastFrameStartNs = frameStartNs;
+}
+
+void FramePacer::endFrame()
+{
+	const Uint64 elapsed = SDL_GetTicksNS() - frameStartNs;
+	predictedWorkNs = predictedWorkNs == 0 ? elapsed : (predictedWorkNs * 7 + elapsed) / 8;
+	if (!measuring)
+		return;
+	work[cursor] = (double)elapsed / 1e6;
+	cursor = (cursor + 1) % HistorySize;
+	if (samples < HistorySize)
+		++samples;
+}
+
+FramePacer::Stats FramePacer::stats() const
+{
+	Stats s = {};
+	if (samples < 2)
+		return s;
+
+	double mean = 0.0;
+	double meanWork = 0.0;
+	for (size_t i = 0; i < samples; ++i)
+	{
+		mean += intervals[i];
+		meanWork += work[i];
+	}
+	mean /= samples;
+	meanWork /= samples;
+	double variance = 0.0;
+	for (size_t i = 0; i < samples; ++i)
+		variance += (intervals[i] - mean) * (intervals[i] - mean);
+
+	s.frameMs = mean;
+	s.jitterMs = std::sqrt(variance / samples);
+	s.workMs = meanWork;
+
+	// After hand-off a frame is submitted and then waits for scan-out. With
+	// plain vsync it queues behind the previous frame for a refresh and then
+	// waits on average half a refresh for vblank; low-latency pacing finishes
+	// just before vblank instead, and uncapped frames show as soon as they are
+	// presented.
+	const double period = (double)periodNs / 1e6;
+	const double submit = (double)lastSubmitNs / 1e6;
+	switch (current)
+	{
+	case Mode::Uncapped:
+		s.inputLatencyMs = meanWork + submit;
+		break;
+	case Mode::LowLatency:
+		s.inputLatencyMs = meanWork + submit + (double)WakeMarginNs / 1e6;
+		break;
+	default:
+		s.inputLatencyMs = meanWork + submit + 1.5 * period;
+		break;
+	}
+	return s;
+}
+
+const char* FramePacer::modeName(Mode mode)
+{
+	switch (mode)
+	{
+	case Mode::VSync: return "vsync";
+	case Mode::Adaptive: return "adaptive";
+	case Mode::Uncapped: return "uncapped";
+	default: return "lowlatency";
+	}
+}
+
+bool FramePacer::parseMode(const char* name, Mode& mode)
+{
+	const Mode modes[] = { Mode::VSync, Mode::Adaptive, Mode::Uncapped, Mode::LowLatency };
+	for (Mode m : modes)
+	{
+		if (SDL_strcmp(name, modeName(m)) == 0)
+		{
+			mode = m;
+			return true;
+		}
+	}
+	return false;
+}
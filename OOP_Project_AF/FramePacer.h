@@ -0,0 +1,63 @@
+#pragma once
+#include <SDL3/SDL_stdinc.h>
+#include <cstddef>
+
+// Decides when the main loop starts a frame and which vsync setting the
+// renderer uses, and measures the result.
+//   VSync      - present waits for vblank, loop runs as fast as that allows
+//   Adaptive   - like VSync, but late frames tear instead of waiting a refresh
+//   Uncapped   - no vsync, no waiting: maximum throughput
+//   LowLatency - vsync, but the loop sleeps until just before the predicted
+//                deadline so input is sampled as late as possible
+class FramePacer
+{
+public:
+	enum class Mode { VSync, Adaptive, Uncapped, LowLatency };
+
+	struct Stats
+	{
+		double frameMs;		// mean frame interval
+		double jitterMs;	// standard deviation of the frame interval
+		double workMs;		// input sample -> frame recorded
+		double inputLatencyMs;	// estimated input sample -> scan-out
+	};
+
+	FramePacer(Mode mode, float refreshHz);
+
+	void setMode(Mode mode) { current = mode; }
+	Mode mode() const { return current; }
+	void setRefreshRate(float hz);
+
+	// Value for SDL_SetRenderVSync matching the mode.
+	int vsyncSetting() const;
+
+	// Call at the top of the loop with the render thread's timings. Sleeps in
+	// LowLatency mode; returns when input should be sampled.
+	void beginFrame(Uint64 lastPresentNs, Uint64 submitNs);
+	// Call once the frame is recorded, before it is submitted: submission
+	// time comes from beginFrame's submitNs, and an inline present's vblank
+	// wait must not count as work.
+	void endFrame();
+
+	Stats stats() const;
+
+	static const char* modeName(Mode mode);
+	static bool parseMode(const char* name, Mode& mode);
+
+private:
+	static const size_t HistorySize = 120;
+
+	Mode current;
+	Uint64 periodNs;
+
+	Uint64 frameStartNs;
+	Uint64 lastFrameStartNs;
+	Uint64 predictedWorkNs;	// exponential moving average of work + submit
+	Uint64 lastSubmitNs;
+	bool measuring;
+
+	double intervals[HistorySize];
+	double work[HistorySize];
+	size_t samples;
+	size_t cursor;
+};
@@ -0,0 +1,573 @@
+#include "HierarchicalPaths.h"
+#include "FlowField.h"
+#include "JobSystem.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	// Same step costs as PathService, so both agree on what a path costs.
+	const uint32_t Straight = 10;
+	const uint32_t Diagonal = 14;
+
+	// Entrances at least this long get a node pair at each end.
+	const int LongEntrance = 6;
+
+	// Clusters relinked per job.
+	const size_t LinkGrain = 32;
+
+	uint32_t octile(int dx, int dy)
+	{
+		dx = SDL_abs(dx);
+		dy = SDL_abs(dy);
+		return Straight * (uint32_t)SDL_max(dx, dy) + (Diagonal - Straight) * (uint32_t)SDL_min(dx, dy);
+	}
+}
+
+HierarchicalPaths::HierarchicalPaths()
+	: clusterSize(32), heuristicWeight(1.25f), built(false), version(0), size(0), gridWidth(0), gridHeight(0), clustersX(0),
+	  clustersY(0), counters(), local(), markStamp(0), searchStamp(0), startTile(0), goalTile(0),
+	  directCost(None)
+{
+}
+
+HierarchicalPaths::HierarchicalPaths(const HierarchicalPaths& other)
+	: HierarchicalPaths()
+{
+	clusterSize = other.clusterSize;
+	heuristicWeight = other.heuristicWeight;
+}
+
+HierarchicalPaths& HierarchicalPaths::operator=(const HierarchicalPaths& other)
+{
+	clusterSize = other.clusterSize;
+	heuristicWeight = other.heuristicWeight;
+	built = false;
+	return *this;
+}
+
+void HierarchicalPaths::sync(const NavGrid& grid)
+{
+	if (built && size == builtClusterSize() && version == grid.version())
+		return;
+	const Uint64 started = SDL_GetTicksNS();
+	const uint32_t* tiles = nullptr;
+	size_t count = 0;
+	if (built && size == builtClusterSize() && gridWidth == grid.width() && gridHeight == grid.height()
+		&& grid.editsSince(version, tiles, count))
+		update(grid, tiles, count);
+	else
+		rebuild(grid);
+	version = grid.version();
+	built = true;
+	counters.lastSyncNs = SDL_GetTicksNS() - started;
+}
+
+void HierarchicalPaths::rebuild(const NavGrid& grid)
+{
+	size = builtClusterSize();
+	gridWidth = grid.width();
+	gridHeight = grid.height();
+	clustersX = (gridWidth + size - 1) / size;
+	clustersY = (gridHeight + size - 1) / size;
+	const size_t count = (size_t)clustersX * (size_t)clustersY;
+	clusters.assign(count, Cluster());
+	marks.assign(count, 0);
+	markStamp = 0;
+	g.resize(count * MaxNodes + 2);
+	from.resize(count * MaxNodes + 2);
+	stamp.assign(count * MaxNodes + 2, 0);
+	searchStamp = 0;
+	linkScratch.clear();
+	local = Scratch();
+	++counters.fullBuilds;
+
+	pending.clear();
+	for (uint32_t c = 0; c < (uint32_t)count; ++c)
+	{
+		scanBorder(grid, c, East);
+		scanBorder(grid, c, South);
+		pending.push_back(c);
+	}
+	linkClusters(grid, pending.data(), pending.size());
+}
+
+void HierarchicalPaths::update(const NavGrid& grid, const uint32_t* tiles, size_t count)
+{
+	if (++markStamp == 0)
+	{
+		std::fill(marks.begin(), marks.end(), 0);
+		markStamp = 1;
+	}
+	pending.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t c = clusterOf(tiles[i]);
+		if (marks[c] != markStamp)
+		{
+			marks[c] = markStamp;
+			pending.push_back(c);
+		}
+	}
+
+	// Edited clusters rescan all four borders; a neighbour only needs
+	// relinking if the entrances on the border it shares changed.
+	const size_t edited = pending.size();
+	for (size_t i = 0; i < edited; ++i)
+	{
+		const uint32_t c = pending[i];
+		const int cx = (int)(c % (uint32_t)clustersX);
+		const int cy = (int)(c / (uint32_t)clustersX);
+		const uint32_t neighbours[4] = {
+			cy > 0 ? c - (uint32_t)clustersX : None,
+			cx + 1 < clustersX ? c + 1 : None,
+			cy + 1 < clustersY ? c + (uint32_t)clustersX : None,
+			cx > 0 ? c - 1 : None,
+		};
+		const bool changed[4] = {
+			neighbours[North] != None && scanBorder(grid, neighbours[North], South),
+			scanBorder(grid, c, East),
+			scanBorder(grid, c, South),
+			neighbours[West] != None && scanBorder(grid, neighbours[West], East),
+		};
+		for (int side = 0; side < 4; ++side)
+		{
+			const uint32_t n = neighbours[side];
+			if (changed[side] && marks[n] != markStamp)
+			{
+				marks[n] = markStamp;
+				pending.push_back(n);
+			}
+		}
+	}
+	linkClusters(grid, pending.data(), pending.size());
+}
+
+bool HierarchicalPaths::scanBorder(const NavGrid& grid, uint32_t c, Side side)
+{
+	const int cx = (int)(c % (uint32_t)clustersX);
+	const int cy = (int)(c / (uint32_t)clustersX);
+	const bool east = side == East;
+	if (east ? cx + 1 >= clustersX : cy + 1 >= clustersY)
+		return false;
+	Cluster& near = clusters[c];
+	Cluster& far = clusters[east ? c + 1 : c + (uint32_t)clustersX];
+	const Side opposite = east ? West : North;
+
+	// Walk along the border; (x, y) is the tile on this side of it.
+	const int length = east ? SDL_min(size, gridHeight - cy * size) : SDL_min(size, gridWidth - cx * size);
+	const int fixed = east ? cx * size + size - 1 : cy * size + size - 1;
+	const int first = east ? cy * size : cx * size;
+	uint32_t nearTiles[PerSide];
+	uint32_t farTiles[PerSide];
+	int found = 0;
+	int run = 0;
+	for (int i = 0; i <= length; ++i)
+	{
+		bool open = false;
+		if (i < length)
+		{
+			const int x = east ? fixed : first + i;
+			const int y = east ? first + i : fixed;
+			open = grid.passable(x, y) && grid.passable(east ? x + 1 : x, east ? y : y + 1);
+		}
+		if (open)
+		{
+			++run;
+			continue;
+		}
+		if (run == 0)
+			continue;
+		const int ends[2] = { i - run, i - 1 };
+		const int middle = i - run + run / 2;
+		const int* at = run >= LongEntrance ? ends : &middle;
+		const int n = run >= LongEntrance ? 2 : 1;
+		for (int k = 0; k < n && found < PerSide; ++k)
+		{
+			const int x = east ? fixed : first + at[k];
+			const int y = east ? first + at[k] : fixed;
+			nearTiles[found] = grid.index(x, y);
+			farTiles[found] = grid.index(east ? x + 1 : x, east ? y : y + 1);
+			++found;
+		}
+		run = 0;
+	}
+
+	uint32_t* nearSlots = near.tile + side * PerSide;
+	const bool changed = near.sideCount[side] != found
+		|| !std::equal(nearTiles, nearTiles + found, nearSlots);
+	near.sideCount[side] = (uint8_t)found;
+	far.sideCount[opposite] = (uint8_t)found;
+	std::copy(nearTiles, nearTiles + found, nearSlots);
+	std::copy(farTiles, farTiles + found, far.tile + opposite * PerSide);
+	return changed;
+}
+
+void HierarchicalPaths::linkClusters(const NavGrid& grid, const uint32_t* list, size_t count)
+{
+	const size_t chunks = (count + LinkGrain - 1) / LinkGrain;
+	if (linkScratch.size() < chunks)
+		linkScratch.resize(chunks);
+	JobSystem::shared().parallelFor(count, LinkGrain, [&](size_t begin, size_t end)
+	{
+		Scratch& scratch = linkScratch[begin / LinkGrain];
+		for (size_t i = begin; i < end; ++i)
+			linkCluster(grid, list[i], scratch);
+	});
+	counters.clustersRebuilt += count;
+}
+
+void HierarchicalPaths::linkCluster(const NavGrid& grid, uint32_t c, Scratch& scratch)
+{
+	Cluster& cluster = clusters[c];
+	cluster.edges.clear();
+	collectTargets(c, scratch);
+	for (int i = 0; i < MaxNodes; ++i)
+	{
+		cluster.firstEdge[i] = (uint16_t)cluster.edges.size();
+		if (i % PerSide >= cluster.sideCount[i / PerSide])
+			continue;
+		searchCluster(grid, c, cluster.tile[i], None, false, scratch);
+		for (int j = 0; j < MaxNodes; ++j)
+		{
+			if (j == i || j % PerSide >= cluster.sideCount[j / PerSide])
+				continue;
+			const uint32_t cost = localG(scratch, cluster.tile[j]);
+			if (cost != None)
+				cluster.edges.push_back(Edge{ (uint32_t)j, cost });
+		}
+	}
+	cluster.firstEdge[MaxNodes] = (uint16_t)cluster.edges.size();
+}
+
+void HierarchicalPaths::collectTargets(uint32_t c, Scratch& scratch) const
+{
+	const Cluster& cluster = clusters[c];
+	scratch.targets.clear();
+	for (int side = 0; side < 4; ++side)
+		scratch.targets.insert(scratch.targets.end(), cluster.tile + side * PerSide, cluster.tile + side * PerSide + cluster.sideCount[side]);
+}
+
+uint32_t HierarchicalPaths::clusterOf(uint32_t tile) const
+{
+	const int x = (int)(tile % (uint32_t)gridWidth);
+	const int y = (int)(tile / (uint32_t)gridWidth);
+	return (uint32_t)(y / size) * (uint32_t)clustersX + (uint32_t)(x / size);
+}
+
+uint32_t HierarchicalPaths::partner(uint32_t node) const
+{
+	const uint32_t c = node / MaxNodes;
+	const int side = (int)(node % MaxNodes) / PerSide;
+	const uint32_t k = node % PerSide;
+	switch (side)
+	{
+	case North: return (c - (uint32_t)clustersX) * MaxNodes + South * PerSide + k;
+	case East: return (c + 1) * MaxNodes + West * PerSide + k;
+	case South: return (c + (uint32_t)clustersX) * MaxNodes + North * PerSide + k;
+	default: return (c - 1) * MaxNodes + East * PerSide + k;
+	}
+}
+
+uint32_t HierarchicalPaths::nodeTile(uint32_t node) const
+{
+	const uint32_t slots = (uint32_t)clusters.size() * MaxNodes;
+	if (node >= slots)
+		return node == slots ? startTile : goalTile;
+	return clusters[node / MaxNodes].tile[node % MaxNodes];
+}
+
+bool HierarchicalPaths::searchCluster(const NavGrid& grid, uint32_t c, uint32_t source, uint32_t goal, bool reverse, Scratch& s) const
+{
+	const int stride = size + 2;
+	const size_t area = (size_t)stride * (size_t)stride;
+	if (s.stamp.size() != area)
+	{
+		s.cost.resize(area);
+		s.g.resize(area);
+		s.from.resize(area);
+		s.stamp.assign(area, 0);
+		s.pending.assign(area, 0);
+		s.current = 0;
+		s.window = None;
+	}
+	if (++s.current == 0)
+	{
+		std::fill(s.stamp.begin(), s.stamp.end(), 0);
+		std::fill(s.pending.begin(), s.pending.end(), 0);
+		s.current = 1;
+	}
+	// The cluster's costs inside a ring of walls, so neighbours need no
+	// bounds checks. Consecutive searches in one cluster reuse the copy.
+	if (s.window != c || s.windowVersion != grid.version())
+	{
+		s.window = c;
+		s.windowVersion = grid.version();
+		s.x0 = (int)(c % (uint32_t)clustersX) * size;
+		s.y0 = (int)(c / (uint32_t)clustersX) * size;
+		const int w = SDL_min(size, gridWidth - s.x0);
+		const int h = SDL_min(size, gridHeight - s.y0);
+		std::fill(s.cost.begin(), s.cost.end(), NavGrid::Blocked);
+		for (int y = 0; y < h; ++y)
+			std::copy(grid.data() + (size_t)(s.y0 + y) * gridWidth + s.x0, grid.data() + (size_t)(s.y0 + y) * gridWidth + s.x0 + w,
+				s.cost.begin() + (y + 1) * stride + 1);
+	}
+
+	int step[8];
+	for (int dir = 0; dir < 8; ++dir)
+		step[dir] = FlowField::OffsetY[dir] * stride + FlowField::OffsetX[dir];
+	const uint32_t goalAt = goal == None ? None : windowIndex(s, goal);
+	const int goalX = (int)(goalAt % (uint32_t)stride);
+	const int goalY = (int)(goalAt / (uint32_t)stride);
+	const auto heuristic = [&](uint32_t at)
+	{
+		return goal == None ? 0 : octile((int)(at % (uint32_t)stride) - goalX, (int)(at / (uint32_t)stride) - goalY);
+	};
+
+	size_t remaining = 0;
+	if (goal == None)
+	{
+		for (uint32_t target : s.targets)
+		{
+			const uint32_t at = windowIndex(s, target);
+			remaining += s.pending[at] != s.current ? 1 : 0;
+			s.pending[at] = s.current;
+		}
+		if (remaining == 0)
+			return true;
+	}
+
+	const uint8_t* costs = s.cost.data();
+	const uint32_t sourceAt = windowIndex(s, source);
+	s.g[sourceAt] = 0;
+	s.from[sourceAt] = sourceAt;
+	s.stamp[sourceAt] = s.current;
+	s.open.clear();
+	s.open.push_back(((uint64_t)heuristic(sourceAt) << 32) | sourceAt);
+	while (!s.open.empty())
+	{
+		std::pop_heap(s.open.begin(), s.open.end(), std::greater<uint64_t>());
+		const uint64_t top = s.open.back();
+		s.open.pop_back();
+		const uint32_t at = (uint32_t)top;
+		if ((uint32_t)(top >> 32) != s.g[at] + heuristic(at))
+			continue;
+		if (at == goalAt)
+			return true;
+		if (s.pending[at] == s.current)
+		{
+			s.pending[at] = 0;
+			if (--remaining == 0)
+				return true;
+		}
+
+		for (int dir = 0; dir < 8; ++dir)
+		{
+			const uint32_t next = (uint32_t)((int)at + step[dir]);
+			if (costs[next] == NavGrid::Blocked)
+				continue;
+			if ((dir & 1) && (costs[(int)at + FlowField::OffsetX[dir]] == NavGrid::Blocked
+				|| costs[(int)at + FlowField::OffsetY[dir] * stride] == NavGrid::Blocked))
+				continue;
+			const uint32_t ng = s.g[at] + costs[reverse ? at : next] * ((dir & 1) ? Diagonal : Straight);
+			if (s.stamp[next] == s.current && ng >= s.g[next])
+				continue;
+			s.stamp[next] = s.current;
+			s.g[next] = ng;
+			s.from[next] = at;
+			s.open.push_back(((uint64_t)(ng + heuristic(next)) << 32) | next);
+			std::push_heap(s.open.begin(), s.open.end(), std::greater<uint64_t>());
+		}
+	}
+	return goal == None;
+}
+
+uint32_t HierarchicalPaths::windowIndex(const Scratch& s, uint32_t tile) const
+{
+	const int x = (int)(tile % (uint32_t)gridWidth) - s.x0;
+	const int y = (int)(tile / (uint32_t)gridWidth) - s.y0;
+	return (uint32_t)((y + 1) * (size + 2) + x + 1);
+}
+
+uint32_t HierarchicalPaths::windowTile(const Scratch& s, uint32_t at) const
+{
+	const int x = (int)(at % (uint32_t)(size + 2)) - 1 + s.x0;
+	const int y = (int)(at / (uint32_t)(size + 2)) - 1 + s.y0;
+	return (uint32_t)y * (uint32_t)gridWidth + (uint32_t)x;
+}
+
+uint32_t HierarchicalPaths::localG(const Scratch& s, uint32_t tile) const
+{
+	const uint32_t at = windowIndex(s, tile);
+	return s.stamp[at] == s.current ? s.g[at] : None;
+}
+
+bool HierarchicalPaths::findWaypoints(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& waypoints)
+{
+	const Uint64 started = SDL_GetTicksNS();
+	const bool found = abstractSearch(grid, start, goal, waypoints);
+	counters.lastQueryNs = SDL_GetTicksNS() - started;
+	return found;
+}
+
+bool HierarchicalPaths::findPath(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& path)
+{
+	const Uint64 started = SDL_GetTicksNS();
+	path.clear();
+	bool found = abstractSearch(grid, start, goal, route);
+	if (found)
+	{
+		path.push_back(route[0]);
+		for (size_t i = 1; found && i < route.size(); ++i)
+			found = refineHop(grid, route[i - 1], route[i], path);
+		if (!found)
+			path.clear();
+	}
+	counters.lastQueryNs = SDL_GetTicksNS() - started;
+	return found;
+}
+
+bool HierarchicalPaths::refineHop(const NavGrid& grid, uint32_t from, uint32_t to, std::vector<uint32_t>& path)
+{
+	// A graph older than grid may route over tiles walled since.
+	if (grid.data()[to] == NavGrid::Blocked)
+		return false;
+	// Hops between clusters are a single step across the border.
+	const uint32_t c = clusterOf(from);
+	if (c != clusterOf(to))
+	{
+		path.push_back(to);
+		return true;
+	}
+	if (!searchCluster(grid, c, from, to, false, local))
+		return false;
+	const size_t mark = path.size();
+	const uint32_t source = windowIndex(local, from);
+	for (uint32_t at = windowIndex(local, to); at != source; at = local.from[at])
+		path.push_back(windowTile(local, at));
+	std::reverse(path.begin() + (ptrdiff_t)mark, path.end());
+	return true;
+}
+
+bool HierarchicalPaths::abstractSearch(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& waypoints)
+{
+	waypoints.clear();
+	++counters.queries;
+	if (!covers(grid) || start >= grid.tileCount() || goal >= grid.tileCount()
+		|| grid.data()[start] == NavGrid::Blocked || grid.data()[goal] == NavGrid::Blocked)
+		return false;
+	startTile = start;
+	goalTile = goal;
+	const uint32_t startCluster = clusterOf(start);
+	const uint32_t goalCluster = clusterOf(goal);
+
+	// Link start and goal to their clusters' nodes.
+	startCost.resize(MaxNodes);
+	goalCost.resize(MaxNodes);
+	collectTargets(startCluster, local);
+	if (startCluster == goalCluster)
+		local.targets.push_back(goal);
+	searchCluster(grid, startCluster, start, None, false, local);
+	directCost = startCluster == goalCluster ? localG(local, goal) : None;
+	for (int i = 0; i < MaxNodes; ++i)
+		startCost[i] = i % PerSide < clusters[startCluster].sideCount[i / PerSide] ? localG(local, clusters[startCluster].tile[i]) : None;
+	collectTargets(goalCluster, local);
+	searchCluster(grid, goalCluster, goal, None, true, local);
+	for (int i = 0; i < MaxNodes; ++i)
+		goalCost[i] = i % PerSide < clusters[goalCluster].sideCount[i / PerSide] ? localG(local, clusters[goalCluster].tile[i]) : None;
+
+	// A start or goal walled in within its cluster would otherwise flood the
+	// whole graph before failing.
+	if (directCost == None && (std::count(startCost.begin(), startCost.end(), None) == MaxNodes
+		|| std::count(goalCost.begin(), goalCost.end(), None) == MaxNodes))
+		return false;
+
+	if (++searchStamp == 0)
+	{
+		std::fill(stamp.begin(), stamp.end(), 0);
+		searchStamp = 1;
+	}
+	const uint32_t startNode = (uint32_t)clusters.size() * MaxNodes;
+	const uint32_t goalNode = startNode + 1;
+	const uint32_t w = (uint32_t)gridWidth;
+	const int goalX = (int)(goal % w);
+	const int goalY = (int)(goal / w);
+	const auto heuristic = [&](uint32_t node)
+	{
+		const uint32_t tile = nodeTile(node);
+		return (uint32_t)((float)octile((int)(tile % w) - goalX, (int)(tile / w) - goalY) * heuristicWeight);
+	};
+	const auto relax = [&](uint32_t node, uint32_t parent, uint32_t cost)
+	{
+		if (stamp[node] == searchStamp && cost >= g[node])
+			return;
+		stamp[node] = searchStamp;
+		g[node] = cost;
+		from[node] = parent;
+		open.push_back(((uint64_t)(cost + heuristic(node)) << 32) | node);
+		std::push_heap(open.begin(), open.end(), std::greater<uint64_t>());
+	};
+
+	open.clear();
+	relax(startNode, startNode, 0);
+	while (!open.empty())
+	{
+		std::pop_heap(open.begin(), open.end(), std::greater<uint64_t>());
+		const uint64_t top = open.back();
+		open.pop_back();
+		const uint32_t node = (uint32_t)top;
+		if ((uint32_t)(top >> 32) != g[node] + heuristic(node))
+			continue;
+		++counters.expanded;
+
+		if (node == goalNode)
+		{
+			for (uint32_t n = goalNode; n != startNode; n = from[n])
+				if (waypoints.empty() || waypoints.back() != nodeTile(n))
+					waypoints.push_back(nodeTile(n));
+			if (waypoints.back() != start)
+				waypoints.push_back(start);
+			std::reverse(waypoints.begin(), waypoints.end());
+			return true;
+		}
+		if (node == startNode)
+		{
+			for (int i = 0; i < MaxNodes; ++i)
+				if (startCost[i] != None)
+					relax(startCluster * MaxNodes + (uint32_t)i, node, startCost[i]);
+			if (directCost != None)
+				relax(goalNode, node, directCost);
+			continue;
+		}
+
+		const uint32_t c = node / MaxNodes;
+		const uint32_t slot = node % MaxNodes;
+		const Cluster& cluster = clusters[c];
+		for (uint32_t e = cluster.firstEdge[slot]; e < cluster.firstEdge[slot + 1]; ++e)
+			relax(c * MaxNodes + cluster.edges[e].to, node, g[node] + cluster.edges[e].cost);
+		const uint32_t across = partner(node);
+		relax(across, node, g[node] + grid.data()[nodeTile(across)] * Straight);
+		if (c == goalCluster && goalCost[slot] != None)
+			relax(goalNode, node, g[node] + goalCost[slot]);
+	}
+	return false;
+}
+
+size_t HierarchicalPaths::nodeCount() const
+{
+	size_t count = 0;
+	for (const Cluster& cluster : clusters)
+		for (int side = 0; side < 4; ++side)
+			count += cluster.sideCount[side];
+	return count;
+}
+
+size_t HierarchicalPaths::edgeCount() const
+{
+	size_t count = 0;
+	for (const Cluster& cluster : clusters)
+		count += cluster.edges.size();
+	return count;
+}
@@ -0,0 +1,176 @@
+#pragma once
+#include "NavGrid.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HPA* over a NavGrid, for path queries across large maps.
+//
+// The grid is cut into square clusters. Every maximal run of tiles passable
+// on both sides of a cluster border is an entrance: one node on each side of
+// its middle, or two pairs at its ends for long runs. Nodes of one cluster
+// are linked by their exact cluster-local path costs. A query links start
+// and goal to the nodes of their clusters, runs A* on this small graph and
+// refines each hop with A* confined to one cluster. Paths come out within a
+// few percent of optimal; they never cross a cluster corner diagonally.
+//
+// sync() follows the grid's edit log and rebuilds only clusters whose tiles
+// or border entrances changed. It runs on the caller's thread and a full
+// build of a 4096^2 grid takes seconds, so Model keeps its graph in a
+// NavGraph, which syncs on a worker.
+class HierarchicalPaths
+{
+public:
+	struct Stats
+	{
+		size_t fullBuilds;
+		size_t clustersRebuilt;	// intra-cluster edge sets recomputed, all syncs
+		size_t queries;
+		size_t expanded;		// abstract nodes popped, all queries
+		uint64_t lastSyncNs;
+		uint64_t lastQueryNs;
+	};
+
+	HierarchicalPaths();
+
+	// The abstraction is derived from the grid: copies start empty with the
+	// same settings and rebuild on their first sync().
+	HierarchicalPaths(const HierarchicalPaths& other);
+	HierarchicalPaths& operator=(const HierarchicalPaths& other);
+
+	// Brings the graph up to date with grid; does nothing when the grid has
+	// not changed.
+	void sync(const NavGrid& grid);
+	bool current(const NavGrid& grid) const { return built && version == grid.version(); }
+	// Built for a grid of this size, maybe from an older version of it.
+	bool covers(const NavGrid& grid) const
+	{
+		return built && gridWidth == grid.width() && gridHeight == grid.height();
+	}
+
+	// Tile path from start to goal inclusive, in the format PathService
+	// returns, refined on grid. The graph must cover grid. False if goal is
+	// unreachable; when the graph is not current, false may also mean that
+	// the route it found crosses tiles edited since.
+	bool findPath(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& path);
+	// Unrefined route: start, the entrance tiles crossed, goal.
+	bool findWaypoints(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& waypoints);
+	// Appends the tiles after from up to and including to, for consecutive
+	// waypoints from findWaypoints: one step across a cluster border or A*
+	// inside one cluster. Lets callers spread refinement over several
+	// frames. False if grid blocks the hop, which only happens when the
+	// graph is not current.
+	bool refineHop(const NavGrid& grid, uint32_t from, uint32_t to, std::vector<uint32_t>& path);
+
+	size_t nodeCount() const;
+	size_t edgeCount() const;
+	const Stats& stats() const { return counters; }
+
+	static constexpr int MinClusterSize = 4;
+
+	// Tiles per cluster side; smaller values build with MinClusterSize. A
+	// change forces a full rebuild on the next sync.
+	int clusterSize;
+	int builtClusterSize() const { return SDL_max(clusterSize, MinClusterSize); }
+	// Inflates the abstract search's heuristic: above 1 the search expands
+	// far fewer nodes for routes at most this factor (in practice a few
+	// percent) above the cheapest through the graph.
+	float heuristicWeight;
+
+private:
+	// Node slots per cluster side; entrances beyond this are dropped.
+	static constexpr int PerSide = 16;
+	static constexpr int MaxNodes = 4 * PerSide;
+	static constexpr uint32_t None = 0xffffffffu;
+	enum Side { North, East, South, West };
+
+	struct Edge
+	{
+		uint32_t to;	// node slot in the same cluster
+		uint32_t cost;
+	};
+
+	// Node slot side * PerSide + k holds the k-th entrance on that side; its
+	// partner across the border is slot k on the opposite side next door.
+	struct Cluster
+	{
+		uint8_t sideCount[4];
+		uint32_t tile[MaxNodes];
+		uint16_t firstEdge[MaxNodes + 1];
+		std::vector<Edge> edges;
+	};
+
+	// Dijkstra/A* confined to one cluster, over a copy of its costs padded
+	// by one wall tile on every side.
+	struct Scratch
+	{
+		uint32_t window = None;	// cluster held in cost
+		uint64_t windowVersion = 0;
+		int x0 = 0;
+		int y0 = 0;
+		std::vector<uint8_t> cost;
+		std::vector<uint32_t> g;
+		std::vector<uint32_t> from;
+		std::vector<uint32_t> stamp;
+		std::vector<uint32_t> pending;	// unsettled targets where == current
+		uint32_t current = 0;
+		std::vector<uint64_t> open;
+		std::vector<uint32_t> targets;	// tiles a goal-less search must settle
+	};
+
+	void rebuild(const NavGrid& grid);
+	void update(const NavGrid& grid, const uint32_t* tiles, size_t count);
+	// Entrances along the east or south border of cluster c, written to both
+	// clusters. Returns true if they changed.
+	bool scanBorder(const NavGrid& grid, uint32_t c, Side side);
+	void linkCluster(const NavGrid& grid, uint32_t c, Scratch& scratch);
+	void linkClusters(const NavGrid& grid, const uint32_t* list, size_t count);
+	// Sets scratch.targets to the node tiles of cluster c.
+	void collectTargets(uint32_t c, Scratch& scratch) const;
+
+	uint32_t clusterOf(uint32_t tile) const;
+	uint32_t partner(uint32_t node) const;
+	uint32_t nodeTile(uint32_t node) const;
+
+	// Searches from source within cluster c. With goal == None this is
+	// Dijkstra until every tile in scratch.targets is settled; otherwise A*
+	// stopping at goal. reverse makes g the cost of reaching source instead
+	// of leaving it. Results are read with localG(); false if goal was not
+	// reached.
+	bool searchCluster(const NavGrid& grid, uint32_t c, uint32_t source, uint32_t goal, bool reverse, Scratch& scratch) const;
+	uint32_t localG(const Scratch& scratch, uint32_t tile) const;
+	uint32_t windowIndex(const Scratch& scratch, uint32_t tile) const;
+	uint32_t windowTile(const Scratch& scratch, uint32_t at) const;
+	bool abstractSearch(const NavGrid& grid, uint32_t start, uint32_t goal, std::vector<uint32_t>& waypoints);
+
+	bool built;
+	uint64_t version;
+	int size;	// clusterSize the graph was built with
+	int gridWidth;
+	int gridHeight;
+	int clustersX;
+	int clustersY;
+	std::vector<Cluster> clusters;
+	Stats counters;
+
+	// Per-job scratch for linkClusters, and the query scratch.
+	std::vector<Scratch> linkScratch;
+	Scratch local;
+	std::vector<uint32_t> marks;	// clusters already listed where == markStamp
+	uint32_t markStamp;
+	std::vector<uint32_t> pending;	// clusters to relink
+	std::vector<uint32_t> route;	// waypoints of the query being refined
+
+	// Abstract A*: slots cluster * MaxNodes + i, then the start and goal.
+	std::vector<uint32_t> startCost;	// per slot of the start cluster
+	std::vector<uint32_t> goalCost;		// per slot of the goal cluster
+	std::vector<uint64_t> open;
+	std::vector<uint32_t> g;
+	std::vector<uint32_t> from;
+	std::vector<uint32_t> stamp;
+	uint32_t searchStamp;
+	uint32_t startTile;
+	uint32_t goalTile;
+	uint32_t directCost;	// start to goal within one cluster, or None
+};
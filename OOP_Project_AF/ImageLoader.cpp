@@ -0,0 +1,322 @@
+#include "ImageLoader.h"
+#include <SDL3/SDL_filesystem.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_surface.h>
+#include <SDL3/SDL_timer.h>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	const uint32_t CacheMagic = 0x43494641;	// "AFIC"
+	const uint32_t CacheVersion = 3;
+
+	// Followed by the source path (pathLength bytes, no terminator), then
+	// levelCount LevelHeaders, each followed by its pixels.
+	struct CacheHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		int64_t sourceSize;
+		int64_t sourceModified;
+		uint32_t format;
+		uint32_t levelCount;
+		uint32_t pathLength;
+		uint32_t reserved;
+	};
+
+	struct LevelHeader
+	{
+		int32_t width;
+		int32_t height;
+		int32_t pitch;
+	};
+
+	uint64_t hashPath(const std::string& path)
+	{
+		// FNV-1a. Colliding paths share a file name; the stored path tells
+		// them apart, so a collision only costs a cache miss.
+		uint64_t hash = 1469598103934665603ull;
+		for (char c : path)
+			hash = (hash ^ (uint8_t)c) * 1099511628211ull;
+		return hash;
+	}
+}
+
+ImageLoader::ImageLoader(const char* org, const char* app, SDL_PixelFormat format)
+	: target(format), quit(false), busy(0), totals()
+{
+	if (char* pref = SDL_GetPrefPath(org, app))
+	{
+		cacheDir = std::string(pref) + "imagecache/";
+		SDL_free(pref);
+		if (!SDL_CreateDirectory(cacheDir.c_str()))
+		{
+			SDL_Log("ImageLoader: no conversion cache: %s", SDL_GetError());
+			cacheDir.clear();
+		}
+	}
+	worker = std::thread(&ImageLoader::workerMain, this);
+}
+
+ImageLoader::~ImageLoader()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+void ImageLoader::load(uint32_t id, const char* path)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		jobs.push_back(Job{ id, path });
+	}
+	wake.notify_one();
+}
+
+void ImageLoader::poll(std::vector<Image>& out)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	for (Image& image : finished)
+		out.push_back(std::move(image));
+	finished.clear();
+}
+
+size_t ImageLoader::pending() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return jobs.size() + busy;
+}
+
+ImageLoader::Stats ImageLoader::stats() const
+{
+	std::lock_guard<std::mutex> guard(lock);
+	return totals;
+}
+
+void ImageLoader::workerMain()
+{
+	for (;;)
+	{
+		Job job;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this] { return quit || !jobs.empty(); });
+			if (quit)
+				return;
+			job = std::move(jobs.front());
+			jobs.pop_front();
+			busy = 1;
+		}
+		Image image = run(job);
+		std::lock_guard<std::mutex> guard(lock);
+		if (image.levels.empty())
+			++totals.failed;
+		else
+			++totals.loaded;
+		totals.cacheHits += image.cached ? 1 : 0;
+		finished.push_back(std::move(image));
+		busy = 0;
+	}
+}
+
+ImageLoader::Image ImageLoader::run(const Job& job)
+{
+	Image image;
+	image.id = job.id;
+	image.format = target;
+	image.cached = false;
+
+	SDL_PathInfo info;
+	if (!SDL_GetPathInfo(job.path.c_str(), &info))
+	{
+		SDL_Log("ImageLoader: %s: %s", job.path.c_str(), SDL_GetError());
+		return image;
+	}
+	const std::string file = cacheDir.empty() ? std::string() : cachePath(job.path);
+	if (!file.empty())
+	{
+		const Uint64 start = SDL_GetTicksNS();
+		const bool hit = readCache(file, job.path, (int64_t)info.size, (int64_t)info.modify_time, image);
+		std::lock_guard<std::mutex> guard(lock);
+		totals.cacheReadNs += SDL_GetTicksNS() - start;
+		if (hit)
+		{
+			image.cached = true;
+			return image;
+		}
+	}
+
+	Uint64 start = SDL_GetTicksNS();
+	SDL_Surface* surface = SDL_LoadBMP(job.path.c_str());
+	Uint64 decoded = SDL_GetTicksNS();
+	if (!surface)
+	{
+		SDL_Log("ImageLoader: cannot load %s: %s", job.path.c_str(), SDL_GetError());
+		return image;
+	}
+	image.levels.resize(1);
+	Level& full = image.levels[0];
+	full.width = surface->w;
+	full.height = surface->h;
+	full.pitch = surface->w * SDL_BYTESPERPIXEL(target);
+	full.pixels.resize((size_t)full.pitch * (size_t)full.height);
+	bool ok;
+	if (SDL_ISPIXELFORMAT_INDEXED(surface->format))
+	{
+		// Palettized pixels need the palette, which only surfaces carry.
+		SDL_Surface* converted = SDL_ConvertSurface(surface, target);
+		ok = converted != nullptr;
+		if (converted)
+		{
+			for (int y = 0; y < full.height; ++y)
+				std::memcpy(full.pixels.data() + (size_t)y * full.pitch,
+					(const uint8_t*)converted->pixels + (size_t)y * converted->pitch, (size_t)full.pitch);
+			SDL_DestroySurface(converted);
+		}
+	}
+	else
+		ok = SDL_ConvertPixels(surface->w, surface->h, surface->format, surface->pixels, surface->pitch,
+			target, full.pixels.data(), full.pitch);
+	SDL_DestroySurface(surface);
+	const Uint64 converted = SDL_GetTicksNS();
+	if (!ok)
+	{
+		SDL_Log("ImageLoader: cannot convert %s to %s: %s", job.path.c_str(), SDL_GetPixelFormatName(target),
+			SDL_GetError());
+		image.levels.clear();
+		return image;
+	}
+	if (!addLevels(image))
+		SDL_Log("ImageLoader: no scaled variants of %s: %s", job.path.c_str(), SDL_GetError());
+	const Uint64 scaled = SDL_GetTicksNS();
+
+	if (!file.empty())
+		writeCache(file, job.path, (int64_t)info.size, (int64_t)info.modify_time, image);
+	std::lock_guard<std::mutex> guard(lock);
+	totals.decodeNs += decoded - start;
+	totals.convertNs += converted - decoded;
+	totals.scaleNs += scaled - converted;
+	totals.cacheWriteNs += SDL_GetTicksNS() - scaled;
+	return image;
+}
+
+bool ImageLoader::addLevels(Image& image)
+{
+	// Each level is a linear halving of the one before, which at exactly half
+	// size averages 2x2 blocks; halving step by step never skips texels the
+	// way one big jump would.
+	const int bytes = SDL_BYTESPERPIXEL(target);
+	while ((int)image.levels.size() < MaxLevels)
+	{
+		Level& from = image.levels.back();
+		const int width = from.width / 2;
+		const int height = from.height / 2;
+		if (width < MinLevelSize || height < MinLevelSize)
+			return true;
+		SDL_Surface* source = SDL_CreateSurfaceFrom(from.width, from.height, target, from.pixels.data(), from.pitch);
+		SDL_Surface* half = source ? SDL_ScaleSurface(source, width, height, SDL_SCALEMODE_LINEAR) : nullptr;
+		SDL_DestroySurface(source);
+		if (!half)
+			return false;
+		Level level;
+		level.width = width;
+		level.height = height;
+		level.pitch = width * bytes;
+		level.pixels.resize((size_t)level.pitch * (size_t)height);
+		for (int y = 0; y < height; ++y)
+			std::memcpy(level.pixels.data() + (size_t)y * level.pitch,
+				(const uint8_t*)half->pixels + (size_t)y * half->pitch, (size_t)level.pitch);
+		SDL_DestroySurface(half);
+		image.levels.push_back(std::move(level));
+	}
+	return true;
+}
+
+std::string ImageLoader::cachePath(const std::string& path) const
+{
+	char name[32];
+	SDL_snprintf(name, sizeof(name), "%016llx.px", (unsigned long long)hashPath(path));
+	return cacheDir + name;
+}
+
+bool ImageLoader::readCache(const std::string& file, const std::string& path, int64_t size, int64_t modified,
+	Image& image)
+{
+	SDL_IOStream* io = SDL_IOFromFile(file.c_str(), "rb");
+	if (!io)
+		return false;
+	const Sint64 fileSize = SDL_GetIOSize(io);
+	CacheHeader header;
+	bool ok = fileSize >= 0 && SDL_ReadIO(io, &header, sizeof(header)) == sizeof(header)
+		&& header.magic == CacheMagic && header.version == CacheVersion && header.sourceSize == size
+		&& header.sourceModified == modified && header.format == (uint32_t)target && header.levelCount >= 1
+		&& header.levelCount <= MaxLevels && header.pathLength == path.size();
+	std::string stored(ok ? path.size() : 0, '\0');
+	ok = ok && SDL_ReadIO(io, &stored[0], stored.size()) == stored.size() && stored == path;
+
+	// Every size is checked against what the writer produces, and against
+	// the bytes left in the file, before it sizes an allocation.
+	const size_t bytes = (size_t)SDL_BYTESPERPIXEL(target);
+	size_t remaining = ok ? (size_t)fileSize - sizeof(header) - stored.size() : 0;
+	image.levels.resize(ok ? header.levelCount : 0);
+	for (size_t i = 0; i < image.levels.size(); ++i)
+	{
+		LevelHeader levelHeader;
+		ok = ok && SDL_ReadIO(io, &levelHeader, sizeof(levelHeader)) == sizeof(levelHeader);
+		if (ok && i == 0)
+			ok = levelHeader.width >= 1 && levelHeader.width <= MaxLevelSize && levelHeader.height >= 1
+				&& levelHeader.height <= MaxLevelSize;
+		else if (ok)
+			ok = levelHeader.width == image.levels[i - 1].width / 2 && levelHeader.height == image.levels[i - 1].height / 2
+				&& levelHeader.width >= MinLevelSize && levelHeader.height >= MinLevelSize;
+		const size_t pitch = ok ? (size_t)levelHeader.width * bytes : 0;
+		const size_t levelBytes = pitch * (size_t)(ok ? levelHeader.height : 0);
+		ok = ok && (size_t)levelHeader.pitch == pitch && remaining >= sizeof(levelHeader) + levelBytes;
+		if (!ok)
+			break;
+		remaining -= sizeof(levelHeader) + levelBytes;
+		Level& level = image.levels[i];
+		level.width = levelHeader.width;
+		level.height = levelHeader.height;
+		level.pitch = levelHeader.pitch;
+		level.pixels.resize(levelBytes);
+		ok = SDL_ReadIO(io, level.pixels.data(), levelBytes) == levelBytes;
+	}
+	if (!ok)
+		image.levels.clear();
+	SDL_CloseIO(io);
+	return ok;
+}
+
+void ImageLoader::writeCache(const std::string& file, const std::string& path, int64_t size, int64_t modified,
+	const Image& image)
+{
+	// Written aside and renamed, so a crash never leaves a torn entry.
+	const std::string temp = file + ".tmp";
+	SDL_IOStream* io = SDL_IOFromFile(temp.c_str(), "wb");
+	if (!io)
+		return;
+	const CacheHeader header = { CacheMagic, CacheVersion, size, modified, (uint32_t)target,
+		(uint32_t)image.levels.size(), (uint32_t)path.size(), 0 };
+	bool ok = SDL_WriteIO(io, &header, sizeof(header)) == sizeof(header)
+		&& SDL_WriteIO(io, path.data(), path.size()) == path.size();
+	for (const Level& level : image.levels)
+	{
+		const LevelHeader levelHeader = { level.width, level.height, level.pitch };
+		ok = ok && SDL_WriteIO(io, &levelHeader, sizeof(levelHeader)) == sizeof(levelHeader)
+			&& SDL_WriteIO(io, level.pixels.data(), level.pixels.size()) == level.pixels.size();
+	}
+	ok = SDL_CloseIO(io) && ok;
+	if (!ok || !SDL_RenamePath(temp.c_str(), file.c_str()))
+	{
+		SDL_Log("ImageLoader: cannot write %s: %s", file.c_str(), SDL_GetError());
+		SDL_RemovePath(temp.c_str());
+	}
+}
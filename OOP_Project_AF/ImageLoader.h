@@ -0,0 +1,104 @@
+#pragma once
+#include <SDL3/SDL_pixels.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Loads images on a worker thread, already converted to the one pixel
+// format textures are created in, so neither the main thread, the render
+// thread nor the driver converts anything at texture creation.
+//
+// Every image is decoded (SDL_LoadBMP) and converted with SDL_ConvertPixels
+// once, then halved repeatedly with SDL_ScaleSurface into pre-scaled
+// variants for zoomed-out views. All levels are kept in a cache directory
+// under the user's pref path, named by a hash of the source path. Each entry
+// stores the full path, the source's size and modification time and the
+// target format, and is used only if all of them match; level sizes are
+// checked before anything is allocated. Later runs read the pixels back
+// directly.
+class ImageLoader
+{
+public:
+	static constexpr int MaxLevels = 8;
+	// Halving stops before either side would go below this.
+	static constexpr int MinLevelSize = 4;
+	// Cache entries with a larger full-size level are rejected.
+	static constexpr int MaxLevelSize = 16384;
+
+	struct Level
+	{
+		int width;
+		int height;
+		int pitch;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct Image
+	{
+		uint32_t id;
+		SDL_PixelFormat format;
+		std::vector<Level> levels;	// full size first; empty if loading failed
+		bool cached;				// read from the conversion cache
+	};
+
+	struct Stats
+	{
+		uint32_t loaded;
+		uint32_t failed;
+		uint32_t cacheHits;
+		uint64_t decodeNs;		// SDL_LoadBMP
+		uint64_t convertNs;		// SDL_ConvertPixels
+		uint64_t scaleNs;		// SDL_ScaleSurface
+		uint64_t cacheReadNs;
+		uint64_t cacheWriteNs;
+	};
+
+	// Without a pref path for org/app images are still converted, just
+	// not cached.
+	ImageLoader(const char* org, const char* app, SDL_PixelFormat format);
+	~ImageLoader();
+
+	ImageLoader(const ImageLoader&) = delete;
+	ImageLoader& operator=(const ImageLoader&) = delete;
+
+	SDL_PixelFormat format() const { return target; }
+
+	// Queues path; the result comes back from poll() under id.
+	void load(uint32_t id, const char* path);
+	// Never blocks. Moves finished images to the end of out.
+	void poll(std::vector<Image>& out);
+	size_t pending() const;
+
+	Stats stats() const;
+
+private:
+	struct Job
+	{
+		uint32_t id;
+		std::string path;
+	};
+
+	void workerMain();
+	Image run(const Job& job);
+	bool addLevels(Image& image);
+	std::string cachePath(const std::string& path) const;
+	bool readCache(const std::string& file, const std::string& path, int64_t size, int64_t modified, Image& image);
+	void writeCache(const std::string& file, const std::string& path, int64_t size, int64_t modified,
+		const Image& image);
+
+	SDL_PixelFormat target;
+	std::string cacheDir;	// empty when there is no cache
+
+	std::thread worker;
+	mutable std::mutex lock;
+	std::condition_variable wake;
+	bool quit;
+	std::deque<Job> jobs;
+	std::vector<Image> finished;
+	size_t busy;
+	Stats totals;
+};
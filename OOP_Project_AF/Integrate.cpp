@@ -0,0 +1,126 @@
+#include "Integrate.h"
+
+namespace
+{
+	// ORs lane mask bits for entities i.. into reflected; a group of lanes
+	// may straddle two words when i is not aligned to the vector width.
+	inline void markLanes(uint64_t* reflected, size_t i, uint64_t lanes)
+	{
+		if (!reflected || !lanes)
+			return;
+		const size_t bit = i & 63;
+		reflected[i / 64] |= lanes << bit;
+		if (bit && (lanes >> (64 - bit)))
+			reflected[i / 64 + 1] |= lanes >> (64 - bit);
+	}
+
+	bool integrateAxisScalar(float& p, float& v, float dt, float damping, float lo, float hi)
+	{
+		v *= damping;
+		p += v * dt;
+		if (p < lo || p > hi)
+		{
+			v = -v;
+			p = p < lo ? lo : hi;
+			return true;
+		}
+		return false;
+	}
+
+	void integrateScalar(float* posX, float* posY, float* velX, float* velY,
+		size_t begin, size_t end, const MotionParams& m, uint64_t* reflected)
+	{
+		for (size_t i = begin; i < end; ++i)
+		{
+			const bool bouncedX = integrateAxisScalar(posX[i], velX[i], m.dt, m.damping, m.minX, m.maxX);
+			const bool bouncedY = integrateAxisScalar(posY[i], velY[i], m.dt, m.damping, m.minY, m.maxY);
+			markLanes(reflected, i, (uint64_t)(bouncedX || bouncedY));
+		}
+	}
+
+#ifdef SDL_SSE2_INTRINSICS
+	SDL_TARGETING("sse2") void integrateAxisSSE2(float* p, float* v, size_t begin, size_t end,
+		float dt, float damping, float lo, float hi, uint64_t* reflected)
+	{
+		const __m128 vdt = _mm_set1_ps(dt);
+		const __m128 vdamp = _mm_set1_ps(damping);
+		const __m128 vlo = _mm_set1_ps(lo);
+		const __m128 vhi = _mm_set1_ps(hi);
+		const __m128 sign = _mm_set1_ps(-0.0f);
+		for (size_t i = begin; i < end; i += 4)
+		{
+			__m128 vel = _mm_mul_ps(_mm_loadu_ps(v + i), vdamp);
+			__m128 pos = _mm_add_ps(_mm_loadu_ps(p + i), _mm_mul_ps(vel, vdt));
+			const __m128 out = _mm_or_ps(_mm_cmplt_ps(pos, vlo), _mm_cmpgt_ps(pos, vhi));
+			vel = _mm_xor_ps(vel, _mm_and_ps(out, sign));
+			pos = _mm_min_ps(_mm_max_ps(pos, vlo), vhi);
+			markLanes(reflected, i, (uint64_t)_mm_movemask_ps(out));
+			_mm_storeu_ps(v + i, vel);
+			_mm_storeu_ps(p + i, pos);
+		}
+	}
+
+	SDL_TARGETING("sse2") void integrateSSE2(float* posX, float* posY, float* velX, float* velY,
+		size_t begin, size_t end, const MotionParams& m, uint64_t* reflected)
+	{
+		const size_t vectorEnd = begin + (end - begin) / 4 * 4;
+		integrateAxisSSE2(posX, velX, begin, vectorEnd, m.dt, m.damping, m.minX, m.maxX, reflected);
+		integrateAxisSSE2(posY, velY, begin, vectorEnd, m.dt, m.damping, m.minY, m.maxY, reflected);
+		integrateScalar(posX, posY, velX, velY, vectorEnd, end, m, reflected);
+	}
+#endif
+
+#ifdef SDL_AVX2_INTRINSICS
+	SDL_TARGETING("avx2") void integrateAxisAVX2(float* p, float* v, size_t begin, size_t end,
+		float dt, float damping, float lo, float hi, uint64_t* reflected)
+	{
+		const __m256 vdt = _mm256_set1_ps(dt);
+		const __m256 vdamp = _mm256_set1_ps(damping);
+		const __m256 vlo = _mm256_set1_ps(lo);
+		const __m256 vhi = _mm256_set1_ps(hi);
+		const __m256 sign = _mm256_set1_ps(-0.0f);
+		for (size_t i = begin; i < end; i += 8)
+		{
+			__m256 vel = _mm256_mul_ps(_mm256_loadu_ps(v + i), vdamp);
+			__m256 pos = _mm256_add_ps(_mm256_loadu_ps(p + i), _mm256_mul_ps(vel, vdt));
+			const __m256 out = _mm256_or_ps(
+				_mm256_cmp_ps(pos, vlo, _CMP_LT_OQ), _mm256_cmp_ps(pos, vhi, _CMP_GT_OQ));
+			vel = _mm256_xor_ps(vel, _mm256_and_ps(out, sign));
+			pos = _mm256_min_ps(_mm256_max_ps(pos, vlo), vhi);
+			markLanes(reflected, i, (uint64_t)_mm256_movemask_ps(out));
+			_mm256_storeu_ps(v + i, vel);
+			_mm256_storeu_ps(p + i, pos);
+		}
+	}
+
+	SDL_TARGETING("avx2") void integrateAVX2(float* posX, float* posY, float* velX, float* velY,
+		size_t begin, size_t end, const MotionParams& m, uint64_t* reflected)
+	{
+		const size_t vectorEnd = begin + (end - begin) / 8 * 8;
+		integrateAxisAVX2(posX, velX, begin, vectorEnd, m.dt, m.damping, m.minX, m.maxX, reflected);
+		integrateAxisAVX2(posY, velY, begin, vectorEnd, m.dt, m.damping, m.minY, m.maxY, reflected);
+		integrateScalar(posX, posY, velX, velY, vectorEnd, end, m, reflected);
+	}
+#endif
+}
+
+void integrateMotion(SimdPath path, float* posX, float* posY, float* velX, float* velY,
+	size_t begin, size_t end, const MotionParams& params, uint64_t* reflected)
+{
+	switch (path)
+	{
+#ifdef SDL_AVX2_INTRINSICS
+	case SimdPath::AVX2:
+		integrateAVX2(posX, posY, velX, velY, begin, end, params, reflected);
+		break;
+#endif
+#ifdef SDL_SSE2_INTRINSICS
+	case SimdPath::SSE2:
+		integrateSSE2(posX, posY, velX, velY, begin, end, params, reflected);
+		break;
+#endif
+	default:
+		integrateScalar(posX, posY, velX, velY, begin, end, params, reflected);
+		break;
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include "Simd.h"
+#include <cstddef>
+#include <cstdint>
+
+struct MotionParams
+{
+	float dt;
+	float damping;	// velocity multiplier applied each step, 1 = none
+	float minX;
+	float minY;
+	float maxX;
+	float maxY;
+};
+
+// Advances entities [begin, end) of the given columns:
+//   v *= damping; p += v * dt; out-of-bounds p is clamped and v reflected.
+// Ranges are independent, so callers may split the columns across threads.
+// If reflected is given, bit i of it (64 per word) is set for every entity
+// whose velocity was reflected; threads sharing it must own whole words.
+void integrateMotion(SimdPath path, float* posX, float* posY, float* velX, float* velY,
+	size_t begin, size_t end, const MotionParams& params, uint64_t* reflected = nullptr);
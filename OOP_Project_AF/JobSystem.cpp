@@ -0,0 +1,93 @@
+#include "JobSystem.h"
+#include <SDL3/SDL_cpuinfo.h>
+
+JobSystem& JobSystem::shared()
+{
+	static JobSystem pool(SDL_GetNumLogicalCPUCores() - 1);
+	return pool;
+}
+
+JobSystem::JobSystem(int workerCount)
+	: quit(false), generation(0), batchFn(nullptr), batchContext(nullptr),
+	  batchCount(0), batchGrain(1), batchChunks(0), next(0), done(0), active(0)
+{
+	for (int i = 0; i < workerCount; ++i)
+		workers.emplace_back(&JobSystem::workerMain, this);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (std::thread& worker : workers)
+		worker.join();
+}
+
+void JobSystem::run(size_t count, size_t grain, RangeFn fn, void* context)
+{
+	const size_t chunks = (count + grain - 1) / grain;
+	{
+		// A worker that woke late may still be inside the previous batch;
+		// wait for it to leave before the shared counters are reset.
+		std::unique_lock<std::mutex> guard(lock);
+		while (active.load(std::memory_order_acquire) != 0)
+		{
+			guard.unlock();
+			std::this_thread::yield();
+			guard.lock();
+		}
+		batchFn = fn;
+		batchContext = context;
+		batchCount = count;
+		batchGrain = grain;
+		batchChunks = chunks;
+		next.store(0, std::memory_order_relaxed);
+		done.store(0, std::memory_order_relaxed);
+		++generation;
+	}
+	wake.notify_all();
+
+	drain(fn, context, count, grain, chunks);
+	while (done.load(std::memory_order_acquire) < chunks)
+		std::this_thread::yield();
+}
+
+void JobSystem::drain(RangeFn fn, void* context, size_t count, size_t grain, size_t chunks)
+{
+	for (;;)
+	{
+		const size_t chunk = next.fetch_add(1, std::memory_order_relaxed);
+		if (chunk >= chunks)
+			return;
+		const size_t begin = chunk * grain;
+		const size_t end = begin + grain < count ? begin + grain : count;
+		fn(context, begin, end);
+		done.fetch_add(1, std::memory_order_release);
+	}
+}
+
+void JobSystem::workerMain()
+{
+	uint64_t seen = 0;
+	for (;;)
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		wake.wait(guard, [&] { return quit || generation != seen; });
+		if (quit)
+			return;
+		seen = generation;
+		const RangeFn fn = batchFn;
+		void* const context = batchContext;
+		const size_t count = batchCount;
+		const size_t grain = batchGrain;
+		const size_t chunks = batchChunks;
+		active.fetch_add(1, std::memory_order_relaxed);
+		guard.unlock();
+
+		drain(fn, context, count, grain, chunks);
+		active.fetch_sub(1, std::memory_order_release);
+	}
+}
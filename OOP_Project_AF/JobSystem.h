@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed pool of worker threads for data-parallel loops. parallelFor splits
+// [0, count) into grain-sized chunks that the workers and the calling thread
+// pull from a shared counter. The callable is passed by pointer, so a call
+// never allocates. Nested or concurrent calls simply run inline.
+class JobSystem
+{
+public:
+	static JobSystem& shared();
+
+	explicit JobSystem(int workerCount);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Workers plus the calling thread.
+	int threadCount() const { return (int)workers.size() + 1; }
+
+	// fn(begin, end) is invoked once per chunk, possibly on several threads.
+	template <typename Fn>
+	void parallelFor(size_t count, size_t grain, Fn&& fn)
+	{
+		if (grain == 0)
+			grain = 1;
+		if (count <= grain || workers.empty() || !submit.try_lock())
+		{
+			if (count)
+				fn((size_t)0, count);
+			return;
+		}
+		run(count, grain, [](void* context, size_t begin, size_t end)
+			{
+				(*static_cast<typename std::remove_reference<Fn>::type*>(context))(begin, end);
+			}, &fn);
+		submit.unlock();
+	}
+
+private:
+	using RangeFn = void (*)(void*, size_t, size_t);
+
+	void run(size_t count, size_t grain, RangeFn fn, void* context);
+	void drain(RangeFn fn, void* context, size_t count, size_t grain, size_t chunks);
+	void workerMain();
+
+	std::vector<std::thread> workers;
+	std::mutex submit;
+	std::mutex lock;
+	std::condition_variable wake;
+	bool quit;
+
+	// Current batch; written under lock only while no worker is active.
+	uint64_t generation;
+	RangeFn batchFn;
+	void* batchContext;
+	size_t batchCount;
+	size_t batchGrain;
+	size_t batchChunks;
+	std::atomic<size_t> next;
+	std::atomic<size_t> done;
+	std::atomic<int> active;
+};
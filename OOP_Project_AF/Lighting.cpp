@@ -0,0 +1,94 @@
+#include "Lighting.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cstring>
+
+Lighting::Lighting(SDL_PixelFormat format)
+	: enabled(false), ambient{ 0.2f, 0.2f, 0.25f, 1.0f }, divisor(2), spriteFormat(format), spriteQueued(false),
+	  slot(0), retiring(false), mapWidth(0), mapHeight(0), covered{ 0.0f, 0.0f, 1.0f, 1.0f }, drawn(0)
+{
+	sprite.store(nullptr, std::memory_order_relaxed);
+	for (std::atomic<SDL_Texture*>& map : maps)
+		map.store(nullptr, std::memory_order_relaxed);
+}
+
+Lighting::~Lighting()
+{
+	if (SDL_Texture* texture = sprite.load(std::memory_order_acquire))
+		SDL_DestroyTexture(texture);
+	for (std::atomic<SDL_Texture*>& map : maps)
+		if (SDL_Texture* texture = map.load(std::memory_order_acquire))
+			SDL_DestroyTexture(texture);
+}
+
+SDL_Texture* Lighting::record(RenderFrame& frame, const Camera& camera)
+{
+	drawn = 0;
+	if (!enabled || camera.width <= 0 || camera.height <= 0)
+		return nullptr;
+
+	if (!spriteQueued)
+	{
+		// White, with alpha falling off as (1 - d^2)^2 to zero at the rim.
+		spriteQueued = true;
+		const SDL_PixelFormatDetails* details = SDL_GetPixelFormatDetails(spriteFormat);
+		TextureUpload upload;
+		upload.result = &sprite;
+		upload.format = spriteFormat;
+		upload.width = SpriteSize;
+		upload.height = SpriteSize;
+		upload.pitch = SpriteSize * (int)sizeof(Uint32);
+		upload.pixels.resize((size_t)upload.pitch * SpriteSize);
+		for (int y = 0; y < SpriteSize; ++y)
+			for (int x = 0; x < SpriteSize; ++x)
+			{
+				const float dx = (x + 0.5f) / (SpriteSize * 0.5f) - 1.0f;
+				const float dy = (y + 0.5f) / (SpriteSize * 0.5f) - 1.0f;
+				const float falloff = SDL_max(1.0f - (dx * dx + dy * dy), 0.0f);
+				const Uint32 pixel = SDL_MapRGBA(details, nullptr, 255, 255, 255, (Uint8)(falloff * falloff * 255.0f));
+				std::memcpy(upload.pixels.data() + (size_t)y * upload.pitch + x * sizeof(Uint32), &pixel, sizeof(pixel));
+			}
+		frame.uploads.push_back(std::move(upload));
+	}
+
+	// Called after beginFrame, so the frame that used the other slot is done.
+	if (retiring)
+	{
+		if (SDL_Texture* old = maps[slot ^ 1].exchange(nullptr, std::memory_order_acq_rel))
+			frame.releases.push_back(old);
+		retiring = false;
+	}
+	const int d = SDL_max(divisor, 1);
+	const int width = (camera.width + d - 1) / d;
+	const int height = (camera.height + d - 1) / d;
+	if (width != mapWidth || height != mapHeight)
+	{
+		// The render thread makes the new map in the other, empty slot.
+		slot ^= 1;
+		retiring = true;
+		mapWidth = width;
+		mapHeight = height;
+	}
+	covered = { 0.0f, 0.0f, (float)camera.width / (float)(width * d), (float)camera.height / (float)(height * d) };
+	frame.light.target = &maps[slot];
+	frame.light.width = width;
+	frame.light.height = height;
+	frame.light.scale = 1.0f / (float)d;
+	frame.light.ambient = ambient;
+
+	// Lights wholly outside the view cost nothing on the render thread.
+	if (SDL_Texture* texture = sprite.load(std::memory_order_acquire))
+	{
+		const SDL_FPoint min = camera.toWorld(0.0f, 0.0f);
+		const SDL_FPoint max = camera.toWorld((float)camera.width, (float)camera.height);
+		for (const Light& light : lights)
+		{
+			const float r = light.radius;
+			if (light.x + r < min.x || light.x - r > max.x || light.y + r < min.y || light.y - r > max.y)
+				continue;
+			frame.lights.quad(0, texture, SDL_BLENDMODE_ADD, 0.0f, { light.x - r, light.y - r, 2.0f * r, 2.0f * r },
+				light.color);
+			++drawn;
+		}
+	}
+	return maps[slot].load(std::memory_order_acquire);
+}
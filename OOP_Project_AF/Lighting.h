@@ -0,0 +1,73 @@
+#pragma once
+#include "Camera.h"
+#include "RenderThread.h"
+#include <SDL3/SDL_pixels.h>
+#include <SDL3/SDL_render.h>
+#include <atomic>
+#include <vector>
+
+// A 2D light map at reduced resolution. Every frame the lights are recorded
+// as additive quads of one soft sprite into RenderFrame::lights; the render
+// thread draws them into a target a divisor smaller than the output, cleared
+// to the ambient colour, and View multiplies the scene by that target with
+// one full-screen quad. Neither the number of lights nor the output size
+// costs per-pixel CPU work, and all lights share a texture and blend mode,
+// so they go out as a single batch.
+class Lighting
+{
+public:
+	static constexpr int SpriteSize = 64;
+
+	// Position and radius in world units; colour alpha scales intensity.
+	struct Light
+	{
+		float x;
+		float y;
+		float radius;
+		SDL_FColor color;
+	};
+
+	// format is the light sprite's, normally TextureStore::format().
+	explicit Lighting(SDL_PixelFormat format);
+	// Destroys the textures, so the submitting thread must be stopped.
+	~Lighting();
+
+	Lighting(const Lighting&) = delete;
+	Lighting& operator=(const Lighting&) = delete;
+
+	bool enabled;
+	SDL_FColor ambient;	// what unlit areas are multiplied by
+	// Output pixels per light map pixel along each axis: 2 is a quarter of
+	// the pixels. Light falls off smoothly, so linear filtering hides it.
+	int divisor;
+	std::vector<Light> lights;
+
+	// Once per frame, after RenderThread::beginFrame. Records the light pass
+	// and returns the light map to multiply over the output, null while
+	// disabled and for the frame it is (re)created in.
+	SDL_Texture* record(RenderFrame& frame, const Camera& camera);
+
+	// The part of the light map that covers the output, in texture
+	// coordinates: the map is rounded up to whole pixels, so for sizes not
+	// divisible by divisor its last row and column stick out. For the quad
+	// that draws the map returned by the last record().
+	const SDL_FRect& coverage() const { return covered; }
+
+	size_t drawnLights() const { return drawn; }	// by the last record()
+
+private:
+	SDL_PixelFormat spriteFormat;
+	bool spriteQueued;
+	std::atomic<SDL_Texture*> sprite;
+	// The render thread creates the map in whichever slot the frame names.
+	// A resize moves to the other slot, since the frame in flight may still
+	// create a map of the old size in the current one; that slot is
+	// released by the next record(), when the frame has finished.
+	std::atomic<SDL_Texture*> maps[2];
+	int slot;
+	bool retiring;
+	int mapWidth;
+	int mapHeight;
+	SDL_FRect covered;
+	size_t drawn;
+};
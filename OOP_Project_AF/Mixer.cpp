@@ -0,0 +1,398 @@
+#include "Mixer.h"
+#include "AudioKernels.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+
+namespace
+{
+	const float MinPitch = 1.0f / 64.0f;
+	const float MaxPitch = 16.0f;
+	// About -80 dB; quieter voices are never worth a mix slot.
+	const float InaudibleGain = 1e-4f;
+}
+
+Mixer::Mixer(AudioQueue& queue)
+	: simd(bestSimdPath()), queue(queue), stream(nullptr), rate(48000), voices(), activeCount(0),
+	  budget(DefaultVoiceBudget), left(BlockFrames), right(BlockFrames), output(BlockFrames * 2), buffers(0),
+	  framesMixed(0), lastNs(0), maxNs(0), totalNs(0), voicesMixed(0), voicesVirtual(0)
+{
+	for (std::atomic<const Sound*>& sound : sounds)
+		sound.store(nullptr, std::memory_order_relaxed);
+}
+
+Mixer::~Mixer()
+{
+	close();
+}
+
+bool Mixer::open(int sampleRate)
+{
+	close();
+	const SDL_AudioSpec spec = { SDL_AUDIO_F32, 2, sampleRate };
+	stream = SDL_OpenAudioDeviceStream(SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, &spec, nullptr, nullptr);
+	if (!stream)
+	{
+		SDL_Log("SDL_OpenAudioDeviceStream failed: %s", SDL_GetError());
+		return false;
+	}
+	rate = sampleRate;
+	if (!SDL_SetAudioStreamGetCallback(stream, &Mixer::feed, this) || !SDL_ResumeAudioStreamDevice(stream))
+	{
+		SDL_Log("Starting audio failed: %s", SDL_GetError());
+		close();
+		return false;
+	}
+	return true;
+}
+
+void Mixer::close()
+{
+	// Destroying the stream waits for a callback in progress.
+	if (stream)
+		SDL_DestroyAudioStream(stream);
+	stream = nullptr;
+}
+
+uint32_t Mixer::addSound(const float* frames, size_t frameCount, int channels, int sampleRate)
+{
+	if (owned.size() >= MaxSounds || !frames || frameCount == 0 || (channels != 1 && channels != 2) || sampleRate <= 0)
+		return AudioQueue::NoSound;
+	std::unique_ptr<Sound> sound(new Sound());
+	sound->frames = frameCount;
+	sound->channels = channels;
+	sound->sampleRate = sampleRate;
+	sound->samples.resize((frameCount + Sound::GuardFrames) * channels);
+	std::copy(frames, frames + frameCount * channels, sound->samples.begin());
+	for (size_t g = 0; g < Sound::GuardFrames; ++g)
+		std::copy(frames + (g % frameCount) * channels, frames + (g % frameCount + 1) * channels,
+			sound->samples.begin() + (frameCount + g) * channels);
+
+	const uint32_t id = (uint32_t)owned.size();
+	sounds[id].store(sound.get(), std::memory_order_release);
+	owned.push_back(std::move(sound));
+	return id;
+}
+
+uint32_t Mixer::loadWav(const char* path)
+{
+	SDL_AudioSpec spec;
+	Uint8* data = nullptr;
+	Uint32 length = 0;
+	if (!SDL_LoadWAV(path, &spec, &data, &length))
+	{
+		SDL_Log("SDL_LoadWAV failed for %s: %s", path, SDL_GetError());
+		return AudioQueue::NoSound;
+	}
+	const SDL_AudioSpec target = { SDL_AUDIO_F32, spec.channels > 1 ? 2 : 1, spec.freq };
+	Uint8* converted = nullptr;
+	int convertedLength = 0;
+	const bool ok = SDL_ConvertAudioSamples(&spec, data, (int)length, &target, &converted, &convertedLength);
+	SDL_free(data);
+	if (!ok)
+	{
+		SDL_Log("SDL_ConvertAudioSamples failed for %s: %s", path, SDL_GetError());
+		return AudioQueue::NoSound;
+	}
+	const uint32_t id = addSound((const float*)converted, (size_t)convertedLength / (sizeof(float) * target.channels),
+		target.channels, target.freq);
+	SDL_free(converted);
+	return id;
+}
+
+void SDLCALL Mixer::feed(void* userdata, SDL_AudioStream* stream, int additional, int)
+{
+	Mixer& mixer = *static_cast<Mixer*>(userdata);
+	const size_t frameBytes = sizeof(float) * 2;
+	size_t frames = ((size_t)SDL_max(additional, 0) + frameBytes - 1) / frameBytes;
+	while (frames > 0)
+	{
+		const size_t n = SDL_min(frames, BlockFrames);
+		mixer.mix(mixer.output.data(), n);
+		SDL_PutAudioStreamData(stream, mixer.output.data(), (int)(n * frameBytes));
+		frames -= n;
+	}
+}
+
+void Mixer::mix(float* out, size_t frames)
+{
+	const Uint64 started = SDL_GetTicksNS();
+	VoiceCommand command;
+	while (queue.pop(command))
+		apply(command);
+	if (const VoiceParamBlock* block = queue.takeParams())
+		apply(*block);
+
+	size_t mixed = 0;
+	size_t silent = 0;
+	for (size_t done = 0; done < frames; )
+	{
+		const size_t n = SDL_min(frames - done, BlockFrames);
+		std::fill(left.begin(), left.begin() + n, 0.0f);
+		std::fill(right.begin(), right.begin() + n, 0.0f);
+		select();
+		size_t rendered = 0;
+		for (size_t a = 0; a < activeCount; )
+		{
+			Voice& voice = voices[active[a]];
+			bool alive = false;
+			if (voice.sound && voice.selected)
+			{
+				// A voice returning from virtual ramps up from silence.
+				voice.state = VoiceState::Real;
+				alive = render(voice, n);
+				++rendered;
+			}
+			else if (voice.sound && voice.state == VoiceState::Real)
+			{
+				// Culled voices fade out over one block instead of clicking.
+				const float targetL = voice.targetL;
+				const float targetR = voice.targetR;
+				voice.targetL = 0.0f;
+				voice.targetR = 0.0f;
+				alive = render(voice, n);
+				voice.targetL = targetL;
+				voice.targetR = targetR;
+				voice.state = VoiceState::Virtual;
+				++rendered;
+			}
+			else if (voice.sound)
+			{
+				voice.state = VoiceState::Virtual;
+				voice.gainL = 0.0f;
+				voice.gainR = 0.0f;
+				alive = advance(voice, n);
+			}
+			if (alive)
+			{
+				++a;
+				continue;
+			}
+			// Stopped voices were released by the queue already; only
+			// voices that ran out are reported back.
+			if (voice.sound)
+				queue.finished(voice.id);
+			voice.sound = nullptr;
+			active[a] = active[--activeCount];
+		}
+		mixed = SDL_max(mixed, rendered);
+		silent = SDL_max(silent, activeCount - SDL_min(rendered, activeCount));
+		interleaveStereo(simd, left.data(), right.data(), out + done * 2, n);
+		done += n;
+	}
+
+	const uint64_t elapsed = SDL_GetTicksNS() - started;
+	buffers.fetch_add(1, std::memory_order_relaxed);
+	framesMixed.fetch_add(frames, std::memory_order_relaxed);
+	lastNs.store(elapsed, std::memory_order_relaxed);
+	totalNs.fetch_add(elapsed, std::memory_order_relaxed);
+	if (elapsed > maxNs.load(std::memory_order_relaxed))
+		maxNs.store(elapsed, std::memory_order_relaxed);
+	voicesMixed.store((uint32_t)mixed, std::memory_order_relaxed);
+	voicesVirtual.store((uint32_t)silent, std::memory_order_relaxed);
+}
+
+void Mixer::apply(const VoiceCommand& command)
+{
+	Voice& voice = voices[AudioQueue::slotOf(command.voice)];
+	switch (command.type)
+	{
+	case VoiceCommand::Type::Play:
+	case VoiceCommand::Type::PlayGains:
+	{
+		const Sound* sound = command.sound < MaxSounds ? sounds[command.sound].load(std::memory_order_acquire) : nullptr;
+		if (!sound)
+		{
+			queue.finished(command.voice);
+			return;
+		}
+		// A slot stopped earlier in this batch may still be listed.
+		if (std::find(active, active + activeCount, (uint16_t)AudioQueue::slotOf(command.voice)) == active + activeCount)
+			active[activeCount++] = (uint16_t)AudioQueue::slotOf(command.voice);
+		voice.id = command.voice;
+		voice.sound = sound;
+		voice.position = 0.0;
+		voice.loop = command.loop;
+		voice.priority = command.priority;
+		voice.state = VoiceState::Starting;
+		if (command.type == VoiceCommand::Type::PlayGains)
+		{
+			setPitch(voice, command.pitch);
+			voice.targetL = SDL_max(command.gain, 0.0f);
+			voice.targetR = SDL_max(command.pan, 0.0f);
+		}
+		else
+			setParams(voice, command.gain, command.pan, command.pitch);
+		voice.gainL = voice.targetL;
+		voice.gainR = voice.targetR;
+		break;
+	}
+	case VoiceCommand::Type::Stop:
+		if (voice.sound && voice.id == command.voice)
+			voice.sound = nullptr;
+		break;
+	case VoiceCommand::Type::Set:
+		if (voice.sound && voice.id == command.voice)
+			setParams(voice, command.gain, command.pan, command.pitch);
+		break;
+	case VoiceCommand::Type::StopAll:
+		for (size_t a = 0; a < activeCount; ++a)
+			voices[active[a]].sound = nullptr;
+		break;
+	}
+}
+
+void Mixer::apply(const VoiceParamBlock& block)
+{
+	for (uint32_t i = 0; i < block.count; ++i)
+	{
+		Voice& voice = voices[AudioQueue::slotOf(block.voice[i])];
+		if (!voice.sound || voice.id != block.voice[i])
+			continue;
+		voice.targetL = block.gainL[i];
+		voice.targetR = block.gainR[i];
+		// Voices started this block begin at their gains, like Play.
+		if (voice.state == VoiceState::Starting)
+		{
+			voice.gainL = voice.targetL;
+			voice.gainR = voice.targetR;
+		}
+	}
+}
+
+void Mixer::setPitch(Voice& voice, float pitch)
+{
+	voice.pitch = SDL_clamp(pitch, MinPitch, MaxPitch);
+	voice.step = voice.pitch * (float)voice.sound->sampleRate / (float)rate;
+}
+
+void Mixer::setParams(Voice& voice, float gain, float pan, float pitch)
+{
+	gain = SDL_max(gain, 0.0f);
+	pan = SDL_clamp(pan, -1.0f, 1.0f);
+	setPitch(voice, pitch);
+	if (voice.sound->channels == 1)
+	{
+		// Constant power, so a voice sweeping across keeps its loudness.
+		const float angle = (pan + 1.0f) * SDL_PI_F * 0.25f;
+		voice.targetL = gain * SDL_cosf(angle);
+		voice.targetR = gain * SDL_sinf(angle);
+	}
+	else
+	{
+		// Stereo sources are balanced rather than panned.
+		voice.targetL = gain * SDL_min(1.0f, 1.0f - pan);
+		voice.targetR = gain * SDL_min(1.0f, 1.0f + pan);
+	}
+}
+
+void Mixer::select()
+{
+	const size_t limit = budget.load(std::memory_order_relaxed);
+	size_t candidates = 0;
+	for (size_t a = 0; a < activeCount; ++a)
+	{
+		Voice& voice = voices[active[a]];
+		voice.selected = false;
+		const float loudness = SDL_max(voice.targetL, voice.targetR);
+		if (!voice.sound || loudness <= InaudibleGain)
+			continue;
+		// Priority dominates and loudness orders within it. Voices already
+		// mixing get a small edge, so ranks at the budget edge do not
+		// flip every block.
+		scores[active[a]] = (float)voice.priority + SDL_min(loudness, 1.0f) * 0.9f
+			+ (voice.state == VoiceState::Real ? 0.09f : 0.0f);
+		ranked[candidates++] = active[a];
+	}
+	if (candidates > limit)
+	{
+		std::nth_element(ranked, ranked + limit, ranked + candidates,
+			[this](uint16_t a, uint16_t b) { return scores[a] > scores[b]; });
+		candidates = limit;
+	}
+	for (size_t i = 0; i < candidates; ++i)
+		voices[ranked[i]].selected = true;
+}
+
+bool Mixer::advance(Voice& voice, size_t frames)
+{
+	const double length = (double)voice.sound->frames;
+	voice.position += (double)voice.step * (double)frames;
+	if (voice.position < length)
+		return true;
+	if (!voice.loop)
+		return false;
+	voice.position = SDL_fmod(voice.position, length);
+	return true;
+}
+
+bool Mixer::render(Voice& voice, size_t frames)
+{
+	const Sound& sound = *voice.sound;
+	// Gain changes ramp across the block instead of clicking.
+	const float stepL = (voice.targetL - voice.gainL) / (float)frames;
+	const float stepR = (voice.targetR - voice.gainR) / (float)frames;
+	float gainL = voice.gainL;
+	float gainR = voice.gainR;
+	size_t done = 0;
+	while (done < frames)
+	{
+		// Output frames until the position passes the last source frame.
+		const double remaining = (double)sound.frames - voice.position;
+		const size_t count = SDL_min(frames - done, (size_t)SDL_ceil(remaining / voice.step));
+		if (count > 0)
+		{
+			const size_t base = (size_t)voice.position;
+			mixVoice(simd, sound.samples.data() + base * sound.channels, sound.channels,
+				(float)(voice.position - (double)base), voice.step, count, gainL, gainR, stepL, stepR,
+				left.data() + done, right.data() + done);
+			voice.position += (double)voice.step * (double)count;
+			gainL += stepL * (float)count;
+			gainR += stepR * (float)count;
+			done += count;
+		}
+		if (voice.position >= (double)sound.frames)
+		{
+			if (!voice.loop)
+				return false;
+			voice.position = SDL_fmod(voice.position, (double)sound.frames);
+		}
+	}
+	voice.gainL = voice.targetL;
+	voice.gainR = voice.targetR;
+	return true;
+}
+
+Mixer::Stats Mixer::stats() const
+{
+	Stats s;
+	s.buffers = buffers.load(std::memory_order_relaxed);
+	s.frames = framesMixed.load(std::memory_order_relaxed);
+	s.lastNs = lastNs.load(std::memory_order_relaxed);
+	s.maxNs = maxNs.load(std::memory_order_relaxed);
+	s.totalNs = totalNs.load(std::memory_order_relaxed);
+	s.voices = voicesMixed.load(std::memory_order_relaxed);
+	s.virtualVoices = voicesVirtual.load(std::memory_order_relaxed);
+	return s;
+}
+
+void Mixer::connect(EventBus& bus)
+{
+	bus.subscribe<&Mixer::onStatsRequested>(this);
+}
+
+void Mixer::onStatsRequested(const StatsRequested*, size_t)
+{
+	const Stats s = stats();
+	if (s.buffers == 0)
+	{
+		SDL_Log("Audio: no buffers mixed");
+		return;
+	}
+	// Share of the real-time budget: time spent mixing over time played.
+	const double played = (double)s.frames / (double)rate * 1e9;
+	SDL_Log("Audio (%s): %u voices + %u virtual (budget %u), %.3f ms last / %.3f ms max / %.3f ms mean per buffer of %llu frames, %.2f%% of real time",
+		simdPathName(simd), s.voices, s.virtualVoices, voiceBudget(), s.lastNs / 1e6, s.maxNs / 1e6, s.totalNs / 1e6 / s.buffers,
+		(unsigned long long)(s.frames / s.buffers), 100.0 * s.totalNs / played);
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include "AudioQueue.h"
+#include "EventBus.h"
+#include "Events.h"
+#include "Simd.h"
+#include <SDL3/SDL_audio.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Decoded float32 PCM, immutable once added to a Mixer. GuardFrames copies
+// of the first frames follow the last one, so interpolation may read one
+// frame past any position without a bounds check and loops wrap cleanly.
+struct Sound
+{
+	static constexpr size_t GuardFrames = 2;
+
+	std::vector<float> samples;
+	size_t frames;
+	int channels;	// 1 or 2
+	int sampleRate;
+};
+
+// Software mixer on the default playback device.
+//
+// SDL pulls audio through an SDL_SetAudioStreamGetCallback callback; it
+// drains the AudioQueue, mixes every playing voice into planar accumulators
+// with the SIMD kernels from AudioKernels and hands SDL interleaved stereo
+// float32. The mixer's own code on that path takes no locks and allocates
+// nothing: sounds are immutable and published through atomic pointers,
+// voices live in a fixed array, and all scratch is sized up front. The final
+// SDL_PutAudioStreamData is SDL's, and it locks the stream and may grow its
+// queue. CPU time is recorded for every buffer.
+//
+// At most voiceBudget voices are mixed per block. When more are playing,
+// the lowest-priority and then quietest ones are virtualized: their
+// position keeps advancing (loops wrap, one-shots end on time) but they are
+// not rendered, and they fade back in once they rank inside the budget
+// again. Inaudible voices are always virtual.
+class Mixer
+{
+public:
+	static constexpr uint32_t MaxSounds = 1024;
+	static constexpr size_t BlockFrames = 1024;	// frames mixed per pass
+	static constexpr uint32_t DefaultVoiceBudget = 64;
+
+	struct Stats
+	{
+		uint64_t buffers;
+		uint64_t frames;
+		uint64_t lastNs;	// CPU time of the latest buffer
+		uint64_t maxNs;
+		uint64_t totalNs;
+		uint32_t voices;	// mixed in the latest buffer
+		uint32_t virtualVoices;	// tracked but silent in the latest buffer
+	};
+
+	// queue must outlive the mixer; Model::audio in the app.
+	explicit Mixer(AudioQueue& queue);
+	~Mixer();
+
+	Mixer(const Mixer&) = delete;
+	Mixer& operator=(const Mixer&) = delete;
+
+	// Starts playback. Logs and returns false if no device could be opened.
+	bool open(int sampleRate = 48000);
+	void close();
+	int sampleRate() const { return rate; }
+	// The logical device the mixer plays on, for binding more streams; 0
+	// while closed.
+	SDL_AudioDeviceID device() const { return stream ? SDL_GetAudioStreamDevice(stream) : 0; }
+
+	// Main thread, also while playing. Returns AudioQueue::NoSound once
+	// MaxSounds are loaded or the data is unusable.
+	uint32_t addSound(const float* frames, size_t frameCount, int channels, int sampleRate);
+	// Any WAV SDL can read, converted to float32 mono or stereo on load.
+	uint32_t loadWav(const char* path);
+
+	// Applies queued commands and writes frames of interleaved stereo to out.
+	// Runs on the audio thread; public so benchmarks can drive it directly.
+	void mix(float* out, size_t frames);
+
+	// Any thread; takes effect at the next block.
+	void setVoiceBudget(uint32_t count) { budget.store(count, std::memory_order_relaxed); }
+	uint32_t voiceBudget() const { return budget.load(std::memory_order_relaxed); }
+
+	Stats stats() const;
+
+	// Subscribes onStatsRequested to bus.
+	void connect(EventBus& bus);
+	void onStatsRequested(const StatsRequested* events, size_t count);
+
+	SimdPath simd;
+
+private:
+	enum class VoiceState : uint8_t
+	{
+		Starting,	// played this block; joins without a fade either way
+		Real,
+		Virtual		// advancing silently, gains held at zero
+	};
+
+	struct Voice
+	{
+		uint32_t id;
+		const Sound* sound;	// null when the slot is idle
+		double position;	// in source frames
+		float step;			// source frames per output frame
+		float pitch;
+		float targetL;
+		float targetR;
+		float gainL;		// reached at the end of the last block
+		float gainR;
+		bool loop;
+		uint8_t priority;
+		VoiceState state;
+		bool selected;		// within the budget for the current block
+	};
+
+	static void SDLCALL feed(void* userdata, SDL_AudioStream* stream, int additional, int total);
+	void apply(const VoiceCommand& command);
+	void apply(const VoiceParamBlock& block);
+	void setParams(Voice& voice, float gain, float pan, float pitch);
+	void setPitch(Voice& voice, float pitch);
+	// Marks the voices to render this block.
+	void select();
+	// Adds frames of voice to the accumulators; false once it has ended.
+	bool render(Voice& voice, size_t frames);
+	// Moves a virtual voice on by frames; false once it has ended.
+	static bool advance(Voice& voice, size_t frames);
+
+	AudioQueue& queue;
+	SDL_AudioStream* stream;
+	int rate;
+
+	std::vector<std::unique_ptr<Sound>> owned;	// main thread
+	std::atomic<const Sound*> sounds[MaxSounds];
+
+	// Audio thread from here on.
+	Voice voices[AudioQueue::MaxVoices];
+	uint16_t active[AudioQueue::MaxVoices];
+	size_t activeCount;
+	std::atomic<uint32_t> budget;
+	float scores[AudioQueue::MaxVoices];
+	uint16_t ranked[AudioQueue::MaxVoices];
+	std::vector<float> left;
+	std::vector<float> right;
+	std::vector<float> output;
+
+	std::atomic<uint64_t> buffers;
+	std::atomic<uint64_t> framesMixed;
+	std::atomic<uint64_t> lastNs;
+	std::atomic<uint64_t> maxNs;
+	std::atomic<uint64_t> totalNs;
+	std::atomic<uint32_t> voicesMixed;
+	std::atomic<uint32_t> voicesVirtual;
+};
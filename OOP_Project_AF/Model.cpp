@@ -0,0 +1,414 @@
+#include "Model.h"
+#include "Integrate.h"
+#include "JobSystem.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	const uint32_t SaveMagic = 0x53464f4f; // "OOFS"
+	const uint32_t SaveVersion = 5;
+	// Four-byte columns per entity: five floats plus the handle.
+	const size_t ColumnCount = 6;
+
+	struct SaveHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint64_t tick;
+		float worldWidth;
+		float worldHeight;
+		uint64_t count;
+		uint64_t slotCount;
+		uint64_t linkCount;
+		uint32_t navWidth;
+		uint32_t navHeight;
+		float navTileSize;
+		uint32_t reserved;
+	};
+
+	// Columns are decoded in slices so a large load can report progress.
+	const size_t DecodeSlice = 64 * 1024;
+
+	// Entities per motion job: big enough to amortise scheduling, small
+	// enough that 1M entities spread over every core.
+	const size_t MotionGrain = 32 * 1024;
+
+	template <typename T>
+	void appendColumn(std::vector<uint8_t>& out, const std::vector<T>& column)
+	{
+		const size_t bytes = column.size() * sizeof(T);
+		const size_t at = out.size();
+		out.resize(at + bytes);
+		if (bytes)
+			std::memcpy(out.data() + at, column.data(), bytes);
+	}
+
+	template <typename T>
+	const uint8_t* readColumn(const uint8_t* src, std::vector<T>& column, size_t count)
+	{
+		column.resize(count);
+		if (count)
+			std::memcpy(column.data(), src, count * sizeof(T));
+		return src + count * sizeof(T);
+	}
+}
+
+Model::Model(float worldWidth, float worldHeight)
+	: worldWidth(worldWidth), worldHeight(worldHeight), damping(1.0f), seekSpeed(120.0f),
+	  tick(0), spawnSound(AudioQueue::NoSound), reindexCount(0), seeking(false), seekX(0), seekY(0)
+{
+	nav.resize((int)SDL_ceilf(worldWidth / NavTileSize), (int)SDL_ceilf(worldHeight / NavTileSize), (float)NavTileSize);
+	visibility.resize((int)SDL_ceilf(worldWidth / FogCellSize), (int)SDL_ceilf(worldHeight / FogCellSize),
+		(float)FogCellSize);
+	spatial.params.listenerX = worldWidth * 0.5f;
+	spatial.params.listenerY = worldHeight * 0.5f;
+	spatial.params.panWidth = worldWidth * 0.5f;
+	spatial.params.maxDistance = worldWidth;
+}
+
+EntityHandle Model::spawn(float x, float y, float vx, float vy, float r)
+{
+	const EntityHandle entity = slots.create((uint32_t)size());
+	if (entity == NullEntity)
+		return NullEntity;
+	posX.push_back(x);
+	posY.push_back(y);
+	velX.push_back(vx);
+	velY.push_back(vy);
+	radius.push_back(r);
+	handles.push_back(entity);
+	changes.resize(posX.size());
+	changes.markLayout();
+	return entity;
+}
+
+bool Model::destroy(EntityHandle entity)
+{
+	if (!slots.valid(entity))
+		return false;
+	const uint32_t i = slots.dense(entity);
+	const size_t last = size() - 1;
+	if (i != last)
+	{
+		posX[i] = posX[last];
+		posY[i] = posY[last];
+		velX[i] = velX[last];
+		velY[i] = velY[last];
+		radius[i] = radius[last];
+		handles[i] = handles[last];
+		slots.relocate(handles[i], i);
+	}
+	posX.pop_back();
+	posY.pop_back();
+	velX.pop_back();
+	velY.pop_back();
+	radius.pop_back();
+	handles.pop_back();
+	slots.destroy(entity);
+	++reindexCount;
+	changes.resize(size());
+	changes.markLayout();
+	return true;
+}
+
+void Model::swapEntities(size_t a, size_t b)
+{
+	std::swap(posX[a], posX[b]);
+	std::swap(posY[a], posY[b]);
+	std::swap(velX[a], velX[b]);
+	std::swap(velY[a], velY[b]);
+	std::swap(radius[a], radius[b]);
+	std::swap(handles[a], handles[b]);
+	slots.relocate(handles[a], (uint32_t)a);
+	slots.relocate(handles[b], (uint32_t)b);
+	++reindexCount;
+	for (Component c : { Component::Transform, Component::Velocity, Component::Shape })
+	{
+		changes.mark(c, (uint32_t)a);
+		changes.mark(c, (uint32_t)b);
+	}
+}
+
+void Model::clear()
+{
+	posX.clear();
+	posY.clear();
+	velX.clear();
+	velY.clear();
+	radius.clear();
+	handles.clear();
+	slots.clear();
+	transforms.clear();
+	tick = 0;
+	changes.resize(0);
+	changes.markLayout();
+}
+
+void Model::connect(EventBus& bus)
+{
+	bus.subscribe<&Model::onSpawnRequested>(this);
+	bus.subscribe<&Model::onCompactRequested>(this);
+	bus.subscribe<&Model::onGoalRequested>(this);
+}
+
+void Model::onSpawnRequested(const SpawnRequested* events, size_t count)
+{
+	for (size_t e = 0; e < count; ++e)
+	{
+		const SpawnRequested& request = events[e];
+		if (spawnSound != AudioQueue::NoSound)
+			spatial.playAt(audio, spawnSound, request.x, request.y, 0.5f);
+		for (int i = 0; i < request.count; ++i)
+		{
+			const float angle = SDL_randf() * 2.0f * SDL_PI_F;
+			const float speed = SDL_randf() * 150.0f;
+			spawn(request.x, request.y, SDL_cosf(angle) * speed, SDL_sinf(angle) * speed);
+		}
+	}
+}
+
+void Model::onCompactRequested(const CompactRequested*, size_t)
+{
+	compactor.start();
+}
+
+void Model::onGoalRequested(const GoalRequested* events, size_t count)
+{
+	seek(events[count - 1].x, events[count - 1].y);
+}
+
+void Model::seek(float worldX, float worldY)
+{
+	seeking = nav.tileAt(worldX, worldY, seekX, seekY);
+}
+
+void Model::update(float dt)
+{
+	compactor.step(*this);
+
+	MotionParams params;
+	params.dt = dt;
+	params.damping = damping;
+	params.minX = 0.0f;
+	params.minY = 0.0f;
+	params.maxX = worldWidth;
+	params.maxY = worldHeight;
+	const SimdPath path = bestSimdPath();
+	uint64_t* transformWords = changes.words(Component::Transform);
+	uint64_t* velocityWords = changes.words(Component::Velocity);
+	const bool damped = params.damping != 1.0f;
+	// One field serves every seeking entity, however many there are.
+	const FlowField* field = seeking ? &paths.flowField(nav, seekX, seekY) : nullptr;
+	JobSystem::shared().parallelFor(size(), MotionGrain, [&](size_t begin, size_t end)
+		{
+			if (field)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					float dirX;
+					float dirY;
+					if (field->sample(nav, posX[i], posY[i], dirX, dirY))
+					{
+						velX[i] = dirX * seekSpeed;
+						velY[i] = dirY * seekSpeed;
+						changes.mark(Component::Velocity, (uint32_t)i);
+					}
+				}
+			}
+			// Chunks start on multiples of 64, so each owns whole bitset words.
+			for (size_t w = begin / 64; w * 64 < end; ++w)
+			{
+				uint64_t mask = 0;
+				const size_t last = SDL_min(end, w * 64 + 64);
+				for (size_t i = w * 64; i < last; ++i)
+					mask |= (uint64_t)(velX[i] != 0.0f || velY[i] != 0.0f) << (i & 63);
+				transformWords[w] |= mask;
+				if (damped)
+					velocityWords[w] |= mask;
+			}
+			// Undamped velocities only change where the bounds reflect them.
+			integrateMotion(path, posX.data(), posY.data(), velX.data(), velY.data(), begin, end, params,
+				damped ? nullptr : velocityWords);
+		});
+
+	collisions.step(*this);
+	transforms.propagate(*this);
+	visibility.update(*this);
+	audio.reclaim();
+	spatial.update(*this, audio);
+	navGraph.sync(nav);
+	paths.update(nav, navGraph.graph(nav));
+	++tick;
+
+	changes.flush();
+	observers.notify(*this, changes);
+}
+
+void Model::capture(ModelSnapshot& out) const
+{
+	out.tick = tick;
+	out.worldWidth = worldWidth;
+	out.worldHeight = worldHeight;
+	out.posX = posX;
+	out.posY = posY;
+	out.velX = velX;
+	out.velY = velY;
+	out.radius = radius;
+	out.handles = handles;
+	out.generations.resize(slots.slotCount());
+	for (size_t s = 0; s < out.generations.size(); ++s)
+		out.generations[s] = slots.generation(s);
+	out.links = transforms.allLinks();
+
+	// The grid dwarfs the entity columns on big maps but rarely changes, so
+	// only the tiles edited since the last capture are copied when possible.
+	const uint32_t* edited = nullptr;
+	size_t editCount = 0;
+	if (out.navWidth == nav.width() && out.navHeight == nav.height() && out.navTiles.size() == nav.tileCount()
+		&& nav.editsSince(out.navVersion, edited, editCount))
+	{
+		for (size_t e = 0; e < editCount; ++e)
+			out.navTiles[edited[e]] = nav.data()[edited[e]];
+	}
+	else
+	{
+		out.navTiles.assign(nav.data(), nav.data() + nav.tileCount());
+	}
+	out.navWidth = nav.width();
+	out.navHeight = nav.height();
+	out.navTileSize = nav.tileSize();
+	out.navVersion = nav.version();
+}
+
+bool Model::apply(ModelSnapshot& in)
+{
+	const size_t count = in.handles.size();
+	if (in.posX.size() != count || in.posY.size() != count || in.velX.size() != count
+		|| in.velY.size() != count || in.radius.size() != count
+		|| in.navTiles.size() != (size_t)in.navWidth * (size_t)in.navHeight)
+		return false;
+	HandlePool restored;
+	if (!restored.rebuild(in.generations.data(), in.generations.size(), in.handles.data(), count))
+		return false;
+
+	std::swap(posX, in.posX);
+	std::swap(posY, in.posY);
+	std::swap(velX, in.velX);
+	std::swap(velY, in.velY);
+	std::swap(radius, in.radius);
+	std::swap(handles, in.handles);
+	std::swap(slots, restored);
+	transforms.restore(in.links.data(), in.links.size());
+	if (nav.width() != in.navWidth || nav.height() != in.navHeight || nav.tileSize() != in.navTileSize
+		|| (nav.tileCount() && std::memcmp(nav.data(), in.navTiles.data(), nav.tileCount()) != 0))
+		nav.assign(in.navWidth, in.navHeight, in.navTileSize, in.navTiles.data());
+
+	tick = in.tick;
+	worldWidth = in.worldWidth;
+	worldHeight = in.worldHeight;
+	visibility.resize((int)SDL_ceilf(worldWidth / FogCellSize), (int)SDL_ceilf(worldHeight / FogCellSize),
+		(float)FogCellSize);
+	// A cycle planned over the old order would move the wrong rows.
+	compactor.reset();
+	seeking = false;
+	++reindexCount;
+	changes.resize(count);
+	changes.markLayout();
+	return true;
+}
+
+void ModelSnapshot::serialize(std::vector<uint8_t>& out) const
+{
+	SaveHeader header;
+	header.magic = SaveMagic;
+	header.version = SaveVersion;
+	header.tick = tick;
+	header.worldWidth = worldWidth;
+	header.worldHeight = worldHeight;
+	header.count = handles.size();
+	header.slotCount = generations.size();
+	header.linkCount = links.size();
+	header.navWidth = (uint32_t)navWidth;
+	header.navHeight = (uint32_t)navHeight;
+	header.navTileSize = navTileSize;
+	header.reserved = 0;
+
+	out.clear();
+	out.reserve(sizeof(header) + (handles.size() * ColumnCount + generations.size() + 1) * sizeof(uint32_t)
+		+ links.size() * sizeof(TransformHierarchy::Link) + navTiles.size());
+	out.resize(sizeof(header));
+	std::memcpy(out.data(), &header, sizeof(header));
+	appendColumn(out, posX);
+	appendColumn(out, posY);
+	appendColumn(out, velX);
+	appendColumn(out, velY);
+	appendColumn(out, radius);
+	appendColumn(out, handles);
+	appendColumn(out, generations);
+	appendColumn(out, links);
+	appendColumn(out, navTiles);
+
+	const uint32_t crc = SDL_crc32(0, out.data(), out.size());
+	out.resize(out.size() + sizeof(crc));
+	std::memcpy(out.data() + out.size() - sizeof(crc), &crc, sizeof(crc));
+}
+
+bool ModelSnapshot::deserialize(const uint8_t* data, size_t length, std::atomic<float>* progress)
+{
+	SaveHeader header;
+	if (length < sizeof(header) + sizeof(uint32_t))
+		return false;
+	std::memcpy(&header, data, sizeof(header));
+	if (header.magic != SaveMagic || header.version != SaveVersion)
+		return false;
+
+	const size_t count = (size_t)header.count;
+	const size_t slotCount = (size_t)header.slotCount;
+	const size_t linkCount = (size_t)header.linkCount;
+	const size_t tileCount = (size_t)header.navWidth * header.navHeight;
+	if (header.count > HandlePool::MaxSlots || header.slotCount > HandlePool::MaxSlots
+		|| header.linkCount > HandlePool::MaxSlots || header.navWidth > 65536 || header.navHeight > 65536
+		|| length != sizeof(header) + (count * ColumnCount + slotCount + 1) * sizeof(uint32_t)
+			+ linkCount * sizeof(TransformHierarchy::Link) + tileCount)
+		return false;
+
+	uint32_t crc;
+	std::memcpy(&crc, data + length - sizeof(crc), sizeof(crc));
+	if (SDL_crc32(0, data, length - sizeof(crc)) != crc)
+		return false;
+
+	std::vector<float>* columns[] = { &posX, &posY, &velX, &velY, &radius };
+	const uint8_t* src = data + sizeof(header);
+	const size_t total = count * (ColumnCount - 1);
+	size_t decoded = 0;
+	for (std::vector<float>* column : columns)
+	{
+		column->resize(count);
+		for (size_t i = 0; i < count; i += DecodeSlice)
+		{
+			const size_t n = SDL_min(DecodeSlice, count - i);
+			std::memcpy(column->data() + i, src, n * sizeof(float));
+			src += n * sizeof(float);
+			decoded += n;
+			if (progress)
+				progress->store((float)decoded / (float)total, std::memory_order_relaxed);
+		}
+	}
+
+	src = readColumn(src, handles, count);
+	src = readColumn(src, generations, slotCount);
+	src = readColumn(src, links, linkCount);
+	readColumn(src, navTiles, tileCount);
+
+	tick = header.tick;
+	worldWidth = header.worldWidth;
+	worldHeight = header.worldHeight;
+	navWidth = (int)header.navWidth;
+	navHeight = (int)header.navHeight;
+	navTileSize = header.navTileSize;
+	if (progress)
+		progress->store(1.0f, std::memory_order_relaxed);
+	return true;
+}
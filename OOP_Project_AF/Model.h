@@ -1,6 +1,145 @@
 #pragma once
-class Model
+#include "AudioQueue.h"
+#include "ChangeTracker.h"
+#include "Collision.h"
+#include "Compactor.h"
+#include "EntityHandle.h"
+#include "EventBus.h"
+#include "Events.h"
+#include "NavGraph.h"
+#include "NavGrid.h"
+#include "PathService.h"
+#include "SpatialAudio.h"
+#include "TransformHierarchy.h"
+#include "Visibility.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The saved part of a Model as plain columns. SaveSystem fills one on the
+// main thread (Model::capture), encodes or decodes it on its worker, and
+// hands a decoded one back through Model::apply.
+struct ModelSnapshot
 {
+	uint64_t tick = 0;
+	float worldWidth = 0.0f;
+	float worldHeight = 0.0f;
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> radius;
+	std::vector<EntityHandle> handles;
+	std::vector<uint32_t> generations;
+	std::vector<TransformHierarchy::Link> links;
+	int navWidth = 0;
+	int navHeight = 0;
+	float navTileSize = 1.0f;
+	// NavGrid::version() navTiles was captured at, so the next capture only
+	// copies tiles edited since.
+	uint64_t navVersion = 0;
+	std::vector<uint8_t> navTiles;
 
+	// Flat binary image. deserialize reports 0..1 through progress.
+	void serialize(std::vector<uint8_t>& out) const;
+	bool deserialize(const uint8_t* data, size_t length, std::atomic<float>* progress = nullptr);
 };
 
+class Model
+{
+public:
+	Model(float worldWidth = 1280.0f, float worldHeight = 720.0f);
+
+	static const size_t NoEntity = ~(size_t)0;
+
+	// Entities are named by generational handles, never by index or pointer:
+	// destroy() swap-removes, so indices move while handles stay valid.
+	// spawn returns NullEntity once HandlePool::MaxSlots are alive.
+	EntityHandle spawn(float x, float y, float vx, float vy, float r = 2.0f);
+	bool destroy(EntityHandle entity);
+	void clear();
+	size_t size() const { return posX.size(); }
+
+	// Exchanges two entities' rows in every column; both handles follow.
+	void swapEntities(size_t a, size_t b);
+
+	bool alive(EntityHandle entity) const { return slots.valid(entity); }
+	// Current column index of entity, or NoEntity if the handle is stale.
+	size_t indexOf(EntityHandle entity) const { return slots.valid(entity) ? slots.dense(entity) : NoEntity; }
+	// Changes whenever an existing entity changes index or is destroyed, so
+	// callers caching indices know when to look them up again.
+	uint64_t indexEpoch() const { return reindexCount; }
+
+	void update(float dt);
+
+	// Subscribes the handlers below to bus.
+	void connect(EventBus& bus);
+	void onSpawnRequested(const SpawnRequested* events, size_t count);
+	void onCompactRequested(const CompactRequested* events, size_t count);
+	void onGoalRequested(const GoalRequested* events, size_t count);
+
+	// Steers every entity along the shared flow field to a world position,
+	// at seekSpeed, until stopSeeking().
+	void seek(float worldX, float worldY);
+	void stopSeeking() { seeking = false; }
+
+	// Save support. capture copies the saved columns into out, reusing its
+	// buffers; pass the same snapshot each time to this Model. apply swaps a
+	// decoded snapshot's columns in, handing the replaced ones back, and leaves
+	// the nav grid, and so navGraph, alone when the tiles are unchanged.
+	// apply returns false, changing nothing, if the snapshot is inconsistent.
+	void capture(ModelSnapshot& out) const;
+	bool apply(ModelSnapshot& in);
+
+	float worldWidth;
+	float worldHeight;
+	float damping;	// velocity multiplier per tick, 1 = frictionless
+	float seekSpeed;
+	uint64_t tick;
+
+	// Entity state, one contiguous column per field.
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> radius;
+	std::vector<EntityHandle> handles;
+
+	// Observers are notified once at the end of every update() with the
+	// changes since the previous one. The same lists stay queryable until the
+	// next update, e.g. changes.changed(Component::Transform). Anything that
+	// writes entity columns marks what it touched in changes.
+	void addObserver(ModelObserver* observer) { observers.add(observer); }
+	void removeObserver(ModelObserver* observer) { observers.remove(observer); }
+
+	ChangeTracker changes;
+	CollisionSystem collisions;
+	Compactor compactor;
+	TransformHierarchy transforms;
+	// Covers the world in NavTileSize tiles; A* requests advance in update(),
+	// and long ones are answered from navGraph, which follows edits to nav on
+	// a worker.
+	static const int NavTileSize = 16;
+	NavGrid nav;
+	NavGraph navGraph;
+	PathService paths;
+	// Voice requests for the Mixer. Positional voices go through spatial,
+	// whose listener is the middle of the world (the view shows all of it).
+	// spawnSound, if set, plays once per SpawnRequested where it landed.
+	AudioQueue audio;
+	SpatialAudio spatial;
+	uint32_t spawnSound;
+	// Fog of war per team in FogCellSize cells; entities only see once
+	// watched, e.g. visibility.watch(*this, entity, team, radius).
+	static const int FogCellSize = 8;
+	Visibility visibility;
+
+private:
+	HandlePool slots;
+	uint64_t reindexCount;
+	bool seeking;
+	int seekX;
+	int seekY;
+	ObserverList observers;
+};
@@ -0,0 +1,331 @@
+#include "MusicStream.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+
+namespace
+{
+	const Uint16 FormatPcm = 1;
+	const Uint16 FormatFloat = 3;
+	const Uint16 FormatExtensible = 0xfffe;
+
+	bool readTag(SDL_IOStream* io, char tag[4])
+	{
+		return SDL_ReadIO(io, tag, 4) == 4;
+	}
+
+	SDL_AudioFormat sampleFormat(Uint16 tag, Uint16 bits)
+	{
+		if (tag == FormatPcm && bits == 8)
+			return SDL_AUDIO_U8;
+		if (tag == FormatPcm && bits == 16)
+			return SDL_AUDIO_S16LE;
+		if (tag == FormatPcm && bits == 32)
+			return SDL_AUDIO_S32LE;
+		if (tag == FormatFloat && bits == 32)
+			return SDL_AUDIO_F32LE;
+		return SDL_AUDIO_UNKNOWN;
+	}
+}
+
+MusicStream::MusicStream()
+	: io(nullptr), stream(nullptr), spec(), dataStart(0), dataBytes(0), dataLeft(0), settings(),
+	  freeCount(nullptr), quit(false), decoded(0), streamed(0), underruns(0), ended(false), drained(false)
+{
+}
+
+MusicStream::~MusicStream()
+{
+	close();
+}
+
+bool MusicStream::openFile(SDL_AudioDeviceID device, const char* path, const Settings& settings)
+{
+	SDL_IOStream* file = SDL_IOFromFile(path, "rb");
+	if (!file)
+	{
+		SDL_Log("Opening %s failed: %s", path, SDL_GetError());
+		return false;
+	}
+	return open(device, file, settings);
+}
+
+bool MusicStream::open(SDL_AudioDeviceID device, SDL_IOStream* source, const Settings& requested)
+{
+	close();
+	io = source;
+	settings = requested;
+	settings.chunkFrames = SDL_max(settings.chunkFrames, 256);
+	settings.prefetchDepth = SDL_clamp(settings.prefetchDepth, 2, MaxPrefetchDepth);
+	if (!io || !parseHeader())
+	{
+		close();
+		return false;
+	}
+
+	SDL_AudioSpec deviceSpec;
+	if (!SDL_GetAudioDeviceFormat(device, &deviceSpec, nullptr))
+	{
+		SDL_Log("SDL_GetAudioDeviceFormat failed: %s", SDL_GetError());
+		close();
+		return false;
+	}
+	stream = SDL_CreateAudioStream(&spec, &deviceSpec);
+	freeCount = SDL_CreateSemaphore(0);
+	if (!stream || !freeCount)
+	{
+		SDL_Log("Creating the music stream failed: %s", SDL_GetError());
+		close();
+		return false;
+	}
+	SDL_SetAudioStreamGain(stream, settings.gain);
+
+	// Every buffer is allocated here, never while playing. The first ones
+	// are read right away, so playback does not open with an underrun.
+	const size_t chunkBytes = (size_t)settings.chunkFrames * SDL_AUDIO_FRAMESIZE(spec);
+	chunks.resize((size_t)settings.prefetchDepth);
+	bool more = true;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.data.resize(chunkBytes);
+		chunk.bytes = 0;
+		chunk.last = false;
+		if (!more)
+		{
+			empty.push(&chunk);
+			SDL_SignalSemaphore(freeCount);
+			continue;
+		}
+		more = fill(chunk);
+		ready.push(&chunk);
+	}
+	ended.store(!more, std::memory_order_relaxed);
+
+	if (!SDL_SetAudioStreamGetCallback(stream, &MusicStream::feed, this) || !SDL_BindAudioStream(device, stream))
+	{
+		SDL_Log("Starting the music stream failed: %s", SDL_GetError());
+		close();
+		return false;
+	}
+	worker = std::thread(&MusicStream::workerMain, this);
+	return true;
+}
+
+void MusicStream::close()
+{
+	// Destroying the stream unbinds it and waits for a callback in progress,
+	// so the worker is the only one left touching the chunks.
+	if (stream)
+		SDL_DestroyAudioStream(stream);
+	stream = nullptr;
+	if (worker.joinable())
+	{
+		quit.store(true, std::memory_order_relaxed);
+		SDL_SignalSemaphore(freeCount);
+		worker.join();
+	}
+	if (freeCount)
+		SDL_DestroySemaphore(freeCount);
+	freeCount = nullptr;
+	if (io)
+		SDL_CloseIO(io);
+	io = nullptr;
+
+	Chunk* chunk;
+	while (ready.pop(chunk)) {}
+	while (empty.pop(chunk)) {}
+	chunks.clear();
+	quit.store(false, std::memory_order_relaxed);
+	decoded.store(0, std::memory_order_relaxed);
+	streamed.store(0, std::memory_order_relaxed);
+	underruns.store(0, std::memory_order_relaxed);
+	ended.store(false, std::memory_order_relaxed);
+	drained.store(false, std::memory_order_relaxed);
+}
+
+void MusicStream::setGain(float gain)
+{
+	settings.gain = gain;
+	if (stream)
+		SDL_SetAudioStreamGain(stream, gain);
+}
+
+bool MusicStream::parseHeader()
+{
+	char tag[4];
+	Uint32 size = 0;
+	if (!readTag(io, tag) || SDL_memcmp(tag, "RIFF", 4) != 0 || !SDL_ReadU32LE(io, &size)
+		|| !readTag(io, tag) || SDL_memcmp(tag, "WAVE", 4) != 0)
+	{
+		SDL_Log("Music is not a RIFF WAVE file");
+		return false;
+	}
+
+	bool haveFormat = false;
+	while (readTag(io, tag) && SDL_ReadU32LE(io, &size))
+	{
+		const Sint64 start = SDL_TellIO(io);
+		if (SDL_memcmp(tag, "fmt ", 4) == 0 && size >= 16)
+		{
+			Uint16 format = 0, channels = 0, blockAlign = 0, bits = 0;
+			Uint32 rate = 0, byteRate = 0;
+			SDL_ReadU16LE(io, &format);
+			SDL_ReadU16LE(io, &channels);
+			SDL_ReadU32LE(io, &rate);
+			SDL_ReadU32LE(io, &byteRate);
+			SDL_ReadU16LE(io, &blockAlign);
+			SDL_ReadU16LE(io, &bits);
+			// The real tag is the start of the sub-format GUID.
+			Uint16 extra = 0, validBits = 0;
+			Uint32 channelMask = 0;
+			if (format == FormatExtensible && size >= 40 && SDL_ReadU16LE(io, &extra)
+				&& SDL_ReadU16LE(io, &validBits) && SDL_ReadU32LE(io, &channelMask))
+				SDL_ReadU16LE(io, &format);
+			spec.format = sampleFormat(format, bits);
+			spec.channels = channels;
+			spec.freq = (int)rate;
+			if (spec.format == SDL_AUDIO_UNKNOWN || channels < 1 || channels > 8 || rate == 0)
+			{
+				SDL_Log("Music must be 8, 16 or 32-bit PCM or 32-bit float WAV (format %u, %u bits)",
+					(unsigned)format, (unsigned)bits);
+				return false;
+			}
+			haveFormat = true;
+		}
+		else if (SDL_memcmp(tag, "data", 4) == 0)
+		{
+			if (!haveFormat)
+				break;
+			// Streamed writers may leave the size unset (0 or 0xFFFFFFFF);
+			// the samples then run to the end of the file.
+			const Sint64 total = SDL_GetIOSize(io);
+			const bool unset = size == 0 || size == 0xFFFFFFFFu;
+			if (unset && total < start)
+			{
+				SDL_Log("Music data size is unset and the source length is unknown");
+				return false;
+			}
+			dataStart = start;
+			if (unset)
+				dataBytes = total - start;
+			else
+				dataBytes = total >= start ? SDL_min((Sint64)size, total - start) : (Sint64)size;
+			dataBytes -= dataBytes % SDL_AUDIO_FRAMESIZE(spec);
+			dataLeft = dataBytes;
+			if (dataBytes == 0)
+			{
+				SDL_Log("Music has no samples");
+				return false;
+			}
+			return true;
+		}
+		// Chunks are padded to an even size.
+		if (SDL_SeekIO(io, start + size + (size & 1), SDL_IO_SEEK_SET) < 0)
+			break;
+	}
+	SDL_Log("Music WAV has no %s chunk", haveFormat ? "data" : "fmt");
+	return false;
+}
+
+bool MusicStream::rewind()
+{
+	if (SDL_SeekIO(io, dataStart, SDL_IO_SEEK_SET) < 0)
+		return false;
+	dataLeft = dataBytes;
+	return true;
+}
+
+bool MusicStream::fill(Chunk& chunk)
+{
+	// A looping track continues from the start inside the same chunk.
+	chunk.bytes = 0;
+	while (chunk.bytes < chunk.data.size())
+	{
+		if (dataLeft == 0 && (!settings.loop || !rewind()))
+			break;
+		const size_t want = (size_t)SDL_min((Sint64)(chunk.data.size() - chunk.bytes), dataLeft);
+		const size_t got = SDL_ReadIO(io, chunk.data.data() + chunk.bytes, want);
+		chunk.bytes += got;
+		dataLeft -= (Sint64)got;
+		if (got < want)
+		{
+			// Truncated or failing source: end the track instead of spinning.
+			if (SDL_GetIOStatus(io) == SDL_IO_STATUS_ERROR)
+				SDL_Log("Reading music failed: %s", SDL_GetError());
+			dataLeft = 0;
+			chunk.last = true;
+			break;
+		}
+	}
+	if (dataLeft == 0 && !settings.loop)
+		chunk.last = true;
+	decoded.fetch_add(1, std::memory_order_relaxed);
+	return !chunk.last;
+}
+
+void SDLCALL MusicStream::feed(void* userdata, SDL_AudioStream* stream, int additional, int)
+{
+	MusicStream& music = *static_cast<MusicStream*>(userdata);
+	Chunk* chunk;
+	while (additional > 0 && music.ready.pop(chunk))
+	{
+		if (chunk->bytes)
+			SDL_PutAudioStreamData(stream, chunk->data.data(), (int)chunk->bytes);
+		additional -= (int)chunk->bytes;
+		music.streamed.fetch_add(chunk->bytes, std::memory_order_relaxed);
+		if (chunk->last)
+			music.drained.store(true, std::memory_order_relaxed);
+		music.empty.push(chunk);
+		SDL_SignalSemaphore(music.freeCount);
+	}
+	if (additional > 0 && !music.drained.load(std::memory_order_relaxed))
+		music.underruns.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MusicStream::workerMain()
+{
+	while (true)
+	{
+		SDL_WaitSemaphore(freeCount);
+		if (quit.load(std::memory_order_relaxed))
+			return;
+		if (ended.load(std::memory_order_relaxed))
+			continue;
+		Chunk* chunk;
+		if (!empty.pop(chunk))
+			continue;
+		chunk->last = false;
+		const bool more = fill(*chunk);
+		ready.push(chunk);
+		if (!more)
+			ended.store(true, std::memory_order_relaxed);
+	}
+}
+
+MusicStream::Stats MusicStream::stats() const
+{
+	Stats s;
+	s.chunks = decoded.load(std::memory_order_relaxed);
+	s.bytes = streamed.load(std::memory_order_relaxed);
+	s.underruns = underruns.load(std::memory_order_relaxed);
+	s.ready = (uint32_t)ready.size();
+	s.prefetchDepth = (uint32_t)chunks.size();
+	s.bufferBytes = chunks.empty() ? 0 : chunks.size() * chunks.front().data.size();
+	s.finished = drained.load(std::memory_order_relaxed);
+	return s;
+}
+
+void MusicStream::connect(EventBus& bus)
+{
+	bus.subscribe<&MusicStream::onStatsRequested>(this);
+}
+
+void MusicStream::onStatsRequested(const StatsRequested*, size_t)
+{
+	if (!isOpen())
+		return;
+	const Stats s = stats();
+	const double seconds = (double)s.bytes / (double)(SDL_AUDIO_FRAMESIZE(spec) * spec.freq);
+	SDL_Log("Music: %.1f s streamed, %llu chunks decoded, %u/%u ready, %u underruns, %.0f KB buffered%s",
+		seconds, (unsigned long long)s.chunks, s.ready, s.prefetchDepth, s.underruns, s.bufferBytes / 1024.0,
+		s.finished ? ", finished" : "");
+}
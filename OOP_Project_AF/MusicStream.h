@@ -0,0 +1,108 @@
+#pragma once
+#include "EventBus.h"
+#include "Events.h"
+#include "SpscQueue.h"
+#include <SDL3/SDL_audio.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_mutex.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Plays one long track (music, ambience) without loading it into memory.
+//
+// A worker thread reads the PCM of a WAV file chunk by chunk into a fixed
+// ring of prefetchDepth buffers; the callback of the track's own
+// SDL_AudioStream, bound to the mixer's device, moves ready chunks into the
+// stream, which converts them to the device format and is mixed by SDL next
+// to the Mixer's output. Memory is prefetchDepth * chunkFrames frames of the
+// file's format whatever the track length. The callback's own code takes
+// no locks and allocates nothing; SDL_PutAudioStreamData is SDL's, and it
+// locks the stream and may grow its queue. When the worker falls behind the
+// callback counts an underrun and the track drops out for that buffer
+// rather than stalling the device.
+class MusicStream
+{
+public:
+	static constexpr int MaxPrefetchDepth = 64;
+
+	struct Settings
+	{
+		int chunkFrames = 4096;
+		int prefetchDepth = 8;	// chunks decoded ahead, 2 .. MaxPrefetchDepth
+		bool loop = true;
+		float gain = 1.0f;
+	};
+
+	struct Stats
+	{
+		uint64_t chunks;		// decoded so far
+		uint64_t bytes;			// handed to the stream
+		uint32_t underruns;		// callbacks that found no chunk ready
+		uint32_t ready;			// chunks waiting right now
+		uint32_t prefetchDepth;
+		size_t bufferBytes;		// all chunk buffers together
+		bool finished;			// a non-looping track played out
+	};
+
+	MusicStream();
+	~MusicStream();
+
+	MusicStream(const MusicStream&) = delete;
+	MusicStream& operator=(const MusicStream&) = delete;
+
+	// Starts playing on device (Mixer::device()). Takes ownership of io,
+	// which may be a file or an archive entry opened with SDL_IOFromConstMem.
+	// Logs and returns false if it is not PCM WAV SDL can convert.
+	bool open(SDL_AudioDeviceID device, SDL_IOStream* io, const Settings& settings);
+	bool openFile(SDL_AudioDeviceID device, const char* path, const Settings& settings);
+	void close();
+	bool isOpen() const { return stream != nullptr; }
+
+	void setGain(float gain);
+	Stats stats() const;
+
+	// Subscribes onStatsRequested to bus.
+	void connect(EventBus& bus);
+	void onStatsRequested(const StatsRequested* events, size_t count);
+
+private:
+	struct Chunk
+	{
+		std::vector<uint8_t> data;
+		size_t bytes;	// valid part of data
+		bool last;		// end of a non-looping track
+	};
+
+	bool parseHeader();
+	bool rewind();
+	// Reads the next chunk; false once the track has nothing more.
+	bool fill(Chunk& chunk);
+	static void SDLCALL feed(void* userdata, SDL_AudioStream* stream, int additional, int total);
+	void workerMain();
+
+	SDL_IOStream* io;
+	SDL_AudioStream* stream;
+	SDL_AudioSpec spec;		// of the file
+	Sint64 dataStart;
+	Sint64 dataBytes;
+	Sint64 dataLeft;		// worker only
+	Settings settings;
+
+	// Chunks travel worker -> callback through ready and come back through
+	// empty; freeCount counts empty so the worker can sleep.
+	std::vector<Chunk> chunks;
+	SpscQueue<Chunk*, MaxPrefetchDepth> ready;
+	SpscQueue<Chunk*, MaxPrefetchDepth> empty;
+	SDL_Semaphore* freeCount;
+	std::atomic<bool> quit;
+	std::thread worker;
+
+	std::atomic<uint64_t> decoded;
+	std::atomic<uint64_t> streamed;
+	std::atomic<uint32_t> underruns;
+	std::atomic<bool> ended;	// set by the worker after the last chunk
+	std::atomic<bool> drained;	// set by the callback once it was played
+};
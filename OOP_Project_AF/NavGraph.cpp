@@ -0,0 +1,106 @@
+#include "NavGraph.h"
+#include <SDL3/SDL_timer.h>
+#include <utility>
+
+NavGraph::NavGraph()
+	: clusterSize(32), heuristicWeight(1.25f), live(new HierarchicalPaths()), counters(), running(false),
+	  spare(new HierarchicalPaths()), buildNs(0), requested(false), quit(false), done(false)
+{
+}
+
+NavGraph::~NavGraph()
+{
+	if (!worker.joinable())
+		return;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+	}
+	wake.notify_one();
+	worker.join();
+}
+
+NavGraph::NavGraph(const NavGraph& other)
+	: NavGraph()
+{
+	clusterSize = other.clusterSize;
+	heuristicWeight = other.heuristicWeight;
+}
+
+NavGraph& NavGraph::operator=(const NavGraph& other)
+{
+	clusterSize = other.clusterSize;
+	heuristicWeight = other.heuristicWeight;
+	return *this;
+}
+
+void NavGraph::sync(const NavGrid& grid)
+{
+	live->heuristicWeight = heuristicWeight;
+	if (running)
+	{
+		if (!done.load(std::memory_order_acquire))
+			return;
+		std::swap(live, spare);
+		live->heuristicWeight = heuristicWeight;
+		running = false;
+		++counters.builds;
+		counters.lastBuildNs = buildNs;
+	}
+	spare->clusterSize = clusterSize;
+	if (live->current(grid) && live->builtClusterSize() == spare->builtClusterSize())
+		return;
+
+	// The worker is idle, so the grid copy and the spare graph are ours.
+	mirror.follow(grid);
+	spare->heuristicWeight = heuristicWeight;
+	if (!worker.joinable())
+		worker = std::thread(&NavGraph::workerMain, this);
+	done.store(false, std::memory_order_relaxed);
+	running = true;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		requested = true;
+	}
+	wake.notify_one();
+}
+
+void NavGraph::syncNow(const NavGrid& grid)
+{
+	for (;;)
+	{
+		sync(grid);
+		if (!running)
+			return;
+		std::unique_lock<std::mutex> guard(lock);
+		finished.wait(guard, [this] { return done.load(std::memory_order_acquire); });
+	}
+}
+
+HierarchicalPaths* NavGraph::graph(const NavGrid& grid)
+{
+	return live->covers(grid) ? live.get() : nullptr;
+}
+
+void NavGraph::workerMain()
+{
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this] { return requested || quit; });
+			if (quit)
+				return;
+			requested = false;
+		}
+
+		const Uint64 started = SDL_GetTicksNS();
+		spare->sync(mirror);
+		buildNs = SDL_GetTicksNS() - started;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			done.store(true, std::memory_order_release);
+		}
+		finished.notify_all();
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include "HierarchicalPaths.h"
+#include "NavGrid.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// Keeps a HierarchicalPaths graph up to date with a NavGrid without building
+// it on the caller's thread.
+//
+// sync() runs every frame and never waits. When the grid has moved on and
+// the worker is idle, the worker gets a private copy of the grid (only the
+// edited tiles are copied) and syncs the spare of two graphs against it. The
+// next sync() after it finishes swaps the spare in. Until then graph() keeps
+// returning the previous graph. Each graph replays every edit, so the worker
+// does each relink twice (and the spare's first build is a full one), and
+// memory is two graphs plus the grid copy.
+class NavGraph
+{
+public:
+	struct Stats
+	{
+		size_t builds;		// graphs published
+		uint64_t lastBuildNs;	// worker time of the last one
+	};
+
+	NavGraph();
+	~NavGraph();
+
+	// The graphs are derived from the grid: copies start empty with the same
+	// settings and build on their first sync().
+	NavGraph(const NavGraph& other);
+	NavGraph& operator=(const NavGraph& other);
+
+	// Publishes a finished build and starts the next one if grid changed.
+	// Called by Model::update; grid must be the same NavGrid every time.
+	void sync(const NavGrid& grid);
+	// Blocks until graph() is current with grid, e.g. for tools and tests.
+	void syncNow(const NavGrid& grid);
+
+	// The newest finished graph if it covers grid, else nullptr. It may lag
+	// grid by the edits of the build in flight; see current().
+	HierarchicalPaths* graph(const NavGrid& grid);
+
+	bool building() const { return running; }
+	const Stats& stats() const { return counters; }
+
+	// Applied to the next build; heuristicWeight applies to queries at once.
+	int clusterSize;
+	float heuristicWeight;
+
+private:
+	void workerMain();
+
+	std::unique_ptr<HierarchicalPaths> live;
+	Stats counters;
+	bool running;	// a build was handed to the worker and not yet published
+
+	// Owned by the worker while running, by the main thread otherwise.
+	std::unique_ptr<HierarchicalPaths> spare;
+	NavGrid mirror;
+	uint64_t buildNs;
+
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	bool requested;
+	bool quit;
+	std::atomic<bool> done;
+};
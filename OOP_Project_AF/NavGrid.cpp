@@ -0,0 +1,86 @@
+#include "NavGrid.h"
+#include <SDL3/SDL_stdinc.h>
+
+namespace
+{
+	// Past this many entries the older half of the edit log is dropped.
+	const size_t MaxLoggedEdits = 64 * 1024;
+}
+
+NavGrid::NavGrid()
+	: w(0), h(0), tile(1.0f), edits(0), logStart(0)
+{
+}
+
+void NavGrid::resize(int width, int height, float tileSize, uint8_t cost)
+{
+	w = SDL_max(width, 0);
+	h = SDL_max(height, 0);
+	tile = tileSize;
+	costs.assign((size_t)w * (size_t)h, cost);
+	++edits;
+	editLog.clear();
+	logStart = edits;
+}
+
+void NavGrid::setCost(int x, int y, uint8_t cost)
+{
+	if (!inside(x, y) || costs[index(x, y)] == cost)
+		return;
+	costs[index(x, y)] = cost;
+	logEdit(index(x, y));
+}
+
+void NavGrid::logEdit(uint32_t tile)
+{
+	++edits;
+	if (editLog.size() == MaxLoggedEdits)
+	{
+		const size_t dropped = MaxLoggedEdits / 2;
+		editLog.erase(editLog.begin(), editLog.begin() + dropped);
+		logStart += dropped;
+	}
+	editLog.push_back(tile);
+}
+
+bool NavGrid::editsSince(uint64_t since, const uint32_t*& tiles, size_t& count) const
+{
+	if (since < logStart || since > edits)
+		return false;
+	tiles = editLog.data() + (since - logStart);
+	count = (size_t)(edits - since);
+	return true;
+}
+
+bool NavGrid::tileAt(float worldX, float worldY, int& x, int& y) const
+{
+	if (worldX < 0.0f || worldY < 0.0f)
+		return false;
+	x = (int)(worldX / tile);
+	y = (int)(worldY / tile);
+	return inside(x, y);
+}
+
+void NavGrid::assign(int width, int height, float tileSize, const uint8_t* data)
+{
+	resize(width, height, tileSize);
+	if (!costs.empty())
+		SDL_memcpy(costs.data(), data, costs.size());
+}
+
+void NavGrid::follow(const NavGrid& source)
+{
+	const uint32_t* tiles = nullptr;
+	size_t count = 0;
+	if (w != source.w || h != source.h || tile != source.tile || !source.editsSince(edits, tiles, count))
+	{
+		*this = source;
+		return;
+	}
+	// Replaying the edits keeps this grid's own log usable by editsSince.
+	for (size_t i = 0; i < count; ++i)
+	{
+		costs[tiles[i]] = source.costs[tiles[i]];
+		logEdit(tiles[i]);
+	}
+}
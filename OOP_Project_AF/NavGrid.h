@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Movement cost per tile over Model's world, row-major. Cost 0 is a wall;
+// 1..255 is the price of stepping onto the tile. version() changes on every
+// edit so cached paths and flow fields know when to rebuild.
+class NavGrid
+{
+public:
+	static const uint8_t Blocked = 0;
+
+	NavGrid();
+
+	void resize(int width, int height, float tileSize, uint8_t cost = 1);
+
+	int width() const { return w; }
+	int height() const { return h; }
+	float tileSize() const { return tile; }
+	size_t tileCount() const { return costs.size(); }
+	const uint8_t* data() const { return costs.data(); }
+
+	bool inside(int x, int y) const { return x >= 0 && y >= 0 && x < w && y < h; }
+	uint32_t index(int x, int y) const { return (uint32_t)y * (uint32_t)w + (uint32_t)x; }
+	uint8_t cost(int x, int y) const { return costs[index(x, y)]; }
+	bool passable(int x, int y) const { return inside(x, y) && costs[index(x, y)] != Blocked; }
+
+	void setCost(int x, int y, uint8_t cost);
+	uint64_t version() const { return edits; }
+
+	// Tiles edited after version since, oldest first. False when the log no
+	// longer reaches back that far (or the grid was resized): rebuild fully.
+	bool editsSince(uint64_t since, const uint32_t*& tiles, size_t& count) const;
+
+	// Tile under a world position; false outside the grid.
+	bool tileAt(float worldX, float worldY, int& x, int& y) const;
+
+	// Replaces the whole grid, e.g. from a save.
+	void assign(int width, int height, float tileSize, const uint8_t* data);
+
+	// Makes this a copy of source at source's version, for a reader on
+	// another thread. Copies only the tiles edited since the last follow()
+	// of the same source, or the whole grid when its log does not reach back.
+	void follow(const NavGrid& source);
+
+private:
+	void logEdit(uint32_t tile);
+
+	int w;
+	int h;
+	float tile;
+	std::vector<uint8_t> costs;
+	uint64_t edits;
+	// editLog[i] is the tile of edit logStart + i + 1.
+	std::vector<uint32_t> editLog;
+	uint64_t logStart;
+};
@@ -0,0 +1,228 @@
+#include "ParticleSystem.h"
+#include "Integrate.h"
+#include "JobSystem.h"
+#include <SDL3/SDL_stdinc.h>
+
+namespace
+{
+	const size_t ParticleGrain = 16 * 1024;
+	const float Unbounded = 3.0e38f;
+}
+
+ParticlePool::ParticlePool(SDL_Texture* texture, size_t capacity, SDL_BlendMode blend)
+	: texture(texture), blend(blend), capacity(capacity), count(0),
+	  posX(capacity), posY(capacity), velX(capacity), velY(capacity),
+	  age(capacity), life(capacity), size(capacity), tint(capacity),
+	  front(0), bounds(), uvs(capacity * 4), indices(capacity * 6)
+{
+	for (int b = 0; b < 2; ++b)
+	{
+		corners[b].resize(capacity * 4);
+		colors[b].resize(capacity * 4);
+	}
+	for (size_t i = 0; i < capacity; ++i)
+	{
+		SDL_FPoint* uv = &uvs[i * 4];
+		uv[0] = { 0.0f, 0.0f };
+		uv[1] = { 1.0f, 0.0f };
+		uv[2] = { 1.0f, 1.0f };
+		uv[3] = { 0.0f, 1.0f };
+
+		int* index = &indices[i * 6];
+		const int base = (int)(i * 4);
+		index[0] = base;
+		index[1] = base + 1;
+		index[2] = base + 2;
+		index[3] = base;
+		index[4] = base + 2;
+		index[5] = base + 3;
+	}
+}
+
+bool ParticlePool::spawn(float x, float y, float vx, float vy, float lifetime, float particleSize, SDL_FColor color)
+{
+	if (count == capacity)
+		return false;
+	posX[count] = x;
+	posY[count] = y;
+	velX[count] = vx;
+	velY[count] = vy;
+	age[count] = 0.0f;
+	life[count] = lifetime;
+	size[count] = particleSize;
+	tint[count] = color;
+	++count;
+	return true;
+}
+
+void ParticlePool::kill(size_t i)
+{
+	const size_t last = --count;
+	posX[i] = posX[last];
+	posY[i] = posY[last];
+	velX[i] = velX[last];
+	velY[i] = velY[last];
+	age[i] = age[last];
+	life[i] = life[last];
+	size[i] = size[last];
+	tint[i] = tint[last];
+}
+
+ParticleSystem::ParticleSystem()
+	: damping(1.0f), gravity(0.0f)
+{
+}
+
+size_t ParticleSystem::createPool(SDL_Texture* texture, size_t capacity, SDL_BlendMode blend)
+{
+	pools.emplace_back(texture, capacity, blend);
+	return pools.size() - 1;
+}
+
+size_t ParticleSystem::addEmitter(const ParticleEmitter& emitter)
+{
+	emitters.push_back(emitter);
+	emitters.back().pending = 0.0f;
+	return emitters.size() - 1;
+}
+
+size_t ParticleSystem::liveCount() const
+{
+	size_t total = 0;
+	for (const ParticlePool& pool : pools)
+		total += pool.count;
+	return total;
+}
+
+void ParticleSystem::update(float dt)
+{
+	emit(dt);
+	for (ParticlePool& pool : pools)
+	{
+		simulate(pool, dt);
+		buildVertices(pool);
+	}
+}
+
+void ParticleSystem::emit(float dt)
+{
+	for (ParticleEmitter& e : emitters)
+	{
+		if (!e.active)
+			continue;
+		ParticlePool& pool = pools[e.pool];
+		e.pending += e.rate * dt;
+		const int spawnCount = (int)e.pending;
+		e.pending -= (float)spawnCount;
+		for (int i = 0; i < spawnCount; ++i)
+		{
+			const float angle = e.direction + (SDL_randf() - 0.5f) * e.spread;
+			const float speed = e.speed * (0.5f + SDL_randf() * 0.5f);
+			if (!pool.spawn(e.x, e.y, SDL_cosf(angle) * speed, SDL_sinf(angle) * speed,
+					e.lifetime * (0.75f + SDL_randf() * 0.25f), e.size, e.color))
+			{
+				e.pending = 0.0f;
+				break;
+			}
+		}
+	}
+}
+
+void ParticleSystem::simulate(ParticlePool& pool, float dt)
+{
+	MotionParams params;
+	params.dt = dt;
+	params.damping = damping;
+	params.minX = -Unbounded;
+	params.minY = -Unbounded;
+	params.maxX = Unbounded;
+	params.maxY = Unbounded;
+	const SimdPath path = bestSimdPath();
+	const float fall = gravity * dt;
+
+	JobSystem::shared().parallelFor(pool.count, ParticleGrain, [&](size_t begin, size_t end)
+		{
+			float* velY = pool.velY.data();
+			float* age = pool.age.data();
+			for (size_t i = begin; i < end; ++i)
+			{
+				velY[i] += fall;
+				age[i] += dt;
+			}
+			integrateMotion(path, pool.posX.data(), pool.posY.data(), pool.velX.data(), velY, begin, end, params);
+		});
+
+	// Swap-remove keeps the live range dense; iterate backwards so a moved-in
+	// particle has already been checked.
+	for (size_t i = pool.count; i-- > 0;)
+	{
+		if (pool.age[i] >= pool.life[i])
+			pool.kill(i);
+	}
+}
+
+void ParticleSystem::buildVertices(ParticlePool& pool)
+{
+	pool.front ^= 1;
+	SDL_FPoint* corners = pool.corners[pool.front].data();
+	SDL_FColor* colors = pool.colors[pool.front].data();
+	JobSystem::shared().parallelFor(pool.count, ParticleGrain, [&](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; ++i)
+			{
+				const float half = pool.size[i] * 0.5f;
+				const float x = pool.posX[i];
+				const float y = pool.posY[i];
+				SDL_FPoint* corner = &corners[i * 4];
+				corner[0] = { x - half, y - half };
+				corner[1] = { x + half, y - half };
+				corner[2] = { x + half, y + half };
+				corner[3] = { x - half, y + half };
+
+				SDL_FColor color = pool.tint[i];
+				color.a *= 1.0f - pool.age[i] / pool.life[i];
+				SDL_FColor* vertexColor = &colors[i * 4];
+				vertexColor[0] = color;
+				vertexColor[1] = color;
+				vertexColor[2] = color;
+				vertexColor[3] = color;
+			}
+		});
+
+	if (pool.count == 0)
+	{
+		pool.bounds = SDL_FRect();
+		return;
+	}
+	float minX = pool.posX[0], maxX = minX;
+	float minY = pool.posY[0], maxY = minY;
+	float maxSize = 0.0f;
+	for (size_t i = 0; i < pool.count; ++i)
+	{
+		minX = SDL_min(minX, pool.posX[i]);
+		maxX = SDL_max(maxX, pool.posX[i]);
+		minY = SDL_min(minY, pool.posY[i]);
+		maxY = SDL_max(maxY, pool.posY[i]);
+		maxSize = SDL_max(maxSize, pool.size[i]);
+	}
+	const float half = maxSize * 0.5f;
+	pool.bounds = { minX - half, minY - half, maxX - minX + maxSize, maxY - minY + maxSize };
+}
+
+void ParticleSystem::record(RenderQueue& queue, uint8_t layer) const
+{
+	for (size_t i = 0; i < pools.size(); ++i)
+		recordPool(queue, i, layer);
+}
+
+void ParticleSystem::recordPool(RenderQueue& queue, size_t i, uint8_t layer) const
+{
+	const ParticlePool& pool = pools[i];
+	if (pool.count == 0)
+		return;
+	queue.geometry(layer, pool.texture, pool.blend, 0.0f,
+		&pool.corners[pool.front][0].x, sizeof(SDL_FPoint),
+		pool.colors[pool.front].data(), sizeof(SDL_FColor),
+		&pool.uvs[0].x, sizeof(SDL_FPoint),
+		(int)(pool.count * 4), pool.indices.data(), (int)(pool.count * 6));
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "RenderQueue.h"
+#include <SDL3/SDL_render.h>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Fixed-capacity particle storage for one texture. Simulation state lives in
+// SoA columns; the quad vertices and colours the renderer needs are kept
+// beside them, so a whole pool is one RenderQueue geometry command (one
+// SDL_RenderGeometryRaw call) reading straight out of these arrays. Dead
+// particles are swap-removed.
+struct ParticlePool
+{
+	explicit ParticlePool(SDL_Texture* texture, size_t capacity, SDL_BlendMode blend);
+
+	SDL_Texture* texture;
+	SDL_BlendMode blend;
+	size_t capacity;
+	size_t count;
+
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> velX;
+	std::vector<float> velY;
+	std::vector<float> age;
+	std::vector<float> life;
+	std::vector<float> size;
+	std::vector<SDL_FColor> tint;
+
+	// Four vertices per particle, rebuilt after every update. Double-buffered
+	// so the render thread can draw one frame while the next is built.
+	std::vector<SDL_FPoint> corners[2];
+	std::vector<SDL_FColor> colors[2];
+	int front;
+	SDL_FRect bounds;	// covers every live quad as of the last update
+	// Constant for the pool's lifetime.
+	std::vector<SDL_FPoint> uvs;
+	std::vector<int> indices;
+
+	bool spawn(float x, float y, float vx, float vy, float lifetime, float particleSize, SDL_FColor color);
+	void kill(size_t i);
+};
+
+struct ParticleEmitter
+{
+	size_t pool;
+	float x;
+	float y;
+	float rate;	// particles per second
+	float speed;
+	float spread;	// radians around direction
+	float direction;
+	float lifetime;
+	float size;
+	SDL_FColor color;
+	bool active;
+
+	float pending;	// fractional particles carried to the next frame
+};
+
+class ParticleSystem
+{
+public:
+	ParticleSystem();
+
+	size_t createPool(SDL_Texture* texture, size_t capacity, SDL_BlendMode blend = SDL_BLENDMODE_ADD);
+	size_t addEmitter(const ParticleEmitter& emitter);
+	ParticleEmitter& emitter(size_t i) { return emitters[i]; }
+	ParticlePool& pool(size_t i) { return pools[i]; }
+	const ParticlePool& pool(size_t i) const { return pools[i]; }
+	size_t poolCount() const { return pools.size(); }
+
+	void update(float dt);
+	void record(RenderQueue& queue, uint8_t layer) const;
+	void recordPool(RenderQueue& queue, size_t i, uint8_t layer) const;
+
+	size_t liveCount() const;
+
+	float damping;
+	float gravity;
+
+private:
+	void emit(float dt);
+	void simulate(ParticlePool& pool, float dt);
+	void buildVertices(ParticlePool& pool);
+
+	std::vector<ParticlePool> pools;
+	std::vector<ParticleEmitter> emitters;
+};
@@ -0,0 +1,392 @@
+#include "PathService.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+#include <functional>
+
+namespace
+{
+	// Nodes expanded between deadline checks.
+	const size_t ExpandBatch = 256;
+
+	// update() calls between sweeps for unpolled results.
+	const uint64_t ExpirySweep = 64;
+
+	// Step costs are tile cost times 10 straight or 14 diagonal, so the
+	// octile heuristic with the minimum tile cost of 1 stays admissible.
+	const uint32_t Straight = 10;
+	const uint32_t Diagonal = 14;
+}
+
+PathService::PathService()
+	: budgetNs(1000000), cacheCapacity(1024), fieldCapacity(4), coarseRange(64), resultTicks(600), nextTicket(1),
+	  useClock(0), updates(0), counters(), searching(false), refining(false), active(), activeVersion(0),
+	  routeGraph(nullptr), routeFresh(false), hop(0), width(0), goalX(0), goalY(0), searchStamp(0)
+{
+}
+
+PathService::PathService(const PathService& other)
+	: PathService()
+{
+	budgetNs = other.budgetNs;
+	cacheCapacity = other.cacheCapacity;
+	fieldCapacity = other.fieldCapacity;
+	coarseRange = other.coarseRange;
+	resultTicks = other.resultTicks;
+}
+
+PathService& PathService::operator=(const PathService& other)
+{
+	budgetNs = other.budgetNs;
+	cacheCapacity = other.cacheCapacity;
+	fieldCapacity = other.fieldCapacity;
+	coarseRange = other.coarseRange;
+	resultTicks = other.resultTicks;
+	return *this;
+}
+
+uint32_t PathService::request(const NavGrid& grid, int startX, int startY, int goalX, int goalY)
+{
+	const uint32_t ticket = nextTicket++;
+	if (nextTicket == 0)
+		nextTicket = 1;
+
+	results[ticket].path.clear();
+	if (!grid.passable(startX, startY) || !grid.passable(goalX, goalY))
+	{
+		finish(ticket, Status::NotFound);
+		return ticket;
+	}
+	const uint32_t start = grid.index(startX, startY);
+	const uint32_t goal = grid.index(goalX, goalY);
+	if (const std::vector<uint32_t>* path = cached(grid, start, goal))
+	{
+		finish(ticket, Status::Found).path = *path;
+		return ticket;
+	}
+	results[ticket].status = Status::Pending;
+	queue.push_back(Request{ ticket, start, goal });
+	return ticket;
+}
+
+PathService::Status PathService::poll(uint32_t ticket, std::vector<uint32_t>& path)
+{
+	std::unordered_map<uint32_t, Result>::iterator it = results.find(ticket);
+	if (it == results.end())
+		return Status::Unknown;
+	const Status status = it->second.status;
+	if (status != Status::Pending)
+	{
+		path.swap(it->second.path);
+		results.erase(it);
+	}
+	return status;
+}
+
+bool PathService::cancel(uint32_t ticket)
+{
+	std::unordered_map<uint32_t, Result>::iterator it = results.find(ticket);
+	if (it == results.end())
+		return false;
+	if (it->second.status == Status::Pending)
+	{
+		if ((searching || refining) && active.ticket == ticket)
+			searching = refining = false;
+		else
+			queue.erase(std::find_if(queue.begin(), queue.end(),
+				[ticket](const Request& request) { return request.ticket == ticket; }));
+	}
+	results.erase(it);
+	return true;
+}
+
+PathService::Result& PathService::finish(uint32_t ticket, Status status)
+{
+	Result& result = results[ticket];
+	result.status = status;
+	result.finishedAt = updates;
+	return result;
+}
+
+void PathService::expire()
+{
+	for (std::unordered_map<uint32_t, Result>::iterator it = results.begin(); it != results.end();)
+	{
+		if (it->second.status != Status::Pending && updates - it->second.finishedAt >= resultTicks)
+			it = results.erase(it);
+		else
+			++it;
+	}
+}
+
+const std::vector<uint32_t>* PathService::cached(const NavGrid& grid, uint32_t start, uint32_t goal)
+{
+	std::unordered_map<uint64_t, CachedPath>::iterator it = cache.find(key(start, goal));
+	if (it == cache.end())
+		return nullptr;
+	if (it->second.version != grid.version())
+	{
+		cache.erase(it);
+		return nullptr;
+	}
+	it->second.lastUse = ++useClock;
+	++counters.cacheHits;
+	return &it->second.path;
+}
+
+void PathService::store(const NavGrid& grid, uint32_t start, uint32_t goal, const std::vector<uint32_t>& path)
+{
+	if (cacheCapacity == 0)
+		return;
+	if (cache.size() >= cacheCapacity)
+	{
+		// Capacity is small, so a scan for the oldest entry is fine.
+		std::unordered_map<uint64_t, CachedPath>::iterator oldest = cache.begin();
+		for (std::unordered_map<uint64_t, CachedPath>::iterator it = cache.begin(); it != cache.end(); ++it)
+			if (it->second.lastUse < oldest->second.lastUse)
+				oldest = it;
+		cache.erase(oldest);
+	}
+	CachedPath& entry = cache[key(start, goal)];
+	entry.version = grid.version();
+	entry.lastUse = ++useClock;
+	entry.path = path;
+}
+
+void PathService::update(const NavGrid& grid, HierarchicalPaths* coarse)
+{
+	if (++updates % ExpirySweep == 0 && resultTicks && !results.empty())
+		expire();
+	if (!searching && !refining && queue.empty())
+		return;
+	++counters.slices;
+	const Uint64 deadline = SDL_GetTicksNS() + budgetNs;
+	do
+	{
+		if (refining)
+		{
+			// A new graph or an edit may invalidate the rest of the route.
+			if (routeGraph != coarse || activeVersion != grid.version())
+			{
+				refining = false;
+				if (!coarse || !coarse->covers(grid) || !beginRoute(grid, *coarse))
+				{
+					results[active.ticket].path.clear();
+					begin(grid);
+				}
+				continue;
+			}
+			refine(grid);
+			continue;
+		}
+		if (!searching)
+		{
+			if (queue.empty())
+				break;
+			active = queue.front();
+			queue.pop_front();
+			// An identical request may have been answered since it queued.
+			if (const std::vector<uint32_t>* path = cached(grid, active.start, active.goal))
+			{
+				finish(active.ticket, Status::Found).path = *path;
+				continue;
+			}
+			if (coarse && coarse->covers(grid) && span(grid, active.start, active.goal) >= coarseRange
+				&& beginRoute(grid, *coarse))
+				continue;
+			begin(grid);
+		}
+		else if (activeVersion != grid.version())
+			begin(grid);
+
+		if (expand(grid, ExpandBatch))
+			searching = false;
+	} while (SDL_GetTicksNS() < deadline);
+}
+
+bool PathService::beginRoute(const NavGrid& grid, HierarchicalPaths& coarse)
+{
+	const bool fresh = coarse.current(grid);
+	if (!coarse.findWaypoints(grid, active.start, active.goal, route))
+	{
+		// Only a current graph can tell that the goal is unreachable.
+		if (!fresh)
+			return false;
+		finish(active.ticket, Status::NotFound);
+		++counters.coarse;
+		return true;
+	}
+	results[active.ticket].path.assign(1, route[0]);
+	routeGraph = &coarse;
+	routeFresh = fresh;
+	activeVersion = grid.version();
+	hop = 1;
+	refining = true;
+	return true;
+}
+
+void PathService::refine(const NavGrid& grid)
+{
+	Result& result = results[active.ticket];
+	if (hop < route.size() && routeGraph->refineHop(grid, route[hop - 1], route[hop], result.path))
+	{
+		++hop;
+		return;
+	}
+	refining = false;
+	if (hop < route.size())
+	{
+		result.path.clear();
+		if (!routeFresh)
+		{
+			begin(grid);
+			return;
+		}
+		finish(active.ticket, Status::NotFound);
+	}
+	else
+	{
+		finish(active.ticket, Status::Found);
+		if (routeFresh)
+			store(grid, active.start, active.goal, result.path);
+	}
+	++counters.coarse;
+}
+
+void PathService::begin(const NavGrid& grid)
+{
+	const size_t count = grid.tileCount();
+	if (stamp.size() != count)
+	{
+		g.resize(count);
+		from.resize(count);
+		stamp.assign(count, 0);
+		searchStamp = 0;
+	}
+	if (++searchStamp == 0)
+	{
+		std::fill(stamp.begin(), stamp.end(), 0);
+		searchStamp = 1;
+	}
+
+	width = grid.width();
+	goalX = (int)(active.goal % (uint32_t)width);
+	goalY = (int)(active.goal / (uint32_t)width);
+	activeVersion = grid.version();
+	searching = true;
+	++counters.searches;
+
+	open.clear();
+	g[active.start] = 0;
+	from[active.start] = active.start;
+	stamp[active.start] = searchStamp;
+	open.push_back(((uint64_t)heuristic(active.start) << 32) | active.start);
+}
+
+int PathService::span(const NavGrid& grid, uint32_t start, uint32_t goal)
+{
+	const uint32_t w = (uint32_t)grid.width();
+	return SDL_max(SDL_abs((int)(start % w) - (int)(goal % w)), SDL_abs((int)(start / w) - (int)(goal / w)));
+}
+
+uint32_t PathService::heuristic(uint32_t tile) const
+{
+	const int dx = SDL_abs((int)(tile % (uint32_t)width) - goalX);
+	const int dy = SDL_abs((int)(tile / (uint32_t)width) - goalY);
+	const uint32_t lo = (uint32_t)SDL_min(dx, dy);
+	const uint32_t hi = (uint32_t)SDL_max(dx, dy);
+	return Straight * hi + (Diagonal - Straight) * lo;
+}
+
+bool PathService::expand(const NavGrid& grid, size_t maxNodes)
+{
+	const uint8_t* costs = grid.data();
+	const int w = grid.width();
+	const int h = grid.height();
+	for (size_t n = 0; n < maxNodes; ++n)
+	{
+		if (open.empty())
+		{
+			finish(active.ticket, Status::NotFound);
+			return true;
+		}
+		std::pop_heap(open.begin(), open.end(), std::greater<uint64_t>());
+		const uint64_t top = open.back();
+		open.pop_back();
+		const uint32_t tile = (uint32_t)top;
+		// Lazy deletion: skip entries superseded by a cheaper route.
+		if ((uint32_t)(top >> 32) != g[tile] + heuristic(tile))
+			continue;
+		++counters.expanded;
+
+		if (tile == active.goal)
+		{
+			Result& result = finish(active.ticket, Status::Found);
+			result.path.clear();
+			for (uint32_t t = tile; t != active.start; t = from[t])
+				result.path.push_back(t);
+			result.path.push_back(active.start);
+			std::reverse(result.path.begin(), result.path.end());
+			store(grid, active.start, active.goal, result.path);
+			return true;
+		}
+
+		const int x = (int)(tile % (uint32_t)w);
+		const int y = (int)(tile / (uint32_t)w);
+		for (int dir = 0; dir < 8; ++dir)
+		{
+			const int nx = x + FlowField::OffsetX[dir];
+			const int ny = y + FlowField::OffsetY[dir];
+			if (nx < 0 || ny < 0 || nx >= w || ny >= h)
+				continue;
+			const uint32_t next = (uint32_t)ny * (uint32_t)w + (uint32_t)nx;
+			if (costs[next] == NavGrid::Blocked)
+				continue;
+			if ((dir & 1) && (costs[(uint32_t)y * w + nx] == NavGrid::Blocked
+				|| costs[(uint32_t)ny * w + x] == NavGrid::Blocked))
+				continue;
+			const uint32_t ng = g[tile] + costs[next] * ((dir & 1) ? Diagonal : Straight);
+			if (stamp[next] == searchStamp && ng >= g[next])
+				continue;
+			stamp[next] = searchStamp;
+			g[next] = ng;
+			from[next] = tile;
+			open.push_back(((uint64_t)(ng + heuristic(next)) << 32) | next);
+			std::push_heap(open.begin(), open.end(), std::greater<uint64_t>());
+		}
+	}
+	return false;
+}
+
+const FlowField& PathService::flowField(const NavGrid& grid, int goalX, int goalY)
+{
+	CachedField* slot = nullptr;
+	for (std::unique_ptr<CachedField>& entry : fields)
+	{
+		if (entry->field.goalX() == goalX && entry->field.goalY() == goalY)
+		{
+			slot = entry.get();
+			break;
+		}
+	}
+	if (!slot)
+	{
+		if (fields.size() < SDL_max(fieldCapacity, (size_t)1))
+		{
+			fields.emplace_back(new CachedField());
+			slot = fields.back().get();
+		}
+		else
+		{
+			slot = fields[0].get();
+			for (std::unique_ptr<CachedField>& entry : fields)
+				if (entry->lastUse < slot->lastUse)
+					slot = entry.get();
+		}
+		slot->field.build(grid, goalX, goalY);
+	}
+	else if (slot->field.gridVersion() != grid.version())
+		slot->field.build(grid, goalX, goalY);
+	slot->lastUse = ++useClock;
+	return slot->field;
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include "FlowField.h"
+#include "HierarchicalPaths.h"
+#include "NavGrid.h"
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Pathfinding for Model agents over a NavGrid.
+//   - Crowds heading to one goal share a FlowField from flowField().
+//   - Single agents request() an A* path and poll() for it. Searches run in
+//     update() under a time budget and resume across frames; finished paths
+//     are cached by (start, goal) until the grid is edited.
+//   - Requests spanning at least coarseRange tiles are routed through a
+//     HierarchicalPaths graph instead, when update() is given one. The route
+//     is refined into tiles one hop per step of the same time slice, so a
+//     long path takes several frames rather than one long query. A graph
+//     lagging behind the grid is still used; where the edits since break a
+//     hop the request falls back to flat A*. Only paths from a current
+//     graph are cached.
+class PathService
+{
+public:
+	enum class Status { Pending, Found, NotFound, Unknown };
+
+	struct Stats
+	{
+		size_t searches;	// A* runs started
+		size_t coarse;		// requests answered by the hierarchical graph
+		size_t cacheHits;
+		size_t expanded;	// nodes popped, all searches
+		size_t slices;		// update() calls that did work
+	};
+
+	PathService();
+
+	// Caches and search state are scratch: copies start empty with the same
+	// settings.
+	PathService(const PathService& other);
+	PathService& operator=(const PathService& other);
+
+	// Tickets are never 0. A cached path is Found immediately.
+	uint32_t request(const NavGrid& grid, int startX, int startY, int goalX, int goalY);
+	// Found and NotFound hand over the result and retire the ticket. A result
+	// left unpolled for resultTicks update() calls is dropped in a later
+	// sweep, and its ticket then polls Unknown.
+	Status poll(uint32_t ticket, std::vector<uint32_t>& path);
+	// Drops a request whether queued, searching or finished; false if the
+	// ticket is unknown.
+	bool cancel(uint32_t ticket);
+
+	// Runs queued searches for at most budgetNs. Called by Model::update.
+	void update(const NavGrid& grid, HierarchicalPaths* coarse = nullptr);
+
+	// Built on first use and whenever the grid changed since; the least
+	// recently used field is recycled beyond fieldCapacity goals.
+	const FlowField& flowField(const NavGrid& grid, int goalX, int goalY);
+
+	const Stats& stats() const { return counters; }
+
+	uint64_t budgetNs;
+	size_t cacheCapacity;
+	size_t fieldCapacity;
+	int coarseRange;	// in tiles, the larger of the x and y distance
+	uint64_t resultTicks;	// 0 keeps unpolled results forever
+
+private:
+	struct Request
+	{
+		uint32_t ticket;
+		uint32_t start;
+		uint32_t goal;
+	};
+
+	struct Result
+	{
+		Status status;
+		uint64_t finishedAt;	// updates when status left Pending
+		std::vector<uint32_t> path;
+	};
+
+	struct CachedPath
+	{
+		uint64_t version;
+		uint64_t lastUse;
+		std::vector<uint32_t> path;
+	};
+
+	struct CachedField
+	{
+		uint64_t lastUse;
+		FlowField field;
+	};
+
+	Result& finish(uint32_t ticket, Status status);
+	void expire();
+
+	static uint64_t key(uint32_t start, uint32_t goal) { return ((uint64_t)start << 32) | goal; }
+	const std::vector<uint32_t>* cached(const NavGrid& grid, uint32_t start, uint32_t goal);
+	void store(const NavGrid& grid, uint32_t start, uint32_t goal, const std::vector<uint32_t>& path);
+
+	void begin(const NavGrid& grid);
+	// Routes the active request through coarse. False if it must fall back
+	// to flat A*.
+	bool beginRoute(const NavGrid& grid, HierarchicalPaths& coarse);
+	// Refines the next hop of the route, or finishes the request after the
+	// last one.
+	void refine(const NavGrid& grid);
+	// Expands up to maxNodes; returns true once the active search finished.
+	bool expand(const NavGrid& grid, size_t maxNodes);
+	uint32_t heuristic(uint32_t tile) const;
+	static int span(const NavGrid& grid, uint32_t start, uint32_t goal);
+
+	uint32_t nextTicket;
+	uint64_t useClock;
+	uint64_t updates;
+	Stats counters;
+	std::deque<Request> queue;
+	std::unordered_map<uint32_t, Result> results;
+	std::unordered_map<uint64_t, CachedPath> cache;
+	std::vector<std::unique_ptr<CachedField>> fields;
+
+	// The search in progress, if searching, or the route being refined, if
+	// refining.
+	bool searching;
+	bool refining;
+	Request active;
+	uint64_t activeVersion;
+	HierarchicalPaths* routeGraph;
+	bool routeFresh;	// routeGraph was current when the route was found
+	size_t hop;			// next waypoint to refine up to
+	std::vector<uint32_t> route;
+	int width;
+	int goalX;
+	int goalY;
+	std::vector<uint64_t> open;	// min-heap of (f << 32 | tile)
+	std::vector<uint32_t> g;
+	std::vector<uint32_t> from;
+	std::vector<uint32_t> stamp;	// g and from are valid where stamp == searchStamp
+	uint32_t searchStamp;
+};
@@ -0,0 +1,245 @@
+#include "RenderQueue.h"
+#include <SDL3/SDL_stdinc.h>
+#include <cstring>
+
+namespace
+{
+	const int LayerShift = 56;
+	const int BlendShift = 53;
+	const int TextureShift = 32;
+	const int DepthShift = 8;
+	const uint64_t TextureMask = (1u << 21) - 1;
+	const uint64_t DepthMax = (1u << 24) - 1;
+
+	uint64_t blendIndex(SDL_BlendMode blend)
+	{
+		switch (blend)
+		{
+		case SDL_BLENDMODE_NONE: return 0;
+		case SDL_BLENDMODE_BLEND: return 1;
+		case SDL_BLENDMODE_BLEND_PREMULTIPLIED: return 2;
+		case SDL_BLENDMODE_ADD: return 3;
+		case SDL_BLENDMODE_ADD_PREMULTIPLIED: return 4;
+		case SDL_BLENDMODE_MOD: return 5;
+		case SDL_BLENDMODE_MUL: return 6;
+		default: return 7;
+		}
+	}
+}
+
+RenderQueue::RenderQueue()
+	: frameStats(), sorted(false)
+{
+}
+
+void RenderQueue::clear()
+{
+	commands.clear();
+	geometries.clear();
+	keys.clear();
+	// Ids only have to be consistent within a frame; assigning them afresh
+	// keeps released textures out of the map and a reused address from
+	// inheriting a stale id. The map keeps its buckets, so this is cheap.
+	textureIds.clear();
+	sorted = false;
+}
+
+uint32_t RenderQueue::textureId(SDL_Texture* texture)
+{
+	if (!texture)
+		return 0;
+	auto found = textureIds.find(texture);
+	if (found != textureIds.end())
+		return found->second;
+	// Wrap-around past TextureMask textures in one frame only costs sorting
+	// quality.
+	const uint32_t id = (uint32_t)((textureIds.size() + 1) & TextureMask);
+	textureIds.emplace(texture, id);
+	return id;
+}
+
+uint64_t RenderQueue::makeKey(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth)
+{
+	const uint64_t quantised = (uint64_t)(SDL_clamp(depth, 0.0f, 1.0f) * (float)DepthMax);
+	return ((uint64_t)layer << LayerShift)
+		| (blendIndex(blend) << BlendShift)
+		| ((uint64_t)textureId(texture) << TextureShift)
+		| (quantised << DepthShift);
+}
+
+void RenderQueue::quad(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+	const SDL_FRect& dst, SDL_FColor color)
+{
+	const SDL_FRect full = { 0.0f, 0.0f, 1.0f, 1.0f };
+	quad(layer, texture, blend, depth, dst, full, color);
+}
+
+void RenderQueue::quad(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+	const SDL_FRect& dst, const SDL_FRect& uv, SDL_FColor color)
+{
+	Command command;
+	command.kind = Kind::Quad;
+	command.texture = texture;
+	command.blend = blend;
+	command.color = color;
+	command.dst = dst;
+	command.uv = uv;
+	command.geometry = 0;
+	commands.push_back(command);
+	keys.push_back(makeKey(layer, texture, blend, depth));
+}
+
+void RenderQueue::geometry(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+	const float* xy, int xyStride, const SDL_FColor* color, int colorStride,
+	const float* uv, int uvStride, int vertexCount, const int* indices, int indexCount)
+{
+	Geometry g = { xy, xyStride, color, colorStride, uv, uvStride, vertexCount, indices, indexCount };
+	geometries.push_back(g);
+
+	Command command = {};
+	command.kind = Kind::Geometry;
+	command.texture = texture;
+	command.blend = blend;
+	command.geometry = (uint32_t)(geometries.size() - 1);
+	commands.push_back(command);
+	keys.push_back(makeKey(layer, texture, blend, depth));
+}
+
+size_t RenderQueue::countStateChanges(const uint32_t* sequence) const
+{
+	size_t changes = 0;
+	for (size_t i = 1; i < commands.size(); ++i)
+	{
+		const Command& a = commands[sequence ? sequence[i - 1] : i - 1];
+		const Command& b = commands[sequence ? sequence[i] : i];
+		if (a.texture != b.texture || a.blend != b.blend)
+			++changes;
+	}
+	return changes;
+}
+
+void RenderQueue::sort()
+{
+	const size_t n = commands.size();
+	sortedKeys.assign(keys.begin(), keys.end());
+	order.resize(n);
+	for (size_t i = 0; i < n; ++i)
+		order[i] = (uint32_t)i;
+	frameStats.commands = n;
+	frameStats.drawCalls = 0;
+	frameStats.stateChangesRecorded = countStateChanges(nullptr);
+
+	// LSD radix sort, 8 bits per pass. All histograms are built in one read
+	// and passes whose digit is constant across the frame are skipped, which
+	// is most of them (unused low byte, few layers and blend modes).
+	size_t histogram[8][256];
+	std::memset(histogram, 0, sizeof(histogram));
+	for (size_t i = 0; i < n; ++i)
+	{
+		for (int pass = 0; pass < 8; ++pass)
+			++histogram[pass][(sortedKeys[i] >> (pass * 8)) & 0xff];
+	}
+
+	keyScratch.resize(n);
+	orderScratch.resize(n);
+	for (int pass = 0; pass < 8; ++pass)
+	{
+		const int shift = pass * 8;
+		if (n == 0 || histogram[pass][(sortedKeys[0] >> shift) & 0xff] == n)
+			continue;
+
+		size_t offset[256];
+		size_t sum = 0;
+		for (int d = 0; d < 256; ++d)
+		{
+			offset[d] = sum;
+			sum += histogram[pass][d];
+		}
+		for (size_t i = 0; i < n; ++i)
+		{
+			const size_t at = offset[(sortedKeys[i] >> shift) & 0xff]++;
+			keyScratch[at] = sortedKeys[i];
+			orderScratch[at] = order[i];
+		}
+		sortedKeys.swap(keyScratch);
+		order.swap(orderScratch);
+	}
+
+	frameStats.stateChangesSorted = countStateChanges(order.data());
+	sorted = true;
+}
+
+void RenderQueue::flushQuads(SDL_Renderer* renderer, SDL_Texture* texture)
+{
+	if (vertices.empty())
+		return;
+	const size_t quads = vertices.size() / 4;
+	if (quadIndices.size() < quads * 6)
+	{
+		const size_t first = quadIndices.size() / 6;
+		quadIndices.resize(quads * 6);
+		for (size_t q = first; q < quads; ++q)
+		{
+			const int base = (int)(q * 4);
+			int* index = &quadIndices[q * 6];
+			index[0] = base;
+			index[1] = base + 1;
+			index[2] = base + 2;
+			index[3] = base;
+			index[4] = base + 2;
+			index[5] = base + 3;
+		}
+	}
+	SDL_RenderGeometry(renderer, texture, vertices.data(), (int)vertices.size(),
+		quadIndices.data(), (int)(quads * 6));
+	++frameStats.drawCalls;
+	vertices.clear();
+}
+
+void RenderQueue::submit(SDL_Renderer* renderer)
+{
+	if (!sorted)
+		sort();
+
+	SDL_Texture* batchTexture = nullptr;
+	SDL_BlendMode batchBlend = SDL_BLENDMODE_INVALID;
+	for (uint32_t index : order)
+	{
+		const Command& c = commands[index];
+		const bool compatible = c.kind == Kind::Quad && !vertices.empty()
+			&& c.texture == batchTexture && c.blend == batchBlend;
+		if (!compatible)
+		{
+			flushQuads(renderer, batchTexture);
+			batchTexture = c.texture;
+			batchBlend = c.blend;
+			if (c.texture)
+				SDL_SetTextureBlendMode(c.texture, c.blend);
+			else
+				SDL_SetRenderDrawBlendMode(renderer, c.blend);
+		}
+
+		if (c.kind == Kind::Geometry)
+		{
+			const Geometry& g = geometries[c.geometry];
+			SDL_RenderGeometryRaw(renderer, c.texture, g.xy, g.xyStride, g.color, g.colorStride,
+				g.uv, g.uvStride, g.vertexCount, g.indices, g.indexCount, sizeof(int));
+			++frameStats.drawCalls;
+			continue;
+		}
+
+		const float x0 = c.dst.x;
+		const float y0 = c.dst.y;
+		const float x1 = c.dst.x + c.dst.w;
+		const float y1 = c.dst.y + c.dst.h;
+		const float u0 = c.uv.x;
+		const float v0 = c.uv.y;
+		const float u1 = c.uv.x + c.uv.w;
+		const float v1 = c.uv.y + c.uv.h;
+		vertices.push_back({ { x0, y0 }, c.color, { u0, v0 } });
+		vertices.push_back({ { x1, y0 }, c.color, { u1, v0 } });
+		vertices.push_back({ { x1, y1 }, c.color, { u1, v1 } });
+		vertices.push_back({ { x0, y1 }, c.color, { u0, v1 } });
+	}
+	flushQuads(renderer, batchTexture);
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <SDL3/SDL_render.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Per-frame draw command buffer. Commands are recorded in whatever order the
+// caller walks the scene, tagged with a 64-bit sort key
+//   [63..56 layer][55..53 blend][52..32 texture][31..8 depth][7..0 unused]
+// then radix-sorted once and submitted with adjacent compatible commands
+// merged into a single SDL call.
+class RenderQueue
+{
+public:
+	struct Stats
+	{
+		size_t commands;
+		size_t drawCalls;
+		size_t stateChangesRecorded;	// texture/blend switches in record order
+		size_t stateChangesSorted;	// the same after sorting
+	};
+
+	RenderQueue();
+
+	void clear();
+
+	// depth is in [0, 1], smaller drawn first within a layer/blend/texture.
+	void quad(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+		const SDL_FRect& dst, SDL_FColor color);
+	void quad(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+		const SDL_FRect& dst, const SDL_FRect& uv, SDL_FColor color);
+
+	// Pre-built geometry, forwarded to SDL_RenderGeometryRaw as-is. The
+	// arrays must stay valid until submit().
+	void geometry(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth,
+		const float* xy, int xyStride, const SDL_FColor* color, int colorStride,
+		const float* uv, int uvStride, int vertexCount, const int* indices, int indexCount);
+
+	void sort();
+	// May be called several times per sort, e.g. once per clip rectangle;
+	// draw calls accumulate in stats until the next sort.
+	void submit(SDL_Renderer* renderer);
+
+	const Stats& stats() const { return frameStats; }
+	size_t size() const { return commands.size(); }
+
+private:
+	enum class Kind : uint8_t { Quad, Geometry };
+
+	struct Command
+	{
+		Kind kind;
+		SDL_Texture* texture;
+		SDL_BlendMode blend;
+		SDL_FColor color;
+		SDL_FRect dst;
+		SDL_FRect uv;
+		uint32_t geometry;
+	};
+
+	struct Geometry
+	{
+		const float* xy;
+		int xyStride;
+		const SDL_FColor* color;
+		int colorStride;
+		const float* uv;
+		int uvStride;
+		int vertexCount;
+		const int* indices;
+		int indexCount;
+	};
+
+	uint64_t makeKey(uint8_t layer, SDL_Texture* texture, SDL_BlendMode blend, float depth);
+	uint32_t textureId(SDL_Texture* texture);
+	size_t countStateChanges(const uint32_t* order) const;
+	void flushQuads(SDL_Renderer* renderer, SDL_Texture* texture);
+
+	std::vector<Command> commands;
+	std::vector<Geometry> geometries;
+	std::vector<uint64_t> keys;
+	std::vector<uint64_t> sortedKeys;
+	std::vector<uint32_t> order;
+	std::vector<uint64_t> keyScratch;
+	std::vector<uint32_t> orderScratch;
+
+	std::unordered_map<SDL_Texture*, uint32_t> textureIds;
+
+	std::vector<SDL_Vertex> vertices;
+	std::vector<int> quadIndices;
+
+	Stats frameStats;
+	bool sorted;
+};
@@ -0,0 +1,274 @@
+#include "RenderThread.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+#include <cstring>
+
+RenderThread::RenderThread(SDL_Renderer* renderer, bool threaded)
+	: renderer(renderer), appliedVSync(SDL_RENDERER_VSYNC_DISABLED), target(nullptr), recording(nullptr),
+	  pendingCount(nullptr), availableCount(nullptr), presentedAt(0), submitDuration(0)
+{
+	for (RenderFrame& frame : frames)
+	{
+		frame.clearColor = { 0, 0, 0, 255 };
+		frame.vsync = SDL_RENDERER_VSYNC_DISABLED;
+		frame.incremental = false;
+		frame.showDirty = false;
+		frame.width = 0;
+		frame.height = 0;
+		frame.zoom = 1.0f;
+		frame.origin = { 0.0f, 0.0f };
+		frame.light.target = nullptr;
+		available.push(&frame);
+	}
+	if (threaded)
+	{
+		pendingCount = SDL_CreateSemaphore(0);
+		availableCount = SDL_CreateSemaphore((Uint32)FrameCount);
+		worker = std::thread(&RenderThread::workerMain, this);
+	}
+}
+
+RenderThread::~RenderThread()
+{
+	if (worker.joinable())
+	{
+		// A null frame asks the worker to stop after draining what is queued.
+		pending.push(nullptr);
+		SDL_SignalSemaphore(pendingCount);
+		worker.join();
+		SDL_DestroySemaphore(pendingCount);
+		SDL_DestroySemaphore(availableCount);
+	}
+	if (target)
+		SDL_DestroyTexture(target);
+}
+
+RenderFrame& RenderThread::beginFrame()
+{
+	if (availableCount)
+		SDL_WaitSemaphore(availableCount);
+	available.pop(recording);
+	recording->queue.clear();
+	recording->lights.clear();
+	recording->light.target = nullptr;
+	return *recording;
+}
+
+void RenderThread::endFrame()
+{
+	RenderFrame* frame = recording;
+	recording = nullptr;
+	if (!worker.joinable())
+	{
+		submit(*frame);
+		available.push(frame);
+		return;
+	}
+	pending.push(frame);
+	SDL_SignalSemaphore(pendingCount);
+}
+
+void RenderThread::submit(RenderFrame& frame)
+{
+	const Uint64 start = SDL_GetTicksNS();
+	if (frame.vsync != appliedVSync)
+	{
+		if (!SDL_SetRenderVSync(renderer, frame.vsync))
+		{
+			// Adaptive vsync is optional; fall back to regular vsync.
+			SDL_Log("SDL_SetRenderVSync(%d) failed: %s", frame.vsync, SDL_GetError());
+			if (frame.vsync == SDL_RENDERER_VSYNC_ADAPTIVE)
+				SDL_SetRenderVSync(renderer, 1);
+		}
+		appliedVSync = frame.vsync;
+	}
+
+	applyTextures(frame);
+	if (frame.light.target && !frame.incremental)
+		submitLights(frame);
+	frame.queue.sort();
+	if (frame.incremental && ensureTarget(frame.width, frame.height))
+		submitIncremental(frame);
+	else
+	{
+		const SDL_Color& c = frame.clearColor;
+		SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+		SDL_RenderClear(renderer);
+		const bool transformed = setTransform(frame.zoom, frame.origin, frame.width, frame.height);
+		frame.queue.submit(renderer);
+		if (transformed)
+			resetTransform();
+	}
+	// Present may block on vblank, which is not submission cost.
+	submitDuration.store(SDL_GetTicksNS() - start, std::memory_order_relaxed);
+	SDL_RenderPresent(renderer);
+	presentedAt.store(SDL_GetTicksNS(), std::memory_order_relaxed);
+}
+
+void RenderThread::applyTextures(RenderFrame& frame)
+{
+	for (SDL_Texture* texture : frame.releases)
+		SDL_DestroyTexture(texture);
+	frame.releases.clear();
+	for (TextureUpload& upload : frame.uploads)
+	{
+		SDL_Texture* texture = SDL_CreateTexture(renderer, upload.format, SDL_TEXTUREACCESS_STATIC,
+			upload.width, upload.height);
+		if (!texture || !SDL_UpdateTexture(texture, nullptr, upload.pixels.data(), upload.pitch))
+		{
+			SDL_Log("Cannot create %dx%d texture: %s", upload.width, upload.height, SDL_GetError());
+			if (texture)
+				SDL_DestroyTexture(texture);
+			texture = nullptr;
+		}
+		else
+			SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		upload.result->store(texture, std::memory_order_release);
+	}
+	// The pixels are in the texture now; this frees them.
+	frame.uploads.clear();
+	for (TextureStream& stream : frame.streams)
+		applyStream(stream);
+	frame.streams.clear();
+}
+
+void RenderThread::applyStream(TextureStream& stream)
+{
+	SDL_Texture* texture = stream.result->load(std::memory_order_relaxed);
+	if (!texture)
+	{
+		texture = SDL_CreateTexture(renderer, stream.format, SDL_TEXTUREACCESS_STREAMING, stream.width,
+			stream.height);
+		if (!texture)
+		{
+			SDL_Log("Cannot create %dx%d streaming texture: %s", stream.width, stream.height, SDL_GetError());
+			return;
+		}
+		SDL_SetTextureBlendMode(texture, SDL_BLENDMODE_BLEND);
+		stream.result->store(texture, std::memory_order_release);
+	}
+	// The locked rows are write-only and must all be written.
+	const SDL_Rect rows = { 0, stream.firstRow, stream.width, stream.rowCount };
+	void* pixels;
+	int pitch;
+	if (!SDL_LockTexture(texture, &rows, &pixels, &pitch))
+	{
+		SDL_Log("Cannot lock streaming texture: %s", SDL_GetError());
+		return;
+	}
+	for (int y = 0; y < stream.rowCount; ++y)
+		std::memcpy((uint8_t*)pixels + (size_t)y * pitch, stream.pixels.data() + (size_t)y * stream.pitch,
+			(size_t)stream.pitch);
+	SDL_UnlockTexture(texture);
+}
+
+void RenderThread::submitLights(RenderFrame& frame)
+{
+	const LightPass& pass = frame.light;
+	SDL_Texture* map = pass.target->load(std::memory_order_relaxed);
+	if (!map)
+	{
+		map = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, pass.width, pass.height);
+		if (!map)
+		{
+			SDL_Log("Cannot create %dx%d light map: %s", pass.width, pass.height, SDL_GetError());
+			return;
+		}
+		SDL_SetTextureScaleMode(map, SDL_SCALEMODE_LINEAR);
+		pass.target->store(map, std::memory_order_release);
+	}
+	frame.lights.sort();
+	SDL_SetRenderTarget(renderer, map);
+	SDL_SetRenderDrawColorFloat(renderer, pass.ambient.r, pass.ambient.g, pass.ambient.b, 1.0f);
+	SDL_RenderClear(renderer);
+	// The light map covers the output at its own, lower resolution.
+	const float scale = pass.scale;
+	const SDL_FPoint origin = { frame.origin.x * scale, frame.origin.y * scale };
+	const bool transformed = setTransform(frame.zoom * scale, origin, pass.width, pass.height);
+	frame.lights.submit(renderer);
+	if (transformed)
+		resetTransform();
+	SDL_SetRenderTarget(renderer, nullptr);
+}
+
+bool RenderThread::setTransform(float zoom, SDL_FPoint origin, int width, int height)
+{
+	if (zoom == 1.0f && origin.x == 0.0f && origin.y == 0.0f)
+		return false;
+	// The viewport is in scaled coordinates, so the offset is too.
+	const SDL_Rect viewport = { (int)SDL_lroundf(origin.x / zoom), (int)SDL_lroundf(origin.y / zoom),
+		(int)SDL_ceilf((width - origin.x) / zoom), (int)SDL_ceilf((height - origin.y) / zoom) };
+	SDL_SetRenderScale(renderer, zoom, zoom);
+	SDL_SetRenderViewport(renderer, &viewport);
+	return true;
+}
+
+void RenderThread::resetTransform()
+{
+	SDL_SetRenderViewport(renderer, nullptr);
+	SDL_SetRenderScale(renderer, 1.0f, 1.0f);
+}
+
+bool RenderThread::ensureTarget(int width, int height)
+{
+	if (target && target->w == width && target->h == height)
+		return true;
+	if (target)
+		SDL_DestroyTexture(target);
+	target = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, width, height);
+	if (!target)
+	{
+		SDL_Log("Cannot create %dx%d render target: %s", width, height, SDL_GetError());
+		return false;
+	}
+	SDL_SetTextureBlendMode(target, SDL_BLENDMODE_NONE);
+	return true;
+}
+
+void RenderThread::submitIncremental(RenderFrame& frame)
+{
+	// Whatever is outside the dirty rectangles is still valid from earlier
+	// frames. View invalidates everything when the size changes, so a freshly
+	// created target is always fully redrawn.
+	SDL_SetRenderTarget(renderer, target);
+	const SDL_Color& c = frame.clearColor;
+	for (const SDL_Rect& rect : frame.dirty)
+	{
+		SDL_SetRenderClipRect(renderer, &rect);
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(renderer, c.r, c.g, c.b, c.a);
+		SDL_RenderFillRect(renderer, nullptr);
+		frame.queue.submit(renderer);
+	}
+	SDL_SetRenderClipRect(renderer, nullptr);
+	SDL_SetRenderTarget(renderer, nullptr);
+	SDL_RenderTexture(renderer, target, nullptr, nullptr);
+
+	if (frame.showDirty && !frame.dirty.empty())
+	{
+		outlines.resize(frame.dirty.size());
+		for (size_t i = 0; i < frame.dirty.size(); ++i)
+		{
+			const SDL_Rect& r = frame.dirty[i];
+			outlines[i] = { (float)r.x, (float)r.y, (float)r.w, (float)r.h };
+		}
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
+		SDL_SetRenderDrawColor(renderer, 255, 0, 64, 255);
+		SDL_RenderRects(renderer, outlines.data(), (int)outlines.size());
+	}
+}
+
+void RenderThread::workerMain()
+{
+	for (;;)
+	{
+		SDL_WaitSemaphore(pendingCount);
+		RenderFrame* frame = nullptr;
+		pending.pop(frame);
+		if (!frame)
+			return;
+		submit(*frame);
+		available.push(frame);
+		SDL_SignalSemaphore(availableCount);
+	}
+}
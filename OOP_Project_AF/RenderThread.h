@@ -0,0 +1,145 @@
+#pragma once
+#include "RenderQueue.h"
+#include "SpscQueue.h"
+#include <SDL3/SDL_mutex.h>
+#include <SDL3/SDL_render.h>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// Pixels to turn into a static texture on the submitting thread. result
+// receives the texture (null if creation failed) before the frame draws.
+struct TextureUpload
+{
+	std::atomic<SDL_Texture*>* result;
+	SDL_PixelFormat format;
+	int width;
+	int height;
+	int pitch;
+	std::vector<uint8_t> pixels;
+};
+
+// Changed rows of a streaming texture, written on the submitting thread
+// with SDL_LockTexture. result receives the texture when it is created.
+struct TextureStream
+{
+	std::atomic<SDL_Texture*>* result;
+	SDL_PixelFormat format;
+	int width;	// of the whole texture
+	int height;
+	int firstRow;
+	int rowCount;
+	int pitch;
+	std::vector<uint8_t> pixels;	// rowCount rows of pitch bytes
+};
+
+// A light map drawn before the frame: target is cleared to ambient, then
+// RenderFrame::lights is drawn into it with the frame's camera scaled by
+// scale. The target is created at width x height on first use; whoever owns
+// it releases it through RenderFrame::releases to change its size.
+struct LightPass
+{
+	std::atomic<SDL_Texture*>* target;	// null: no light pass
+	int width;
+	int height;
+	float scale;	// light map pixels per output pixel
+	SDL_FColor ambient;
+};
+
+// Everything submitted for one presented frame.
+struct RenderFrame
+{
+	RenderQueue queue;
+	SDL_Color clearColor;
+	int vsync;	// SDL_SetRenderVSync value, applied when it changes
+
+	// Incremental mode: only the dirty rectangles of a persistent target of
+	// width x height are redrawn, then the target is copied to the window.
+	// showDirty outlines those rectangles on screen.
+	bool incremental;
+	bool showDirty;
+	int width;
+	int height;
+	std::vector<SDL_Rect> dirty;
+
+	// Full redraws draw world coordinates scaled by zoom, with world (0, 0)
+	// at output pixel origin. Incremental frames must use zoom 1 at (0, 0).
+	float zoom;
+	SDL_FPoint origin;
+
+	// Texture lifetime changes, applied before anything is drawn and then
+	// cleared. Released textures must not be drawn by this frame.
+	std::vector<TextureUpload> uploads;
+	std::vector<SDL_Texture*> releases;
+	std::vector<TextureStream> streams;
+
+	// Reset by beginFrame(); only full redraws may use a light pass.
+	LightPass light;
+	RenderQueue lights;
+};
+
+// Hands recorded frames from the main thread to a submission thread.
+//
+// Window creation and event pumping stay on the main thread. In threaded
+// mode the renderer is driven exclusively by the render thread from then on,
+// so every SDL_Renderer call must go through a RenderFrame. There are two
+// frame slots: the main thread records one while the other is sorted and
+// submitted, which gives exactly one frame of pipelining. Inline mode
+// submits at endFrame() on the calling thread, for debugging and for
+// platforms whose render backend insists on the main thread.
+class RenderThread
+{
+public:
+	RenderThread(SDL_Renderer* renderer, bool threaded);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// Blocks only while both slots are in flight. The returned frame still
+	// holds the stats from its previous submission.
+	RenderFrame& beginFrame();
+	void endFrame();
+
+	bool threaded() const { return worker.joinable(); }
+
+	// When the last SDL_RenderPresent returned and how long sorting and
+	// submission took before it, for frame pacing. 0 until the first frame.
+	Uint64 lastPresentNs() const { return presentedAt.load(std::memory_order_relaxed); }
+	Uint64 lastSubmitNs() const { return submitDuration.load(std::memory_order_relaxed); }
+
+private:
+	static const size_t FrameCount = 2;
+
+	void submit(RenderFrame& frame);
+	void applyTextures(RenderFrame& frame);
+	void applyStream(TextureStream& stream);
+	void submitIncremental(RenderFrame& frame);
+	void submitLights(RenderFrame& frame);
+	// Maps world coordinates to the current target of width x height, as
+	// RenderFrame::zoom and origin describe; false if that is the identity.
+	bool setTransform(float zoom, SDL_FPoint origin, int width, int height);
+	void resetTransform();
+	bool ensureTarget(int width, int height);
+	void workerMain();
+
+	SDL_Renderer* renderer;
+	int appliedVSync;
+	SDL_Texture* target;
+	std::vector<SDL_FRect> outlines;
+	RenderFrame frames[FrameCount];
+	RenderFrame* recording;
+
+	// Frame slots travel main -> render through pending and come back through
+	// available; each semaphore counts its queue so waits can sleep.
+	SpscQueue<RenderFrame*, FrameCount * 2> pending;
+	SpscQueue<RenderFrame*, FrameCount * 2> available;
+	SDL_Semaphore* pendingCount;
+	SDL_Semaphore* availableCount;
+
+	std::atomic<Uint64> presentedAt;
+	std::atomic<Uint64> submitDuration;
+
+	std::thread worker;
+};
@@ -0,0 +1,195 @@
+#include "SaveSystem.h"
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_timer.h>
+
+SaveSystem::SaveSystem(const char* org, const char* app)
+	: org(org), app(app), storage(nullptr), job(JobType::None),
+	  requestedSave(nullptr), requestedLoad(nullptr),
+	  current(State::Idle), progressValue(0.0f)
+{
+	worker = std::thread(&SaveSystem::workerMain, this);
+}
+
+SaveSystem::~SaveSystem()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		job = JobType::Quit;
+	}
+	wake.notify_one();
+	worker.join();
+	if (storage)
+		SDL_CloseStorage(storage);
+}
+
+bool SaveSystem::busy() const
+{
+	const State s = state();
+	return s == State::Saving || s == State::Loading || s == State::LoadReady;
+}
+
+bool SaveSystem::save(const Model& model, const char* name)
+{
+	if (busy())
+		return false;
+	// Copying the saved columns is the only main-thread cost; the nav grid
+	// only contributes tiles edited since the last save. Encoding,
+	// checksumming and the write all happen on the worker.
+	model.capture(snapshot);
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		slot = name;
+		job = JobType::Save;
+	}
+	progressValue.store(0.0f, std::memory_order_relaxed);
+	current.store(State::Saving, std::memory_order_release);
+	wake.notify_one();
+	return true;
+}
+
+bool SaveSystem::load(const char* name)
+{
+	if (busy())
+		return false;
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		slot = name;
+		job = JobType::Load;
+	}
+	progressValue.store(0.0f, std::memory_order_relaxed);
+	current.store(State::Loading, std::memory_order_release);
+	wake.notify_one();
+	return true;
+}
+
+void SaveSystem::connect(EventBus& bus)
+{
+	bus.subscribe<&SaveSystem::onSaveRequested>(this);
+	bus.subscribe<&SaveSystem::onLoadRequested>(this);
+}
+
+void SaveSystem::onSaveRequested(const SaveRequested* events, size_t count)
+{
+	requestedSave = events[count - 1].slot;
+}
+
+void SaveSystem::onLoadRequested(const LoadRequested* events, size_t count)
+{
+	requestedLoad = events[count - 1].slot;
+}
+
+bool SaveSystem::poll(Model& model)
+{
+	if (requestedSave && !save(model, requestedSave))
+		SDL_Log("SaveSystem: a save or load is already running, save to %s dropped", requestedSave);
+	requestedSave = nullptr;
+	// A load requested with or during a save stays pending until the save
+	// is written, so it reads the new file instead of being dropped.
+	if (requestedLoad && state() != State::Saving)
+	{
+		if (!load(requestedLoad))
+			SDL_Log("SaveSystem: a save or load is already running, load from %s dropped", requestedLoad);
+		requestedLoad = nullptr;
+	}
+
+	if (state() != State::LoadReady)
+		return false;
+	// The columns are swapped in, so the old ones land in loaded and are
+	// reused by the next load instead of freed here.
+	const bool applied = model.apply(loaded);
+	if (!applied)
+		SDL_Log("SaveSystem: loaded save is inconsistent");
+	current.store(applied ? State::Idle : State::Failed, std::memory_order_release);
+	return applied;
+}
+
+void SaveSystem::workerMain()
+{
+	for (;;)
+	{
+		JobType next;
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			wake.wait(guard, [this] { return job != JobType::None; });
+			next = job;
+			job = JobType::None;
+		}
+		if (next == JobType::Quit)
+			return;
+
+		const bool ok = next == JobType::Save ? runSave() : runLoad();
+		if (!ok)
+			current.store(State::Failed, std::memory_order_release);
+		else
+			current.store(next == JobType::Save ? State::Idle : State::LoadReady, std::memory_order_release);
+	}
+}
+
+bool SaveSystem::openStorage()
+{
+	if (!storage)
+	{
+		storage = SDL_OpenUserStorage(org.c_str(), app.c_str(), 0);
+		if (!storage)
+		{
+			SDL_Log("SaveSystem: cannot open user storage: %s", SDL_GetError());
+			return false;
+		}
+	}
+	while (!SDL_StorageReady(storage))
+		SDL_Delay(1);
+	return true;
+}
+
+bool SaveSystem::runSave()
+{
+	if (!openStorage())
+		return false;
+
+	snapshot.serialize(buffer);
+	progressValue.store(0.5f, std::memory_order_relaxed);
+
+	// Write beside the real slot and rename over it, so a crash mid-write
+	// leaves the previous save intact.
+	const std::string temp = slot + ".tmp";
+	if (!SDL_WriteStorageFile(storage, temp.c_str(), buffer.data(), buffer.size()))
+	{
+		SDL_Log("SaveSystem: writing %s failed: %s", temp.c_str(), SDL_GetError());
+		return false;
+	}
+	if (!SDL_RenameStoragePath(storage, temp.c_str(), slot.c_str()))
+	{
+		SDL_Log("SaveSystem: renaming %s failed: %s", temp.c_str(), SDL_GetError());
+		SDL_RemoveStoragePath(storage, temp.c_str());
+		return false;
+	}
+	progressValue.store(1.0f, std::memory_order_relaxed);
+	return true;
+}
+
+bool SaveSystem::runLoad()
+{
+	if (!openStorage())
+		return false;
+
+	Uint64 length = 0;
+	if (!SDL_GetStorageFileSize(storage, slot.c_str(), &length))
+	{
+		SDL_Log("SaveSystem: %s not found: %s", slot.c_str(), SDL_GetError());
+		return false;
+	}
+	buffer.resize((size_t)length);
+	if (!SDL_ReadStorageFile(storage, slot.c_str(), buffer.data(), length))
+	{
+		SDL_Log("SaveSystem: reading %s failed: %s", slot.c_str(), SDL_GetError());
+		return false;
+	}
+
+	// Decode progress is reported per slice straight into progressValue.
+	if (!loaded.deserialize(buffer.data(), buffer.size(), &progressValue))
+	{
+		SDL_Log("SaveSystem: %s is corrupt or from another version", slot.c_str());
+		return false;
+	}
+	return true;
+}
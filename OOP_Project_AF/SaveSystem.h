@@ -0,0 +1,72 @@
+#pragma once
+#include "EventBus.h"
+#include "Events.h"
+#include "Model.h"
+#include <SDL3/SDL_storage.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Saves and loads Model through SDL user storage on a worker thread.
+// The main thread only copies the saved columns out (save) or swaps decoded
+// ones in (poll), so neither path blocks a frame on encoding or disk I/O.
+class SaveSystem
+{
+public:
+	enum class State { Idle, Saving, Loading, LoadReady, Failed };
+
+	SaveSystem(const char* org, const char* app);
+	~SaveSystem();
+
+	SaveSystem(const SaveSystem&) = delete;
+	SaveSystem& operator=(const SaveSystem&) = delete;
+
+	// Both return false if a job is already in flight.
+	bool save(const Model& model, const char* slot);
+	bool load(const char* slot);
+
+	// Requests from the bus are started by the next poll(), which is the
+	// only place that sees the live Model. A load waits for a running save.
+	void connect(EventBus& bus);
+	void onSaveRequested(const SaveRequested* events, size_t count);
+	void onLoadRequested(const LoadRequested* events, size_t count);
+
+	// Call once per frame. Returns true when a finished load was applied to
+	// model.
+	bool poll(Model& model);
+
+	State state() const { return current.load(std::memory_order_acquire); }
+	bool busy() const;
+	float progress() const { return progressValue.load(std::memory_order_relaxed); }
+
+private:
+	enum class JobType { None, Save, Load, Quit };
+
+	void workerMain();
+	bool openStorage();
+	bool runSave();
+	bool runLoad();
+
+	std::string org;
+	std::string app;
+	SDL_Storage* storage;
+
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable wake;
+	JobType job;
+	std::string slot;
+	const char* requestedSave;
+	const char* requestedLoad;
+
+	// Owned by the worker while a job runs, by the main thread otherwise.
+	ModelSnapshot snapshot;
+	ModelSnapshot loaded;
+	std::vector<uint8_t> buffer;
+
+	std::atomic<State> current;
+	std::atomic<float> progressValue;
+};
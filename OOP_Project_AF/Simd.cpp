@@ -0,0 +1,41 @@
+#include "Simd.h"
+#include <SDL3/SDL_cpuinfo.h>
+
+bool simdPathSupported(SimdPath path)
+{
+	switch (path)
+	{
+	case SimdPath::SSE2:
+#ifdef SDL_SSE2_INTRINSICS
+		return SDL_HasSSE2();
+#else
+		return false;
+#endif
+	case SimdPath::AVX2:
+#ifdef SDL_AVX2_INTRINSICS
+		return SDL_HasAVX2();
+#else
+		return false;
+#endif
+	default:
+		return true;
+	}
+}
+
+SimdPath bestSimdPath()
+{
+	static const SimdPath best =
+		simdPathSupported(SimdPath::AVX2) ? SimdPath::AVX2 :
+		simdPathSupported(SimdPath::SSE2) ? SimdPath::SSE2 : SimdPath::Scalar;
+	return best;
+}
+
+const char* simdPathName(SimdPath path)
+{
+	switch (path)
+	{
+	case SimdPath::SSE2: return "SSE2";
+	case SimdPath::AVX2: return "AVX2";
+	default: return "scalar";
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+#include <SDL3/SDL_intrin.h>
+
+// Instruction set a kernel runs on. Kernels are compiled for every path the
+// compiler supports (SDL_TARGETING) and picked at runtime from SDL_cpuinfo.
+enum class SimdPath { Scalar, SSE2, AVX2 };
+
+SimdPath bestSimdPath();
+bool simdPathSupported(SimdPath path);
+const char* simdPathName(SimdPath path);
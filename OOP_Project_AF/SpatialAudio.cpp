@@ -0,0 +1,138 @@
+#include "SpatialAudio.h"
+#include "Model.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <cstring>
+
+SpatialAudio::SpatialAudio()
+	: params{ 0.0f, 0.0f, 64.0f, 1280.0f, 640.0f }, simd(bestSimdPath()), published(false), last()
+{
+	voices.reserve(AudioQueue::MaxVoices);
+	entities.reserve(AudioQueue::MaxVoices);
+	posX.reserve(AudioQueue::MaxVoices);
+	posY.reserve(AudioQueue::MaxVoices);
+	gains.reserve(AudioQueue::MaxVoices);
+	left.resize(AudioQueue::MaxVoices);
+	right.resize(AudioQueue::MaxVoices);
+}
+
+SpatialAudio::SpatialAudio(const SpatialAudio& other)
+	: SpatialAudio()
+{
+	params = other.params;
+	simd = other.simd;
+}
+
+SpatialAudio& SpatialAudio::operator=(const SpatialAudio& other)
+{
+	params = other.params;
+	simd = other.simd;
+	return *this;
+}
+
+uint32_t SpatialAudio::playAt(AudioQueue& audio, uint32_t sound, float x, float y, float gain, float pitch,
+	bool loop, uint8_t priority)
+{
+	return start(audio, sound, NullEntity, x, y, gain, pitch, loop, priority);
+}
+
+uint32_t SpatialAudio::follow(AudioQueue& audio, const Model& model, uint32_t sound, EntityHandle entity,
+	float gain, float pitch, bool loop, uint8_t priority)
+{
+	const size_t index = model.indexOf(entity);
+	if (index == Model::NoEntity)
+		return AudioQueue::NoVoice;
+	return start(audio, sound, entity, model.posX[index], model.posY[index], gain, pitch, loop, priority);
+}
+
+uint32_t SpatialAudio::start(AudioQueue& audio, uint32_t sound, EntityHandle entity, float x, float y, float gain,
+	float pitch, bool loop, uint8_t priority)
+{
+	if (voices.size() >= AudioQueue::MaxVoices)
+		return AudioQueue::NoVoice;
+	// The first block may mix before the next update publishes gains, so the
+	// voice starts at the gains that update would publish.
+	float l, r;
+	spatialGains(SimdPath::Scalar, &x, &y, &gain, 1, params, &l, &r);
+	const uint32_t voice = audio.playGains(sound, l, r, pitch, loop, priority);
+	if (voice == AudioQueue::NoVoice)
+		return voice;
+	voices.push_back(voice);
+	entities.push_back(entity);
+	posX.push_back(x);
+	posY.push_back(y);
+	gains.push_back(gain);
+	return voice;
+}
+
+bool SpatialAudio::move(uint32_t voice, float x, float y)
+{
+	for (size_t i = 0; i < voices.size(); ++i)
+	{
+		if (voices[i] != voice || entities[i] != NullEntity)
+			continue;
+		posX[i] = x;
+		posY[i] = y;
+		return true;
+	}
+	return false;
+}
+
+void SpatialAudio::remove(size_t emitter)
+{
+	voices[emitter] = voices.back();
+	entities[emitter] = entities.back();
+	posX[emitter] = posX.back();
+	posY[emitter] = posY.back();
+	gains[emitter] = gains.back();
+	voices.pop_back();
+	entities.pop_back();
+	posX.pop_back();
+	posY.pop_back();
+	gains.pop_back();
+}
+
+void SpatialAudio::update(const Model& model, AudioQueue& audio)
+{
+	const Uint64 started = SDL_GetTicksNS();
+	for (size_t i = 0; i < voices.size(); )
+	{
+		if (!audio.playing(voices[i]))
+		{
+			remove(i);
+			continue;
+		}
+		if (entities[i] != NullEntity)
+		{
+			const size_t index = model.indexOf(entities[i]);
+			if (index == Model::NoEntity)
+			{
+				audio.stop(voices[i]);
+				remove(i);
+				continue;
+			}
+			posX[i] = model.posX[index];
+			posY[i] = model.posY[index];
+		}
+		++i;
+	}
+
+	const size_t count = voices.size();
+	if (count > 0 || published)
+	{
+		spatialGains(simd, posX.data(), posY.data(), gains.data(), count, params, left.data(), right.data());
+		VoiceParamBlock& block = audio.beginParams();
+		block.tick = model.tick;
+		block.count = (uint32_t)count;
+		if (count > 0)
+		{
+			std::memcpy(block.voice, voices.data(), count * sizeof(uint32_t));
+			std::memcpy(block.gainL, left.data(), count * sizeof(float));
+			std::memcpy(block.gainR, right.data(), count * sizeof(float));
+		}
+		audio.publishParams();
+		published = count > 0;
+	}
+	last.emitters = count;
+	last.lastNs = SDL_GetTicksNS() - started;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "AudioKernels.h"
+#include "AudioQueue.h"
+#include "EntityHandle.h"
+#include "Simd.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Positional voices. Each one has an emitter, a fixed point or an entity it
+// follows; once per Model::update the emitters are gathered into position
+// columns, spatialGains turns them into left/right gains for the listener
+// in one vectorized pass, and the result goes to the mixer as a single
+// VoiceParamBlock. The audio thread only copies gains; no distance or pan
+// math runs there.
+class SpatialAudio
+{
+public:
+	struct Stats
+	{
+		size_t emitters;
+		uint64_t lastNs;	// the latest update
+	};
+
+	SpatialAudio();
+
+	// Emitters name voices of the running mixer, like AudioQueue: copies
+	// start without emitters but with the same settings, and assignment
+	// keeps the emitters and only takes the settings.
+	SpatialAudio(const SpatialAudio& other);
+	SpatialAudio& operator=(const SpatialAudio& other);
+
+	// Start sound on audio at a fixed point or following entity, already at
+	// the gains update() would publish. Return AudioQueue::NoVoice like play().
+	uint32_t playAt(AudioQueue& audio, uint32_t sound, float x, float y, float gain = 1.0f, float pitch = 1.0f,
+		bool loop = false, uint8_t priority = AudioQueue::DefaultPriority);
+	uint32_t follow(AudioQueue& audio, const Model& model, uint32_t sound, EntityHandle entity, float gain = 1.0f,
+		float pitch = 1.0f, bool loop = false, uint8_t priority = AudioQueue::DefaultPriority);
+	// Moves a fixed emitter; false if voice has none.
+	bool move(uint32_t voice, float x, float y);
+
+	// Called once per Model::update after positions are final. Forgets
+	// finished voices, stops those whose entity was destroyed and publishes
+	// the gains of the rest.
+	void update(const Model& model, AudioQueue& audio);
+
+	size_t emitterCount() const { return voices.size(); }
+	const Stats& stats() const { return last; }
+
+	SpatialParams params;	// listener and distance model
+	SimdPath simd;
+
+private:
+	uint32_t start(AudioQueue& audio, uint32_t sound, EntityHandle entity, float x, float y, float gain,
+		float pitch, bool loop, uint8_t priority);
+	void remove(size_t emitter);
+
+	// One row per emitter.
+	std::vector<uint32_t> voices;
+	std::vector<EntityHandle> entities;	// NullEntity for fixed points
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> gains;
+	std::vector<float> left;
+	std::vector<float> right;
+	bool published;	// the last block sent was not empty
+	Stats last;
+};
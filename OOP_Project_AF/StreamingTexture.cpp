@@ -0,0 +1,104 @@
+#include "StreamingTexture.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <cstring>
+
+StreamingTexture::StreamingTexture(SDL_PixelFormat format, int width, int height)
+	: pixelFormat(format), w(width), h(height), rowBytes(width * SDL_BYTESPERPIXEL(format)),
+	  pixels((size_t)width * (size_t)height * SDL_BYTESPERPIXEL(format)), current(0),
+	  dirty(((size_t)SDL_max(height, 0) + 63) / 64, 0), stale(dirty.size(), 0), anyDirty(false), totals()
+{
+	// Both textures start undefined, so the first two updates send every row.
+	textures[0].store(nullptr, std::memory_order_relaxed);
+	textures[1].store(nullptr, std::memory_order_relaxed);
+	markRows(0, height);
+}
+
+StreamingTexture::~StreamingTexture()
+{
+	for (std::atomic<SDL_Texture*>& texture : textures)
+		if (SDL_Texture* t = texture.load(std::memory_order_acquire))
+			SDL_DestroyTexture(t);
+}
+
+void StreamingTexture::setRow(int y, const void* row)
+{
+	uint8_t* dst = pixels.data() + (size_t)y * rowBytes;
+	if (std::memcmp(dst, row, (size_t)rowBytes) == 0)
+	{
+		++totals.rowsSkipped;
+		return;
+	}
+	std::memcpy(dst, row, (size_t)rowBytes);
+	markRows(y, 1);
+}
+
+void StreamingTexture::markRows(int first, int count)
+{
+	first = SDL_max(first, 0);
+	const int end = SDL_min(first + count, h);
+	for (int y = first; y < end; ++y)
+		dirty[(size_t)y / 64] |= (uint64_t)1 << (y & 63);
+	anyDirty = anyDirty || first < end;
+}
+
+void StreamingTexture::release(RenderFrame& frame)
+{
+	for (std::atomic<SDL_Texture*>& texture : textures)
+		if (SDL_Texture* t = texture.exchange(nullptr, std::memory_order_acq_rel))
+			frame.releases.push_back(t);
+	std::fill(dirty.begin(), dirty.end(), 0);
+	std::fill(stale.begin(), stale.end(), 0);
+	markRows(0, h);
+}
+
+SDL_Texture* StreamingTexture::update(RenderFrame& frame)
+{
+	if (!anyDirty)
+		return textures[current].load(std::memory_order_acquire);
+
+	// The other texture was last written two updates ago, so it also misses
+	// what the previous update sent. stale becomes the union to send.
+	for (size_t i = 0; i < dirty.size(); ++i)
+		stale[i] |= dirty[i];
+	const int next = current ^ 1;
+	for (int y = 0; y < h;)
+	{
+		if (stale[(size_t)y / 64] >> (y & 63) == 0)
+		{
+			y = (y / 64 + 1) * 64;
+			continue;
+		}
+		if (!(stale[(size_t)y / 64] >> (y & 63) & 1))
+		{
+			++y;
+			continue;
+		}
+		int end = y + 1;
+		while (end < h && (stale[(size_t)end / 64] >> (end & 63) & 1))
+			++end;
+		TextureStream stream;
+		stream.result = &textures[next];
+		stream.format = pixelFormat;
+		stream.width = w;
+		stream.height = h;
+		stream.firstRow = y;
+		stream.rowCount = end - y;
+		stream.pitch = rowBytes;
+		stream.pixels.assign(pixels.begin() + (size_t)y * rowBytes, pixels.begin() + (size_t)end * rowBytes);
+		frame.streams.push_back(std::move(stream));
+		totals.rowsSent += (uint64_t)(end - y);
+		y = end;
+	}
+	++totals.updates;
+
+	stale.swap(dirty);
+	std::fill(dirty.begin(), dirty.end(), 0);
+	anyDirty = false;
+	current = next;
+	// The texture is created with this frame on first use; until then the
+	// other one, at most one update behind, stands in.
+	if (SDL_Texture* texture = textures[next].load(std::memory_order_acquire))
+		return texture;
+	return textures[next ^ 1].load(std::memory_order_acquire);
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "RenderThread.h"
+#include <SDL3/SDL_render.h>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// Pixels that change from frame to frame (minimap, fog of war, procedural
+// content), shown through two SDL_TEXTUREACCESS_STREAMING textures used in
+// turn. Each update() locks only the rows that changed, in the texture that
+// was not drawn last frame, so the driver never has to wait for the GPU to
+// finish with the texture being written. Changed rows are tracked one bit
+// per row, and every run of adjacent changed rows is queued and locked on
+// its own, so two distant edits never send the rows between them.
+//
+// Written on the main thread; the textures are created and locked by the
+// submitting thread through RenderFrame::streams.
+class StreamingTexture
+{
+public:
+	struct Stats
+	{
+		uint32_t updates;
+		uint64_t rowsSent;
+		uint64_t rowsSkipped;	// setRow() calls that changed nothing
+	};
+
+	StreamingTexture(SDL_PixelFormat format, int width, int height);
+	// Destroys the textures, so the submitting thread must be stopped, or
+	// the textures handed to a frame with release() first.
+	~StreamingTexture();
+
+	StreamingTexture(const StreamingTexture&) = delete;
+	StreamingTexture& operator=(const StreamingTexture&) = delete;
+
+	int width() const { return w; }
+	int height() const { return h; }
+	int pitch() const { return rowBytes; }
+	SDL_PixelFormat format() const { return pixelFormat; }
+
+	// Copies pitch() bytes into row y; a row equal to what is there already
+	// is not sent.
+	void setRow(int y, const void* row);
+	// For writing in place; call markRows for what was changed.
+	uint8_t* row(int y) { return pixels.data() + (size_t)y * rowBytes; }
+	void markRows(int first, int count);
+
+	// Once per frame, after RenderThread::beginFrame. Queues the changed rows
+	// and returns the texture to draw this frame, null until one exists.
+	SDL_Texture* update(RenderFrame& frame);
+	// Moves the textures to frame.releases; the next update() starts over.
+	void release(RenderFrame& frame);
+
+	Stats stats() const { return totals; }
+
+private:
+	SDL_PixelFormat pixelFormat;
+	int w;
+	int h;
+	int rowBytes;
+	std::vector<uint8_t> pixels;
+	std::atomic<SDL_Texture*> textures[2];
+	int current;	// texture drawn last frame
+	// One bit per row: rows changed since the last update, and the rows that
+	// update sent, which the other texture has not seen yet.
+	std::vector<uint64_t> dirty;
+	std::vector<uint64_t> stale;
+	bool anyDirty;
+	Stats totals;
+};
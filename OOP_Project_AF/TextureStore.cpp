@@ -0,0 +1,225 @@
+#include "TextureStore.h"
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+#include <utility>
+
+TextureStore::TextureStore(SDL_Renderer* renderer, const char* org, const char* app)
+	: budget(DefaultBudget), frameIndex(0), totals(), loader(org, app, preferredFormat(renderer))
+{
+}
+
+TextureStore::~TextureStore()
+{
+	for (const std::unique_ptr<Entry>& entry : entries)
+		for (std::atomic<SDL_Texture*>& level : entry->levels)
+			if (SDL_Texture* texture = level.load(std::memory_order_acquire))
+				SDL_DestroyTexture(texture);
+}
+
+SDL_PixelFormat TextureStore::preferredFormat(SDL_Renderer* renderer)
+{
+	const SDL_PixelFormat* formats = static_cast<const SDL_PixelFormat*>(SDL_GetPointerProperty(
+		SDL_GetRendererProperties(renderer), SDL_PROP_RENDERER_TEXTURE_FORMATS_POINTER, nullptr));
+	for (; formats && *formats != SDL_PIXELFORMAT_UNKNOWN; ++formats)
+	{
+		if (SDL_ISPIXELFORMAT_FOURCC(*formats) || SDL_ISPIXELFORMAT_10BIT(*formats))
+			continue;
+		const SDL_PixelFormatDetails* details = SDL_GetPixelFormatDetails(*formats);
+		if (details && details->bits_per_pixel == 32 && details->Amask != 0)
+			return *formats;
+	}
+	return SDL_PIXELFORMAT_ARGB8888;
+}
+
+uint32_t TextureStore::load(const char* path)
+{
+	for (size_t i = 0; i < entries.size(); ++i)
+		if (entries[i]->path == path)
+			return (uint32_t)i;
+	std::unique_ptr<Entry> entry(new Entry());
+	entry->path = path;
+	for (int l = 0; l < ImageLoader::MaxLevels; ++l)
+	{
+		entry->levels[l].store(nullptr, std::memory_order_relaxed);
+		entry->levelBytes[l] = 0;
+	}
+	entry->levelCount = 0;
+	entry->width = 0;
+	entry->height = 0;
+	entry->residency = Residency::Loading;
+	entry->lastDrawn = 0;
+	entry->uploadedAt = 0;
+	entry->retryAt = 0;
+	entry->failedReloads = 0;
+	const uint32_t id = (uint32_t)entries.size();
+	entries.push_back(std::move(entry));
+	loader.load(id, path);
+	return id;
+}
+
+SDL_Texture* TextureStore::texture(uint32_t id, float texelsPerPixel)
+{
+	if (id >= entries.size())
+		return nullptr;
+	Entry& entry = *entries[id];
+	entry.lastDrawn = frameIndex;
+	if (entry.residency == Residency::Evicted && frameIndex >= entry.retryAt)
+	{
+		entry.residency = Residency::Reloading;
+		loader.load(id, entry.path.c_str());
+		++totals.reloads;
+	}
+	// Level n has 2^n full-size texels per texel; round to the nearest.
+	int wanted = 0;
+	for (float t = texelsPerPixel; t >= 1.5f && wanted + 1 < entry.levelCount; t *= 0.5f)
+		++wanted;
+	for (int distance = 0; distance < entry.levelCount; ++distance)
+	{
+		if (wanted - distance >= 0)
+			if (SDL_Texture* texture = entry.levels[wanted - distance].load(std::memory_order_acquire))
+				return texture;
+		if (wanted + distance < entry.levelCount)
+			if (SDL_Texture* texture = entry.levels[wanted + distance].load(std::memory_order_acquire))
+				return texture;
+	}
+	return nullptr;
+}
+
+void TextureStore::update(RenderFrame& frame)
+{
+	++frameIndex;
+	loader.poll(finished);
+	for (ImageLoader::Image& image : finished)
+	{
+		Entry& entry = *entries[image.id];
+		if (entry.residency == Residency::Loading)
+		{
+			if (image.levels.empty())
+			{
+				entry.residency = Residency::Failed;
+				continue;
+			}
+			entry.levelCount = (int)image.levels.size();
+			entry.width = image.levels[0].width;
+			entry.height = image.levels[0].height;
+		}
+		else if (!sameShape(entry, image))
+		{
+			// A failed reload, or one of a file that changed shape since,
+			// keeps its placeholder and is retried later.
+			if (!image.levels.empty())
+				SDL_Log("TextureStore: %s changed size since it was loaded", entry.path.c_str());
+			entry.residency = Residency::Evicted;
+			entry.retryAt = frameIndex + SDL_min(RetryFrames << SDL_min(entry.failedReloads, 6), MaxRetryFrames);
+			++entry.failedReloads;
+			continue;
+		}
+		entry.failedReloads = 0;
+		const int bytes = SDL_BYTESPERPIXEL(image.format);
+		size_t incoming = 0;
+		for (int l = 0; l < entry.levelCount; ++l)
+			if (entry.levelBytes[l] == 0)
+				incoming += (size_t)image.levels[l].width * (size_t)image.levels[l].height * bytes;
+		// Images being drawn load in full even over budget; others that do
+		// not fit get only their placeholder.
+		const bool drawn = entry.lastDrawn + 1 >= frameIndex;
+		if (makeRoom(incoming, frame) || drawn)
+		{
+			upload(entry, image, 0, frame);
+			entry.residency = Residency::Resident;
+		}
+		else
+		{
+			upload(entry, image, entry.levelCount - 1, frame);
+			entry.residency = Residency::Evicted;
+		}
+	}
+	finished.clear();
+	makeRoom(0, frame);
+}
+
+bool TextureStore::sameShape(const Entry& entry, const ImageLoader::Image& image)
+{
+	if ((int)image.levels.size() != entry.levelCount)
+		return false;
+	// ImageLoader halves with integer division, level by level.
+	for (int l = 0; l < entry.levelCount; ++l)
+		if (image.levels[l].width != entry.width >> l || image.levels[l].height != entry.height >> l)
+			return false;
+	return true;
+}
+
+void TextureStore::upload(Entry& entry, ImageLoader::Image& image, int first, RenderFrame& frame)
+{
+	const int bytes = SDL_BYTESPERPIXEL(image.format);
+	for (int l = first; l < entry.levelCount; ++l)
+	{
+		// A reload skips the placeholder, which never left.
+		if (entry.levelBytes[l] != 0)
+			continue;
+		ImageLoader::Level& level = image.levels[l];
+		entry.levelBytes[l] = (size_t)level.width * (size_t)level.height * bytes;
+		totals.residentBytes += entry.levelBytes[l];
+		TextureUpload upload;
+		upload.result = &entry.levels[l];
+		upload.format = image.format;
+		upload.width = level.width;
+		upload.height = level.height;
+		upload.pitch = level.pitch;
+		upload.pixels = std::move(level.pixels);
+		frame.uploads.push_back(std::move(upload));
+	}
+	entry.uploadedAt = frameIndex;
+	totals.peakBytes = SDL_max(totals.peakBytes, totals.residentBytes);
+}
+
+bool TextureStore::makeRoom(size_t incoming, RenderFrame& frame)
+{
+	if (totals.residentBytes + incoming <= budget)
+		return true;
+	// Candidates were not drawn last frame and have no upload in flight,
+	// so no recorded frame can still refer to their textures.
+	victims.clear();
+	for (size_t i = 0; i < entries.size(); ++i)
+	{
+		const Entry& entry = *entries[i];
+		if (entry.residency == Residency::Resident && entry.levelCount > 1 && entry.lastDrawn + 1 < frameIndex
+			&& entry.uploadedAt + UploadLatency <= frameIndex)
+			victims.push_back((uint32_t)i);
+	}
+	std::sort(victims.begin(), victims.end(),
+		[this](uint32_t a, uint32_t b) { return entries[a]->lastDrawn < entries[b]->lastDrawn; });
+	for (uint32_t victim : victims)
+	{
+		if (totals.residentBytes + incoming <= budget)
+			break;
+		evict(*entries[victim], frame);
+	}
+	return totals.residentBytes + incoming <= budget;
+}
+
+void TextureStore::evict(Entry& entry, RenderFrame& frame)
+{
+	for (int l = 0; l + 1 < entry.levelCount; ++l)
+	{
+		// Uploads that failed to create a texture left null behind.
+		if (SDL_Texture* texture = entry.levels[l].exchange(nullptr, std::memory_order_acq_rel))
+			frame.releases.push_back(texture);
+		totals.residentBytes -= entry.levelBytes[l];
+		entry.levelBytes[l] = 0;
+	}
+	entry.residency = Residency::Evicted;
+	++totals.evictions;
+}
+
+void TextureStore::logStats() const
+{
+	const ImageLoader::Stats s = loader.stats();
+	SDL_Log("Textures (%s): %zu requested, %u loaded (%u from cache), %u failed, %zu pending; "
+		"decode %.1f ms, convert %.1f ms, scale %.1f ms, cache read %.1f ms / write %.1f ms",
+		SDL_GetPixelFormatName(format()), entries.size(), s.loaded, s.cacheHits, s.failed, loader.pending(),
+		s.decodeNs / 1e6, s.convertNs / 1e6, s.scaleNs / 1e6, s.cacheReadNs / 1e6, s.cacheWriteNs / 1e6);
+	SDL_Log("Texture memory: %.1f of %.1f MB resident (peak %.1f MB), %u evictions, %u reloads",
+		totals.residentBytes / 1048576.0, budget / 1048576.0, totals.peakBytes / 1048576.0, totals.evictions,
+		totals.reloads);
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include "ImageLoader.h"
+#include "RenderThread.h"
+#include <SDL3/SDL_render.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Textures loaded from image files, named by small ids. Images arrive from
+// an ImageLoader already in the renderer's preferred format and are created
+// as textures by the submitting thread through RenderFrame::uploads, so the
+// main thread never touches the renderer. A texture id is valid at once;
+// texture() returns null until the texture exists.
+//
+// Each image comes with pre-scaled variants (see ImageLoader), one texture
+// per level. Callers say how many texels of the full image land on one
+// output pixel and get the level closest to one texel per pixel, so a
+// zoomed-out view reads a fraction of the memory and does not shimmer.
+//
+// The store keeps the estimated video memory of its textures under a
+// budget. When it would go over, the least recently drawn images lose all
+// levels but their smallest, which stays as a placeholder. Drawing an
+// evicted image queues a reload (usually from the conversion cache) and the
+// placeholder is drawn until the full levels are back. A reload that fails,
+// or whose levels no longer match the image's sizes, leaves the image
+// evicted; the next one is queued no sooner than RetryFrames later,
+// doubling with each failure in a row up to MaxRetryFrames.
+class TextureStore
+{
+public:
+	static constexpr uint32_t NoTexture = 0xffffffffu;
+	static constexpr size_t DefaultBudget = (size_t)256 << 20;
+
+	struct Stats
+	{
+		size_t residentBytes;	// width * height * bytes per pixel, all levels
+		size_t peakBytes;
+		uint32_t evictions;
+		uint32_t reloads;
+	};
+
+	TextureStore(SDL_Renderer* renderer, const char* org, const char* app);
+	// Destroys the textures, so the submitting thread must be stopped.
+	~TextureStore();
+
+	TextureStore(const TextureStore&) = delete;
+	TextureStore& operator=(const TextureStore&) = delete;
+
+	// The same path always gives the same id.
+	uint32_t load(const char* path);
+	// texelsPerPixel is full-size texels per output pixel along the longer
+	// side; 1 or less picks the full-size texture. Levels that are not
+	// created yet fall back to the nearest one that is. Counts as drawing
+	// the image this frame, which keeps it resident or brings it back.
+	SDL_Texture* texture(uint32_t id, float texelsPerPixel = 1.0f);
+	// Full size in texels; 0 until loaded.
+	int width(uint32_t id) const { return id < entries.size() ? entries[id]->width : 0; }
+	int height(uint32_t id) const { return id < entries.size() ? entries[id]->height : 0; }
+
+	// Images drawn in the previous frame are never evicted, so the budget
+	// can be exceeded by what is on screen; lowering it takes effect at the
+	// next update().
+	void setBudget(size_t bytes) { budget = bytes; }
+	size_t memoryBudget() const { return budget; }
+	Stats stats() const { return totals; }
+
+	// Once per frame, after RenderThread::beginFrame and before texture().
+	void update(RenderFrame& frame);
+
+	// First 32-bit format with alpha in the renderer's texture format list,
+	// so SDL_CreateTexture never has to convert.
+	static SDL_PixelFormat preferredFormat(SDL_Renderer* renderer);
+	SDL_PixelFormat format() const { return loader.format(); }
+	void logStats() const;
+
+private:
+	// RenderThread has two frame slots, so an upload queued in one update()
+	// has been applied by the update() two frames later.
+	static constexpr uint64_t UploadLatency = 2;
+	static constexpr uint64_t RetryFrames = 30;
+	static constexpr uint64_t MaxRetryFrames = 30 * 64;
+
+	enum class Residency : uint8_t
+	{
+		Loading,	// first load in flight
+		Resident,	// every level uploaded
+		Evicted,	// only the smallest level uploaded
+		Reloading,	// evicted and drawn since, reload in flight
+		Failed		// the first load failed
+	};
+
+	struct Entry
+	{
+		std::string path;
+		std::atomic<SDL_Texture*> levels[ImageLoader::MaxLevels];
+		size_t levelBytes[ImageLoader::MaxLevels];	// 0 when the level is not uploaded
+		int levelCount;
+		int width;
+		int height;
+		Residency residency;
+		uint64_t lastDrawn;		// frame of the last texture() call
+		uint64_t uploadedAt;	// frame of the last upload
+		uint64_t retryAt;		// first frame a reload may be queued
+		int failedReloads;		// in a row
+	};
+
+	// Full sizes match the entry and every level is the halving the first
+	// load had.
+	static bool sameShape(const Entry& entry, const ImageLoader::Image& image);
+
+	void upload(Entry& entry, ImageLoader::Image& image, int first, RenderFrame& frame);
+	bool makeRoom(size_t incoming, RenderFrame& frame);
+	void evict(Entry& entry, RenderFrame& frame);
+
+	// Entries never move, so uploads can point at their texture.
+	std::vector<std::unique_ptr<Entry>> entries;
+	std::vector<ImageLoader::Image> finished;
+	std::vector<uint32_t> victims;
+	size_t budget;
+	uint64_t frameIndex;
+	Stats totals;
+	ImageLoader loader;
+};
@@ -0,0 +1,328 @@
+#include "TransformHierarchy.h"
+#include "JobSystem.h"
+#include "Model.h"
+#include <SDL3/SDL_stdinc.h>
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+	// Nodes per job within one depth level; shallow levels stay inline.
+	const size_t LevelGrain = 4096;
+}
+
+TransformHierarchy::TransformHierarchy()
+	: layoutDirty(false), resolvedEpoch(0), resolved(false), recomputed(0)
+{
+}
+
+uint32_t TransformHierarchy::linkOf(EntityHandle entity) const
+{
+	const uint32_t s = entity.slot();
+	if (s >= linkOfSlot.size() || linkOfSlot[s] == None || links[linkOfSlot[s]].child != entity)
+		return None;
+	return linkOfSlot[s];
+}
+
+bool TransformHierarchy::attach(const Model& model, EntityHandle child, EntityHandle parent, const Transform& local)
+{
+	if (child == parent || !model.alive(child) || !model.alive(parent))
+		return false;
+	// Walking up from the new parent must not reach the child.
+	EntityHandle up = parent;
+	for (uint32_t l = linkOf(up); l != None; l = linkOf(up))
+	{
+		up = links[l].parent;
+		if (up == child)
+			return false;
+	}
+
+	uint32_t l = linkOf(child);
+	if (l == None)
+	{
+		l = (uint32_t)links.size();
+		links.push_back(Link());
+		if (child.slot() >= linkOfSlot.size())
+			linkOfSlot.resize(child.slot() + 1, None);
+		linkOfSlot[child.slot()] = l;
+	}
+	links[l].child = child;
+	links[l].parent = parent;
+	links[l].local = local;
+	layoutDirty = true;
+	return true;
+}
+
+void TransformHierarchy::detach(EntityHandle child)
+{
+	const uint32_t l = linkOf(child);
+	if (l == None)
+		return;
+	links[l] = links.back();
+	linkOfSlot[links[l].child.slot()] = l;
+	links.pop_back();
+	linkOfSlot[child.slot()] = None;
+	layoutDirty = true;
+}
+
+bool TransformHierarchy::setLocal(EntityHandle child, const Transform& local)
+{
+	const uint32_t l = linkOf(child);
+	if (l == None)
+		return false;
+	links[l].local = local;
+	if (!layoutDirty)
+	{
+		// The layout is current, so the node can be patched in place.
+		const uint32_t n = nodeOfSlot[child.slot()];
+		localX[n] = local.x;
+		localY[n] = local.y;
+		localCos[n] = SDL_cosf(local.rotation);
+		localSin[n] = SDL_sinf(local.rotation);
+		localScale[n] = local.scale;
+		localDirty[n] = 1;
+	}
+	return true;
+}
+
+bool TransformHierarchy::attached(EntityHandle child) const
+{
+	return linkOf(child) != None;
+}
+
+void TransformHierarchy::clear()
+{
+	links.clear();
+	linkOfSlot.clear();
+	layoutDirty = true;
+}
+
+void TransformHierarchy::restore(const Link* saved, size_t count)
+{
+	clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const uint32_t s = saved[i].child.slot();
+		if (s >= linkOfSlot.size())
+			linkOfSlot.resize(s + 1, None);
+		if (linkOfSlot[s] != None)
+			continue;
+		linkOfSlot[s] = (uint32_t)links.size();
+		links.push_back(saved[i]);
+	}
+}
+
+void TransformHierarchy::rebuild(const Model& model)
+{
+	layoutDirty = false;
+	for (size_t l = links.size(); l-- > 0; )
+		if (!model.alive(links[l].child) || !model.alive(links[l].parent))
+			detach(links[l].child);
+	layoutDirty = false;
+
+	// Depth of every link's child, resolved by walking up to the first link
+	// whose depth is known. A bad save can hold a cycle; the walk is bounded
+	// so it only yields a wrong order, never a hang.
+	const size_t count = links.size();
+	depthOfLink.assign(count, 0);
+	uint32_t maxDepth = 0;
+	for (size_t l = 0; l < count; ++l)
+	{
+		scratch.clear();
+		uint32_t cur = (uint32_t)l;
+		while (cur != None && depthOfLink[cur] == 0 && scratch.size() <= count)
+		{
+			scratch.push_back(cur);
+			cur = linkOf(links[cur].parent);
+		}
+		uint32_t depth = cur == None ? 0 : depthOfLink[cur];
+		for (size_t k = scratch.size(); k-- > 0; )
+			depthOfLink[scratch[k]] = ++depth;
+		maxDepth = SDL_max(maxDepth, depth);
+	}
+
+	uint32_t slotCount = 0;
+	for (const Link& link : links)
+		slotCount = SDL_max(slotCount, SDL_max(link.child.slot(), link.parent.slot()) + 1);
+	nodeOfSlot.assign(slotCount, None);
+
+	// Level 0: every parent that is not itself attached, in column order.
+	handle.clear();
+	for (const Link& link : links)
+	{
+		if (linkOf(link.parent) == None && nodeOfSlot[link.parent.slot()] == None)
+		{
+			nodeOfSlot[link.parent.slot()] = 0;
+			handle.push_back(link.parent);
+		}
+	}
+	std::sort(handle.begin(), handle.end(), [&model](EntityHandle a, EntityHandle b)
+		{
+			return model.indexOf(a) < model.indexOf(b);
+		});
+	for (size_t i = 0; i < handle.size(); ++i)
+		nodeOfSlot[handle[i].slot()] = (uint32_t)i;
+
+	// Deeper levels: links bucketed by depth, then grouped by parent node so
+	// siblings are adjacent and parents are read in order.
+	levelStart.assign(maxDepth + 2, 0);
+	levelStart[1] = (uint32_t)handle.size();
+	std::vector<uint32_t>& byDepth = scratch;
+	byDepth.assign(maxDepth + 2, 0);
+	for (size_t l = 0; l < count; ++l)
+		++byDepth[depthOfLink[l] + 1];
+	for (uint32_t d = 1; d <= maxDepth + 1; ++d)
+		byDepth[d] += byDepth[d - 1];
+	std::vector<uint32_t> order(count);
+	for (size_t l = 0; l < count; ++l)
+		order[byDepth[depthOfLink[l]]++] = (uint32_t)l;
+
+	size_t at = 0;
+	for (uint32_t d = 1; d <= maxDepth; ++d)
+	{
+		const size_t begin = at;
+		while (at < count && depthOfLink[order[at]] == d)
+			++at;
+		std::sort(order.begin() + begin, order.begin() + at, [this](uint32_t a, uint32_t b)
+			{
+				return nodeOfSlot[links[a].parent.slot()] < nodeOfSlot[links[b].parent.slot()];
+			});
+		for (size_t k = begin; k < at; ++k)
+		{
+			nodeOfSlot[links[order[k]].child.slot()] = (uint32_t)handle.size();
+			handle.push_back(links[order[k]].child);
+		}
+		levelStart[d + 1] = (uint32_t)handle.size();
+	}
+
+	const size_t n = handle.size();
+	const size_t roots = levelStart[1];
+	parent.assign(n, None);
+	entity.assign(n, 0);
+	localX.assign(n, 0.0f);
+	localY.assign(n, 0.0f);
+	localCos.assign(n, 1.0f);
+	localSin.assign(n, 0.0f);
+	localScale.assign(n, 1.0f);
+	worldX.resize(n);
+	worldY.resize(n);
+	worldCos.resize(n);
+	worldSin.resize(n);
+	worldScale.resize(n);
+	localDirty.assign(n, 1);
+	dirty.assign(n, 0);
+	resolved = false;
+	for (size_t i = roots; i < n; ++i)
+	{
+		const Link& link = links[linkOf(handle[i])];
+		parent[i] = nodeOfSlot[link.parent.slot()];
+		localX[i] = link.local.x;
+		localY[i] = link.local.y;
+		localCos[i] = SDL_cosf(link.local.rotation);
+		localSin[i] = SDL_sinf(link.local.rotation);
+		localScale[i] = link.local.scale;
+	}
+}
+
+size_t TransformHierarchy::resolve(const Model& model, size_t node)
+{
+	// Cached column indices stay right until an entity is swap-removed or
+	// compacted, which Model::indexEpoch() reports.
+	if (resolved)
+		return entity[node];
+	const size_t e = model.indexOf(handle[node]);
+	if (e != Model::NoEntity)
+		entity[node] = (uint32_t)e;
+	return e;
+}
+
+void TransformHierarchy::propagate(Model& model)
+{
+	recomputed = 0;
+	if (layoutDirty)
+		rebuild(model);
+	if (handle.empty())
+		return;
+
+	const uint64_t* moved = model.changes.words(Component::Transform);
+	std::atomic<bool> stale(false);
+	if (resolvedEpoch != model.indexEpoch())
+		resolved = false;
+
+	// Roots take their translation from their own entity.
+	for (size_t i = 0; i < levelStart[1]; ++i)
+	{
+		const size_t e = resolve(model, i);
+		if (e == Model::NoEntity)
+		{
+			stale.store(true, std::memory_order_relaxed);
+			dirty[i] = 0;
+			continue;
+		}
+		dirty[i] = localDirty[i] | (uint8_t)((moved[e >> 6] >> (e & 63)) & 1);
+		localDirty[i] = 0;
+		worldX[i] = model.posX[e];
+		worldY[i] = model.posY[e];
+		worldCos[i] = 1.0f;
+		worldSin[i] = 0.0f;
+		worldScale[i] = 1.0f;
+	}
+
+	// Every parent lives on the previous level, so each level is one
+	// independent parallel pass.
+	for (size_t d = 1; d + 1 < levelStart.size(); ++d)
+	{
+		const size_t first = levelStart[d];
+		JobSystem::shared().parallelFor(levelStart[d + 1] - first, LevelGrain, [&](size_t begin, size_t end)
+			{
+				for (size_t i = first + begin; i < first + end; ++i)
+				{
+					const size_t e = resolve(model, i);
+					if (e == Model::NoEntity)
+					{
+						stale.store(true, std::memory_order_relaxed);
+						dirty[i] = 0;
+						continue;
+					}
+					const uint32_t p = parent[i];
+					// An attached entity that moved on its own is snapped back.
+					const uint8_t recompute = localDirty[i] | dirty[p] | (uint8_t)((moved[e >> 6] >> (e & 63)) & 1);
+					dirty[i] = recompute;
+					if (!recompute)
+						continue;
+					localDirty[i] = 0;
+
+					const float s = worldScale[p];
+					const float lx = localX[i] * s;
+					const float ly = localY[i] * s;
+					worldX[i] = worldX[p] + worldCos[p] * lx - worldSin[p] * ly;
+					worldY[i] = worldY[p] + worldSin[p] * lx + worldCos[p] * ly;
+					worldCos[i] = worldCos[p] * localCos[i] - worldSin[p] * localSin[i];
+					worldSin[i] = worldSin[p] * localCos[i] + worldCos[p] * localSin[i];
+					worldScale[i] = s * localScale[i];
+
+					model.posX[e] = worldX[i];
+					model.posY[e] = worldY[i];
+					model.velX[e] = 0.0f;
+					model.velY[e] = 0.0f;
+				}
+			});
+	}
+
+	resolved = true;
+	resolvedEpoch = model.indexEpoch();
+
+	// Bitset words are shared between threads, so marking happens here.
+	for (size_t i = levelStart[1]; i < handle.size(); ++i)
+	{
+		if (dirty[i])
+		{
+			model.changes.mark(Component::Transform, entity[i]);
+			++recomputed;
+		}
+	}
+
+	// Destroyed entities leave the layout on the next tick.
+	if (stale.load(std::memory_order_relaxed))
+		layoutDirty = true;
+}
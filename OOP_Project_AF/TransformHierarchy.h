@@ -0,0 +1,94 @@
+#pragma once
+#include "EntityHandle.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Parent/child attachments between Model entities. An attached entity's
+// position is no longer its own: every tick propagate() recomputes it from
+// its parent's world transform and its local offset, rotation and scale.
+//
+// Links are the source of truth; from them the hierarchy is laid out as
+// flat, depth-sorted node arrays (roots first, each level grouped by parent)
+// whenever attachments change. propagate() then walks one level at a time,
+// splitting each level across the JobSystem, and only recomputes nodes
+// whose local transform changed or whose parent or own entity moved.
+class TransformHierarchy
+{
+public:
+	struct Transform
+	{
+		float x;
+		float y;
+		float rotation;	// radians
+		float scale;
+	};
+
+	TransformHierarchy();
+
+	// Fails on stale handles and on links that would form a cycle.
+	// Re-attaching an entity moves it to the new parent.
+	bool attach(const Model& model, EntityHandle child, EntityHandle parent, const Transform& local);
+	void detach(EntityHandle child);
+	bool setLocal(EntityHandle child, const Transform& local);
+	bool attached(EntityHandle child) const;
+	void clear();
+
+	// Called by Model::update after collisions; marks moved children in
+	// model.changes. Links to destroyed entities are dropped here.
+	void propagate(Model& model);
+
+	size_t linkCount() const { return links.size(); }
+	size_t nodeCount() const { return handle.size(); }
+	size_t depthCount() const { return levelStart.empty() ? 0 : levelStart.size() - 1; }
+	size_t lastRecomputed() const { return recomputed; }
+
+	// Save support: the links in any order.
+	struct Link
+	{
+		EntityHandle child;
+		EntityHandle parent;
+		Transform local;
+	};
+	const std::vector<Link>& allLinks() const { return links; }
+	void restore(const Link* saved, size_t count);
+
+private:
+	static constexpr uint32_t None = 0xffffffffu;
+
+	uint32_t linkOf(EntityHandle entity) const;
+	void rebuild(const Model& model);
+	size_t resolve(const Model& model, size_t node);
+
+	std::vector<Link> links;
+	std::vector<uint32_t> linkOfSlot;
+	bool layoutDirty;
+
+	// Depth-sorted nodes; nodes [levelStart[d], levelStart[d + 1]) have depth d.
+	std::vector<uint32_t> levelStart;
+	std::vector<EntityHandle> handle;
+	std::vector<uint32_t> parent;
+	std::vector<uint32_t> entity;
+	std::vector<float> localX;
+	std::vector<float> localY;
+	std::vector<float> localCos;
+	std::vector<float> localSin;
+	std::vector<float> localScale;
+	std::vector<float> worldX;
+	std::vector<float> worldY;
+	std::vector<float> worldCos;
+	std::vector<float> worldSin;
+	std::vector<float> worldScale;
+	std::vector<uint8_t> localDirty;
+	std::vector<uint8_t> dirty;
+	std::vector<uint32_t> nodeOfSlot;
+	// Model::indexEpoch() the cached entity indices were resolved at.
+	uint64_t resolvedEpoch;
+	bool resolved;
+
+	std::vector<uint32_t> depthOfLink;
+	std::vector<uint32_t> scratch;
+	size_t recomputed;
+};
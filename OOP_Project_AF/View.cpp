@@ -0,0 +1,380 @@
+#include "View.h"
+#include <SDL3/SDL_log.h>
+#include <algorithm>
+
+namespace
+{
+	// Past this share of dirty tiles a plain full redraw is cheaper.
+	const float FullRedrawCoverage = 0.6f;
+
+	// Minimap width in pixels; the height follows the world's aspect. Each
+	// pixel shows how many entities it covers, up to the last shade.
+	const int MinimapWidth = 192;
+	const int MinimapMargin = 8;
+	const int MinimapShades = 8;
+
+	SDL_FRect entityRect(const Model& model, size_t i)
+	{
+		// One pixel of slack for rasterisation rounding.
+		const float r = model.radius[i] + 1.0f;
+		return { model.posX[i] - r, model.posY[i] - r, 2.0f * r, 2.0f * r };
+	}
+}
+
+View::View(SDL_Renderer* renderer, bool threadedSubmit, const char* org, const char* app)
+	: textures(renderer, org, app), lighting(textures.format()), renderer(renderer), stats(), vsync(1),
+	  incrementalMode(false), showDirty(false), resync(true), entitySprite(TextureStore::NoTexture),
+	  drawnSprite(nullptr), showMinimap(false), fogOf(-1), fogReset(false), fogVersion(0), fogShades(), lit(false),
+	  submitter(renderer, threadedSubmit)
+{
+}
+
+void View::resize(int width, int height)
+{
+	dirty.resize(width, height);
+	// An untouched camera stays 1:1 with the new size.
+	const bool untouched = camera.width == 0 || camera.identity();
+	camera.width = width;
+	camera.height = height;
+	if (untouched)
+	{
+		camera.centerX = width * 0.5f;
+		camera.centerY = height * 0.5f;
+	}
+}
+
+void View::setIncremental(bool enabled)
+{
+	incrementalMode = enabled;
+	resync = true;
+	dirty.invalidateAll();
+}
+
+void View::onModelChanged(const Model& model, const ChangeTracker& changes)
+{
+	if (!incrementalMode)
+		return;
+	if (resync || changes.layoutChanged())
+	{
+		resync = false;
+		drawnEntities.resize(model.size());
+		for (size_t i = 0; i < model.size(); ++i)
+			drawnEntities[i] = entityRect(model, i);
+		dirty.invalidateAll();
+		return;
+	}
+	for (uint32_t i : changes.changed(Component::Transform))
+	{
+		dirty.invalidate(drawnEntities[i]);
+		drawnEntities[i] = entityRect(model, i);
+		dirty.invalidate(drawnEntities[i]);
+	}
+}
+
+void View::connect(EventBus& bus)
+{
+	bus.subscribe<&View::onResized>(this);
+	bus.subscribe<&View::onRedraw>(this);
+	bus.subscribe<&View::onVSyncChanged>(this);
+	bus.subscribe<&View::onIncrementalToggled>(this);
+	bus.subscribe<&View::onDirtyOverlayToggled>(this);
+	bus.subscribe<&View::onMinimapToggled>(this);
+	bus.subscribe<&View::onStatsRequested>(this);
+	bus.subscribe<&View::onZoomRequested>(this);
+}
+
+// A batch only matters through its last event, or through its parity for
+// toggles.
+void View::onResized(const ViewResized* events, size_t count)
+{
+	resize(events[count - 1].width, events[count - 1].height);
+}
+
+void View::onRedraw(const RedrawRequested*, size_t)
+{
+	invalidateAll();
+}
+
+void View::onVSyncChanged(const VSyncChanged* events, size_t count)
+{
+	setVSync(events[count - 1].vsync);
+}
+
+void View::onIncrementalToggled(const IncrementalToggled*, size_t count)
+{
+	if (count % 2 == 0)
+		return;
+	setIncremental(!incrementalMode);
+	SDL_Log("Incremental rendering %s", incrementalMode ? "on" : "off");
+}
+
+void View::onDirtyOverlayToggled(const DirtyOverlayToggled*, size_t count)
+{
+	if (count % 2)
+		showDirty = !showDirty;
+}
+
+void View::onMinimapToggled(const MinimapToggled*, size_t count)
+{
+	if (count % 2)
+		setMinimap(!showMinimap);
+}
+
+void View::onStatsRequested(const StatsRequested*, size_t)
+{
+	SDL_Log("Render: %zu commands, %zu draw calls, state changes %zu recorded -> %zu sorted",
+		stats.commands, stats.drawCalls, stats.stateChangesRecorded, stats.stateChangesSorted);
+	textures.logStats();
+	if (minimap)
+	{
+		const StreamingTexture::Stats s = minimap->stats();
+		SDL_Log("Minimap: %u updates, %.1f rows sent per update, %llu unchanged rows skipped", s.updates,
+			s.updates ? (double)s.rowsSent / s.updates : 0.0, (unsigned long long)s.rowsSkipped);
+	}
+	if (fog)
+	{
+		const StreamingTexture::Stats s = fog->stats();
+		SDL_Log("Fog (team %d): %u updates, %.1f rows sent per update", fogOf, s.updates,
+			s.updates ? (double)s.rowsSent / s.updates : 0.0);
+	}
+}
+
+void View::onZoomRequested(const ZoomRequested* events, size_t count)
+{
+	for (size_t e = 0; e < count; ++e)
+		camera.zoomAt(events[e].factor, events[e].x, events[e].y);
+	// Back at 1:1 the view snaps home, so incremental redraws can resume.
+	if (SDL_fabsf(camera.zoom - 1.0f) < 1e-3f)
+	{
+		camera.zoom = 1.0f;
+		camera.centerX = camera.width * 0.5f;
+		camera.centerY = camera.height * 0.5f;
+	}
+	dirty.invalidateAll();
+}
+
+void View::setMinimap(bool enabled)
+{
+	showMinimap = enabled;
+	dirty.invalidateAll();
+}
+
+SDL_Texture* View::updateMinimap(const Model& model, RenderFrame& frame)
+{
+	if (!minimap)
+	{
+		const int height = SDL_max(1, (int)(MinimapWidth * model.worldHeight / model.worldWidth + 0.5f));
+		minimap.reset(new StreamingTexture(textures.format(), MinimapWidth, height));
+		minimapCounts.resize((size_t)MinimapWidth * height);
+		minimapRow.resize(MinimapWidth);
+		const SDL_PixelFormatDetails* details = SDL_GetPixelFormatDetails(minimap->format());
+		minimapShades.resize(MinimapShades);
+		for (int s = 0; s < MinimapShades; ++s)
+		{
+			const Uint8 level = (Uint8)(s == 0 ? 24 : 96 + 159 * s / (MinimapShades - 1));
+			minimapShades[s] = SDL_MapRGBA(details, nullptr, level, level, level, s == 0 ? 160 : 255);
+		}
+	}
+
+	const int width = minimap->width();
+	const int height = minimap->height();
+	std::fill(minimapCounts.begin(), minimapCounts.end(), (uint16_t)0);
+	const float sx = width / model.worldWidth;
+	const float sy = height / model.worldHeight;
+	for (size_t i = 0; i < model.size(); ++i)
+	{
+		const int x = SDL_clamp((int)(model.posX[i] * sx), 0, width - 1);
+		const int y = SDL_clamp((int)(model.posY[i] * sy), 0, height - 1);
+		uint16_t& count = minimapCounts[(size_t)y * width + x];
+		count = (uint16_t)SDL_min(count + 1, MinimapShades - 1);
+	}
+	for (int y = 0; y < height; ++y)
+	{
+		const uint16_t* counts = minimapCounts.data() + (size_t)y * width;
+		for (int x = 0; x < width; ++x)
+			minimapRow[x] = minimapShades[counts[x]];
+		minimap->setRow(y, minimapRow.data());
+	}
+
+	const uint32_t updates = minimap->stats().updates;
+	SDL_Texture* texture = minimap->update(frame);
+	if (minimap->stats().updates != updates)
+		dirty.invalidate(minimapRect());
+	return texture;
+}
+
+SDL_FRect View::minimapRect() const
+{
+	// Fixed on screen: the camera transform is undone here and reapplied by
+	// the render thread.
+	const float w = (float)minimap->width();
+	const float h = (float)minimap->height();
+	const SDL_FPoint corner = camera.toWorld(camera.width - w - MinimapMargin, camera.height - h - MinimapMargin);
+	return { corner.x, corner.y, w / camera.zoom, h / camera.zoom };
+}
+
+void View::setFogTeam(int team)
+{
+	fogOf = team >= 0 && team < Visibility::MaxTeams ? team : -1;
+	fogReset = true;
+	dirty.invalidateAll();
+}
+
+SDL_Texture* View::updateFog(const Model& model, RenderFrame& frame)
+{
+	const Visibility& visibility = model.visibility;
+	if (fog && (fogReset || fog->width() != visibility.width() || fog->height() != visibility.height()))
+	{
+		fog->release(frame);
+		fog.reset();
+	}
+	fogReset = false;
+	if (fogOf < 0 || visibility.width() == 0 || visibility.height() == 0)
+		return nullptr;
+	if (!fog)
+	{
+		fog.reset(new StreamingTexture(textures.format(), visibility.width(), visibility.height()));
+		fogRow.resize(visibility.width());
+		const SDL_PixelFormatDetails* details = SDL_GetPixelFormatDetails(fog->format());
+		fogShades[0] = SDL_MapRGBA(details, nullptr, 0, 0, 0, 232);
+		fogShades[1] = SDL_MapRGBA(details, nullptr, 0, 0, 0, 128);
+		fogShades[2] = SDL_MapRGBA(details, nullptr, 0, 0, 0, 0);
+		fogVersion = 0;
+	}
+
+	int first = visibility.height();
+	int last = -1;
+	const int words = visibility.wordsPerRow();
+	for (int y = 0; y < visibility.height(); ++y)
+	{
+		if (visibility.rowVersion(fogOf, y) <= fogVersion)
+			continue;
+		const uint64_t* seen = visibility.visible(fogOf) + (size_t)y * words;
+		const uint64_t* explored = visibility.explored(fogOf) + (size_t)y * words;
+		for (int x = 0; x < visibility.width(); ++x)
+		{
+			const int shade = (int)((seen[x >> 6] >> (x & 63)) & 1) + (int)((explored[x >> 6] >> (x & 63)) & 1);
+			fogRow[x] = fogShades[shade];
+		}
+		fog->setRow(y, fogRow.data());
+		first = SDL_min(first, y);
+		last = y;
+	}
+	fogVersion = visibility.version();
+
+	const uint32_t updates = fog->stats().updates;
+	SDL_Texture* texture = fog->update(frame);
+	if (fog->stats().updates != updates)
+	{
+		const float cell = visibility.cellSize();
+		dirty.invalidate({ 0.0f, first * cell, visibility.width() * cell, (last - first + 1) * cell });
+	}
+	return texture;
+}
+
+void View::trackParticles()
+{
+	drawnParticles.resize(particles.poolCount());
+	for (size_t p = 0; p < particles.poolCount(); ++p)
+	{
+		const ParticlePool& pool = particles.pool(p);
+		dirty.invalidate(drawnParticles[p]);
+		drawnParticles[p] = pool.count ? pool.bounds : SDL_FRect();
+		dirty.invalidate(drawnParticles[p]);
+	}
+
+	if (dirty.coverage() > FullRedrawCoverage)
+		dirty.invalidateAll();
+}
+
+void View::render(const Model& model, float dt)
+{
+	RenderFrame& frame = submitter.beginFrame();
+	stats = frame.queue.stats();
+	frame.clearColor = { 16, 16, 24, 255 };
+	frame.vsync = vsync;
+	// The persistent target holds an unlit scene, stale once lighting ends.
+	if (lighting.enabled != lit)
+	{
+		lit = lighting.enabled;
+		dirty.invalidateAll();
+	}
+	frame.incremental = incrementalMode && camera.identity() && !lit;
+	frame.zoom = camera.zoom;
+	frame.origin = camera.origin();
+	frame.showDirty = showDirty;
+	frame.width = dirty.width();
+	frame.height = dirty.height();
+	textures.update(frame);
+
+	// A sprite that just finished loading changes every entity.
+	SDL_Texture* sprite = textures.texture(entitySprite);
+	if (sprite != drawnSprite)
+	{
+		drawnSprite = sprite;
+		dirty.invalidateAll();
+	}
+
+	particles.update(dt);
+	SDL_Texture* map = showMinimap ? updateMinimap(model, frame) : nullptr;
+	SDL_Texture* shade = updateFog(model, frame);
+	SDL_Texture* lightMap = lighting.record(frame, camera);
+
+	// In incremental mode only what overlaps a dirty tile is recorded; the
+	// render thread clips each rectangle, so partial overlaps are fine.
+	bool everything = true;
+	if (frame.incremental)
+	{
+		trackParticles();
+		dirty.collect(frame.dirty);
+		everything = dirty.coverage() >= 1.0f;
+	}
+
+	RenderQueue& queue = frame.queue;
+	const SDL_FColor entityColor = { 0.9f, 0.9f, 0.9f, 1.0f };
+	const size_t n = model.size();
+	// The sprite level follows the on-screen size; radii rarely differ, so
+	// the lookup is redone only when one does.
+	const float spriteTexels = (float)SDL_max(textures.width(entitySprite), textures.height(entitySprite));
+	float spriteRadius = -1.0f;
+	SDL_Texture* level = sprite;
+	for (size_t i = 0; i < n; ++i)
+	{
+		const float r = model.radius[i];
+		const SDL_FRect dst = { model.posX[i] - r, model.posY[i] - r, 2.0f * r, 2.0f * r };
+		if (!everything && !dirty.intersects(dst))
+			continue;
+		if (sprite && r != spriteRadius)
+		{
+			spriteRadius = r;
+			level = textures.texture(entitySprite, spriteTexels / (2.0f * r * camera.zoom));
+		}
+		queue.quad(LayerEntities, level, sprite ? SDL_BLENDMODE_BLEND : SDL_BLENDMODE_NONE, 0.0f, dst, entityColor);
+	}
+	for (size_t p = 0; p < particles.poolCount(); ++p)
+	{
+		if (everything || dirty.intersects(particles.pool(p).bounds))
+			particles.recordPool(queue, p, LayerParticles);
+	}
+	if (lightMap)
+	{
+		const SDL_FPoint corner = camera.toWorld(0.0f, 0.0f);
+		const SDL_FRect dst = { corner.x, corner.y, camera.width / camera.zoom, camera.height / camera.zoom };
+		queue.quad(LayerLight, lightMap, SDL_BLENDMODE_MOD, 0.0f, dst, lighting.coverage(), { 1.0f, 1.0f, 1.0f, 1.0f });
+	}
+	if (shade)
+	{
+		const float cell = model.visibility.cellSize();
+		const SDL_FRect dst = { 0.0f, 0.0f, model.visibility.width() * cell, model.visibility.height() * cell };
+		if (everything || dirty.intersects(dst))
+			queue.quad(LayerFog, shade, SDL_BLENDMODE_BLEND, 0.0f, dst, { 1.0f, 1.0f, 1.0f, 1.0f });
+	}
+	if (map)
+	{
+		const SDL_FRect dst = minimapRect();
+		if (everything || dirty.intersects(dst))
+			queue.quad(LayerOverlay, map, SDL_BLENDMODE_BLEND, 0.0f, dst, { 1.0f, 1.0f, 1.0f, 1.0f });
+	}
+
+	dirty.clear();
+}
@@ -1,5 +1,140 @@
 #pragma once
-class View
+#include "Camera.h"
+#include "DirtyRegions.h"
+#include "EventBus.h"
+#include "Events.h"
+#include "Lighting.h"
+#include "Model.h"
+#include "ParticleSystem.h"
+#include "RenderQueue.h"
+#include "RenderThread.h"
+#include "StreamingTexture.h"
+#include "TextureStore.h"
+#include <SDL3/SDL_render.h>
+#include <memory>
+#include <vector>
+
+class View : public ModelObserver
 {
+public:
+	// Draw layers, lowest first. The layer is the top byte of the sort key,
+	// so it is the only ordering RenderQueue guarantees between textures.
+	enum Layer : uint8_t
+	{
+		LayerEntities = 16,
+		LayerParticles = 32,
+		LayerLight = 36,	// the light map, multiplied over what is below
+		LayerFog = 40,
+		LayerOverlay = 48,	// screen-space widgets such as the minimap
+	};
+
+	// threadedSubmit moves sorting and SDL submission to a RenderThread.
+	// org and app name the pref path that caches converted images.
+	View(SDL_Renderer* renderer, bool threadedSubmit, const char* org, const char* app);
+
+	// Register with Model::addObserver; marks moved entities dirty.
+	void onModelChanged(const Model& model, const ChangeTracker& changes) override;
+
+	// Subscribes the handlers below to bus.
+	void connect(EventBus& bus);
+	void onResized(const ViewResized* events, size_t count);
+	void onRedraw(const RedrawRequested* events, size_t count);
+	void onVSyncChanged(const VSyncChanged* events, size_t count);
+	void onIncrementalToggled(const IncrementalToggled* events, size_t count);
+	void onDirtyOverlayToggled(const DirtyOverlayToggled* events, size_t count);
+	void onMinimapToggled(const MinimapToggled* events, size_t count);
+	void onStatsRequested(const StatsRequested* events, size_t count);
+	void onZoomRequested(const ZoomRequested* events, size_t count);
+
+	// Output size in pixels; call on start-up and whenever the window resizes.
+	void resize(int width, int height);
+
+	// Advances view-only state (particles) and records the frame. Both happen
+	// after a frame slot is free, so nothing the render thread still reads
+	// is touched.
+	void render(const Model& model, float dt);
+	// Hands the recorded frame over for submission. Inline this submits and
+	// presents, blocking on vsync, so frame timing must stop before it.
+	void present() { submitter.endFrame(); }
+
+	// Applied by the submitting thread with the next frame.
+	void setVSync(int value) { vsync = value; }
+	Uint64 lastPresentNs() const { return submitter.lastPresentNs(); }
+	Uint64 lastSubmitNs() const { return submitter.lastSubmitNs(); }
+
+	// Incremental mode redraws only regions that Model or the particles
+	// report as changed into a persistent target. It pauses while the camera
+	// is zoomed or moved, since dirty regions are kept in world units, and
+	// while lighting is enabled, since every light map changes everything.
+	void setIncremental(bool enabled);
+	bool incremental() const { return incrementalMode; }
+	void setShowDirty(bool enabled) { showDirty = enabled; }
+	bool dirtyShown() const { return showDirty; }
+	void invalidateAll() { dirty.invalidateAll(); }
+
+	// Entities are drawn with this texture once it is loaded, plain quads
+	// until then or with TextureStore::NoTexture.
+	void setEntitySprite(uint32_t texture) { entitySprite = texture; }
+
+	// Entity density in the bottom-right corner, redrawn every frame into a
+	// StreamingTexture that sends only the rows that changed.
+	void setMinimap(bool enabled);
+	bool minimapShown() const { return showMinimap; }
+
+	// Shades the world by Model::visibility of team: unexplored cells dark,
+	// explored ones dimmed, visible ones clear. Only rows whose visibility
+	// changed are sent to the texture. -1 turns the fog off.
+	void setFogTeam(int team);
+	int fogTeam() const { return fogOf; }
+
+	// Stats of the most recently completed submission.
+	const RenderQueue::Stats& renderStats() const { return stats; }
+
+	ParticleSystem particles;
+	// Starts as world units = output pixels; the Controler reads it to map
+	// clicks back into the world.
+	Camera camera;
+	// Declared before submitter, so it outlives the render thread.
+	TextureStore textures;
+	// Off by default; fill lighting.lights and set lighting.enabled.
+	Lighting lighting;
+
+private:
+	void trackParticles();
+	SDL_Texture* updateMinimap(const Model& model, RenderFrame& frame);
+	SDL_FRect minimapRect() const;
+	SDL_Texture* updateFog(const Model& model, RenderFrame& frame);
+
+	SDL_Renderer* renderer;
+	RenderQueue::Stats stats;
+	int vsync;
+
+	bool incrementalMode;
+	bool showDirty;
+	DirtyRegions dirty;
+	// What is currently on screen, to erase entities that moved away.
+	bool resync;
+	std::vector<SDL_FRect> drawnEntities;
+	std::vector<SDL_FRect> drawnParticles;
+	uint32_t entitySprite;
+	SDL_Texture* drawnSprite;
+
+	bool showMinimap;
+	// Created on first use, in the texture format; before submitter, so it
+	// outlives the render thread.
+	std::unique_ptr<StreamingTexture> minimap;
+	std::vector<uint16_t> minimapCounts;
+	std::vector<uint32_t> minimapRow;
+	std::vector<uint32_t> minimapShades;
+
+	int fogOf;
+	bool fogReset;
+	std::unique_ptr<StreamingTexture> fog;
+	uint64_t fogVersion;	// Visibility::version() last drawn
+	std::vector<uint32_t> fogRow;
+	uint32_t fogShades[3];	// unexplored, explored, visible
+
+	bool lit;	// lighting.enabled as of the last frame
 
-};
\ No newline at end of file
+	RenderThread submitter;
+};
@@ -0,0 +1,252 @@
+#include "Visibility.h"
+#include "Model.h"
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+#include <algorithm>
+
+Visibility::Visibility()
+	: columns(0), rows(0), cell(1.0f), rowWords(0), updates(0), spanRadius(-1.0f), last()
+{
+	for (Team& team : teams)
+		team.planeCount = 0;
+}
+
+Visibility::Visibility(const Visibility& other)
+	: Visibility()
+{
+	resize(other.columns, other.rows, other.cell);
+}
+
+Visibility& Visibility::operator=(const Visibility& other)
+{
+	resize(other.columns, other.rows, other.cell);
+	return *this;
+}
+
+void Visibility::resize(int width, int height, float cellSize)
+{
+	columns = SDL_max(width, 0);
+	rows = SDL_max(height, 0);
+	cell = cellSize;
+	rowWords = (columns + 63) / 64;
+	const size_t words = (size_t)rows * rowWords;
+	for (Team& team : teams)
+	{
+		team.planes.clear();
+		team.planeCount = 0;
+		team.visible.assign(words, 0);
+		team.explored.assign(words, 0);
+		// Everything counts as changed, so consumers redraw all rows.
+		team.rowVersions.assign(rows, updates + 1);
+	}
+	std::fill(cellX.begin(), cellX.end(), -1);
+}
+
+bool Visibility::watch(const Model& model, EntityHandle entity, int team, float radius)
+{
+	if (!model.alive(entity) || team < 0 || team >= MaxTeams)
+		return false;
+	unwatch(entity);
+	entities.push_back(entity);
+	unitTeams.push_back((uint8_t)team);
+	radii.push_back(radius);
+	cellX.push_back(-1);
+	cellY.push_back(-1);
+	return true;
+}
+
+void Visibility::unwatch(EntityHandle entity)
+{
+	for (size_t u = 0; u < entities.size(); ++u)
+		if (entities[u] == entity)
+		{
+			remove(u);
+			return;
+		}
+}
+
+void Visibility::remove(size_t unit)
+{
+	if (cellX[unit] >= 0)
+		moveCircle(unitTeams[unit], cellX[unit], cellY[unit], -1, -1, radii[unit]);
+	const size_t back = entities.size() - 1;
+	entities[unit] = entities[back];
+	unitTeams[unit] = unitTeams[back];
+	radii[unit] = radii[back];
+	cellX[unit] = cellX[back];
+	cellY[unit] = cellY[back];
+	entities.pop_back();
+	unitTeams.pop_back();
+	radii.pop_back();
+	cellX.pop_back();
+	cellY.pop_back();
+}
+
+void Visibility::update(const Model& model)
+{
+	const Uint64 start = SDL_GetTicksNS();
+	++updates;
+	last.moved = 0;
+	last.spanWords = 0;
+	if (columns == 0 || rows == 0)
+		return;
+	const float toCell = 1.0f / cell;
+	for (size_t u = 0; u < entities.size();)
+	{
+		const size_t i = model.indexOf(entities[u]);
+		if (i == Model::NoEntity)
+		{
+			remove(u);
+			continue;
+		}
+		const int x = SDL_clamp((int)(model.posX[i] * toCell), 0, columns - 1);
+		const int y = SDL_clamp((int)(model.posY[i] * toCell), 0, rows - 1);
+		if (x != cellX[u] || y != cellY[u])
+		{
+			moveCircle(unitTeams[u], cellX[u], cellY[u], x, y, radii[u]);
+			cellX[u] = x;
+			cellY[u] = y;
+			++last.moved;
+		}
+		++u;
+	}
+	last.units = entities.size();
+	last.lastNs = SDL_GetTicksNS() - start;
+}
+
+void Visibility::moveCircle(int team, int fromX, int fromY, int toX, int toY, float radius)
+{
+	// Half widths of the circle's rows, shared by every unit of one radius.
+	radius /= cell;
+	const int reach = (int)radius;
+	if (radius != spanRadius)
+	{
+		spanRadius = radius;
+		halfWidths.resize(reach + 1);
+		for (int dy = 0; dy <= reach; ++dy)
+			halfWidths[dy] = (int)SDL_sqrtf(radius * radius - (float)(dy * dy));
+	}
+
+	// Only the cells in one circle and not the other change count, which
+	// for a step to a neighbouring cell is about two per row.
+	Team& t = teams[team];
+	const bool from = fromX >= 0;
+	const bool to = toX >= 0;
+	const int y0 = SDL_max(SDL_min(from ? fromY : toY, to ? toY : fromY) - reach, 0);
+	const int y1 = SDL_min(SDL_max(from ? fromY : toY, to ? toY : fromY) + reach, rows - 1);
+	for (int y = y0; y <= y1; ++y)
+	{
+		const bool inFrom = from && SDL_abs(y - fromY) <= reach;
+		const bool inTo = to && SDL_abs(y - toY) <= reach;
+		int a0 = 0, a1 = -1, b0 = 0, b1 = -1;
+		if (inFrom)
+		{
+			const int half = halfWidths[SDL_abs(y - fromY)];
+			a0 = SDL_max(fromX - half, 0);
+			a1 = SDL_min(fromX + half, columns - 1);
+		}
+		if (inTo)
+		{
+			const int half = halfWidths[SDL_abs(y - toY)];
+			b0 = SDL_max(toX - half, 0);
+			b1 = SDL_min(toX + half, columns - 1);
+		}
+		if (a0 == b0 && a1 == b1)
+			continue;
+		// Spans are never empty, so a difference is at most two pieces.
+		if (inTo)
+		{
+			if (!inFrom || b1 < a0 || b0 > a1)
+				addSpan(t, y, b0, b1);
+			else
+			{
+				if (b0 < a0)
+					addSpan(t, y, b0, a0 - 1);
+				if (b1 > a1)
+					addSpan(t, y, a1 + 1, b1);
+			}
+		}
+		if (inFrom)
+		{
+			if (!inTo || a1 < b0 || a0 > b1)
+				subtractSpan(t, y, a0, a1);
+			else
+			{
+				if (a0 < b0)
+					subtractSpan(t, y, a0, b0 - 1);
+				if (a1 > b1)
+					subtractSpan(t, y, b1 + 1, a1);
+			}
+		}
+	}
+}
+
+void Visibility::addSpan(Team& team, int y, int x0, int x1)
+{
+	const size_t planeWords = (size_t)rows * rowWords;
+	const size_t row = (size_t)y * rowWords;
+	bool changed = false;
+	for (int w = x0 >> 6; w <= x1 >> 6; ++w)
+	{
+		uint64_t mask = ~0ull;
+		if (w == x0 >> 6)
+			mask &= ~0ull << (x0 & 63);
+		if (w == x1 >> 6)
+			mask &= ~0ull >> (63 - (x1 & 63));
+		const size_t at = row + w;
+		++last.spanWords;
+		// Increment every masked cell's count: add the mask to plane 0 and
+		// carry into the planes above.
+		uint64_t carry = mask;
+		for (int p = 0; carry; ++p)
+		{
+			if (p == team.planeCount)
+			{
+				team.planes.resize(team.planes.size() + planeWords, 0);
+				++team.planeCount;
+			}
+			uint64_t& plane = team.planes[p * planeWords + at];
+			const uint64_t next = plane & carry;
+			plane ^= carry;
+			carry = next;
+		}
+		changed |= (team.visible[at] & mask) != mask || (team.explored[at] & mask) != mask;
+		team.visible[at] |= mask;
+		team.explored[at] |= mask;
+	}
+	if (changed)
+		team.rowVersions[y] = updates;
+}
+
+void Visibility::subtractSpan(Team& team, int y, int x0, int x1)
+{
+	const size_t planeWords = (size_t)rows * rowWords;
+	const size_t row = (size_t)y * rowWords;
+	bool changed = false;
+	for (int w = x0 >> 6; w <= x1 >> 6; ++w)
+	{
+		uint64_t mask = ~0ull;
+		if (w == x0 >> 6)
+			mask &= ~0ull << (x0 & 63);
+		if (w == x1 >> 6)
+			mask &= ~0ull >> (63 - (x1 & 63));
+		const size_t at = row + w;
+		++last.spanWords;
+		// Every masked cell was added by this unit, so no count goes below 0.
+		uint64_t borrow = mask;
+		uint64_t any = 0;
+		for (int p = 0; p < team.planeCount; ++p)
+		{
+			uint64_t& plane = team.planes[p * planeWords + at];
+			const uint64_t next = ~plane & borrow;
+			plane ^= borrow;
+			borrow = next;
+			any |= plane;
+		}
+		const uint64_t visible = (team.visible[at] & ~mask) | (any & mask);
+		changed |= visible != team.visible[at];
+		team.visible[at] = visible;
+	}
+	if (changed)
+		team.rowVersions[y] = updates;
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "EntityHandle.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Model;
+
+// Per-team fog of war over a grid of square cells. Units are entities with
+// a team and a vision radius; a unit sees the cells whose centres lie within
+// its radius of its own cell's centre.
+//
+// Every team keeps, per cell, how many of its units see it as a bit-sliced
+// counter: plane p holds bit p of every cell's count, 64 cells to a word.
+// Adding or removing one row of a vision circle is a ripple-carry add or
+// subtract of a span mask over a couple of words, and a cell is visible
+// while any plane has its bit set. A unit is only re-applied when it
+// changes cell, so a tick costs in proportion to the units that crossed a
+// cell boundary rather than to all units times their vision area.
+class Visibility
+{
+public:
+	static constexpr int MaxTeams = 4;
+
+	struct Stats
+	{
+		size_t units;
+		size_t moved;		// units re-applied by the last update
+		uint64_t spanWords;	// words touched by the last update
+		uint64_t lastNs;
+	};
+
+	Visibility();
+
+	// Units belong to the running game, like SpatialAudio's emitters: copies
+	// start without units on a clear grid of the same size, and assignment
+	// keeps the units and only takes the grid size, clearing it. After a
+	// load swaps the Model, the units look again at their new positions.
+	Visibility(const Visibility& other);
+	Visibility& operator=(const Visibility& other);
+
+	// Clears every grid; units are kept and applied again on the next
+	// update(). Also the way to resynchronise after a load.
+	void resize(int width, int height, float cellSize);
+	int width() const { return columns; }
+	int height() const { return rows; }
+	float cellSize() const { return cell; }
+	int wordsPerRow() const { return rowWords; }
+
+	// radius is in world units. Watching an entity again changes its team
+	// and radius. False for a stale handle or a team outside [0, MaxTeams).
+	bool watch(const Model& model, EntityHandle entity, int team, float radius);
+	void unwatch(EntityHandle entity);
+	size_t unitCount() const { return entities.size(); }
+
+	// Called once per Model::update after positions are final. Units whose
+	// entity was destroyed stop seeing.
+	void update(const Model& model);
+
+	// Cell (x, y) is bit x & 63 of word y * wordsPerRow() + x / 64.
+	const uint64_t* visible(int team) const { return teams[team].visible.data(); }
+	// Cells any unit of team has seen since the last resize().
+	const uint64_t* explored(int team) const { return teams[team].explored.data(); }
+	bool visibleAt(int team, int x, int y) const
+	{
+		return (teams[team].visible[(size_t)y * rowWords + (x >> 6)] >> (x & 63)) & 1;
+	}
+	// The update() count at which row y of team last changed, visible or
+	// explored; consumers remember the last one they drew.
+	uint64_t rowVersion(int team, int y) const { return teams[team].rowVersions[y]; }
+	uint64_t version() const { return updates; }
+
+	const Stats& stats() const { return last; }
+
+private:
+	struct Team
+	{
+		std::vector<uint64_t> planes;	// planeCount planes of rows * rowWords
+		int planeCount;
+		std::vector<uint64_t> visible;
+		std::vector<uint64_t> explored;
+		std::vector<uint64_t> rowVersions;
+	};
+
+	void remove(size_t unit);
+	// Takes a unit's vision from one cell to another; a negative x on
+	// either side means no circle there. radius is in world units.
+	void moveCircle(int team, int fromX, int fromY, int toX, int toY, float radius);
+	void addSpan(Team& team, int y, int x0, int x1);
+	void subtractSpan(Team& team, int y, int x0, int x1);
+
+	int columns;
+	int rows;
+	float cell;
+	int rowWords;
+	uint64_t updates;
+	Team teams[MaxTeams];
+
+	// One row per unit. cellX is -1 while the unit's circle is not applied.
+	std::vector<EntityHandle> entities;
+	std::vector<uint8_t> unitTeams;
+	std::vector<float> radii;
+	std::vector<int> cellX;
+	std::vector<int> cellY;
+	std::vector<int> halfWidths;	// per row offset, for spanRadius cells
+	float spanRadius;
+	Stats last;
+};
@@ -1,6 +1,199 @@
-#include <iostream>
-int main()
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_main.h>
+#include "Benchmark.h"
+#include "Controller.h"
+#include "EventBus.h"
+#include "FramePacer.h"
+#include "Mixer.h"
+#include "Model.h"
+#include "MusicStream.h"
+#include "SaveSystem.h"
+#include "View.h"
+#include <vector>
+
+int main(int argc, char* argv[])
 {
-	std::cout<<"Hello World!"<<std::endl;
+	if (argc > 2 && SDL_strcmp(argv[1], "--bench") == 0)
+		return runBenchmark(argv[2]);
+
+	// Submission stays on the main thread unless --threaded-render asks for a
+	// render thread: SDL only guarantees rendering from the main thread, so
+	// the thread is opt-in for backends known to tolerate it.
+	bool threadedRender = false;
+	bool incremental = false;
+	bool minimap = false;
+	int fogUnits = 0;
+	int lightCount = 0;
+	FramePacer::Mode pacing = FramePacer::Mode::VSync;
+	const char* musicPath = nullptr;
+	const char* spritePath = nullptr;
+	int textureBudgetMB = 0;
+	MusicStream::Settings musicSettings;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (SDL_strcmp(argv[i], "--threaded-render") == 0)
+			threadedRender = true;
+		else if (SDL_strcmp(argv[i], "--incremental") == 0)
+			incremental = true;
+		else if (SDL_strcmp(argv[i], "--minimap") == 0)
+			minimap = true;
+		else if (SDL_strcmp(argv[i], "--fog") == 0 && i + 1 < argc)
+			fogUnits = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+			lightCount = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--pacing") == 0 && i + 1 < argc
+			&& !FramePacer::parseMode(argv[++i], pacing))
+			SDL_Log("Unknown pacing mode '%s', using vsync", argv[i]);
+		else if (SDL_strcmp(argv[i], "--sprite") == 0 && i + 1 < argc)
+			spritePath = argv[++i];
+		else if (SDL_strcmp(argv[i], "--texture-budget") == 0 && i + 1 < argc)
+			textureBudgetMB = SDL_atoi(argv[++i]);
+		else if (SDL_strcmp(argv[i], "--music") == 0 && i + 1 < argc)
+			musicPath = argv[++i];
+		else if (SDL_strcmp(argv[i], "--music-prefetch") == 0 && i + 1 < argc)
+			musicSettings.prefetchDepth = SDL_atoi(argv[++i]);
+	}
+
+	if (!SDL_Init(SDL_INIT_VIDEO))
+	{
+		SDL_Log("SDL_Init failed: %s", SDL_GetError());
+		return 1;
+	}
+	// Audio is optional; Mixer::open reports why it cannot play.
+	if (!SDL_InitSubSystem(SDL_INIT_AUDIO))
+		SDL_Log("SDL_InitSubSystem(audio) failed: %s", SDL_GetError());
+
+	SDL_Window* window = nullptr;
+	SDL_Renderer* renderer = nullptr;
+	if (!SDL_CreateWindowAndRenderer("OOP Project AF", 1280, 720, 0, &window, &renderer))
+	{
+		SDL_Log("SDL_CreateWindowAndRenderer failed: %s", SDL_GetError());
+		SDL_Quit();
+		return 1;
+	}
+
+	{
+		Model model(1280.0f, 720.0f);
+		for (int i = 0; i < 10000; ++i)
+			model.spawn(SDL_randf() * model.worldWidth, SDL_randf() * model.worldHeight,
+				(SDL_randf() - 0.5f) * 200.0f, (SDL_randf() - 0.5f) * 200.0f);
+
+		SaveSystem saves("OOP_Project_AF", "OOP_Project_AF");
+		View view(renderer, threadedRender, "OOP_Project_AF", "OOP_Project_AF");
+		if (textureBudgetMB > 0)
+			view.textures.setBudget((size_t)textureBudgetMB << 20);
+		if (spritePath)
+			view.setEntitySprite(view.textures.load(spritePath));
+		int pixelWidth = 0;
+		int pixelHeight = 0;
+		SDL_GetWindowSizeInPixels(window, &pixelWidth, &pixelHeight);
+		view.resize(pixelWidth, pixelHeight);
+		view.setIncremental(incremental);
+		view.setMinimap(minimap);
+		// --fog N: the first N entities scout for team 0, whose fog is shown.
+		if (fogUnits > 0)
+		{
+			for (size_t i = 0; i < model.size() && i < (size_t)fogUnits; ++i)
+				model.visibility.watch(model, model.handles[i], 0, 48.0f);
+			view.setFogTeam(0);
+		}
+		// --lights N: the first N entities carry a light through a dark world.
+		std::vector<EntityHandle> lit;
+		for (size_t i = 0; i < model.size() && i < (size_t)SDL_max(lightCount, 0); ++i)
+		{
+			lit.push_back(model.handles[i]);
+			view.lighting.lights.push_back({ 0.0f, 0.0f, 24.0f + SDL_randf() * 40.0f,
+				{ 0.5f + SDL_randf() * 0.5f, 0.5f + SDL_randf() * 0.5f, 0.5f + SDL_randf() * 0.5f, 0.8f } });
+		}
+		view.lighting.enabled = !lit.empty();
+		view.lighting.ambient = { 0.08f, 0.08f, 0.12f, 1.0f };
+		model.addObserver(&view);
+		ParticleEmitter fountain = {};
+		fountain.pool = view.particles.createPool(nullptr, 200000);
+		fountain.x = model.worldWidth * 0.5f;
+		fountain.y = model.worldHeight * 0.75f;
+		fountain.rate = 20000.0f;
+		fountain.speed = 300.0f;
+		fountain.spread = 0.6f;
+		fountain.direction = -SDL_PI_F * 0.5f;
+		fountain.lifetime = 2.0f;
+		fountain.size = 2.0f;
+		fountain.color = { 1.0f, 0.6f, 0.2f, 1.0f };
+		fountain.active = true;
+		view.particles.gravity = 200.0f;
+		view.particles.addEmitter(fountain);
+		const SDL_DisplayMode* display = SDL_GetCurrentDisplayMode(SDL_GetDisplayForWindow(window));
+		FramePacer pacer(pacing, display ? display->refresh_rate : 0.0f);
+		view.setVSync(pacer.vsyncSetting());
+
+		// Declared after the model, so it stops pulling from model.audio
+		// before the model goes away. The game runs silently without a device.
+		Mixer mixer(model.audio);
+		if (mixer.open())
+		{
+			// A short decaying blip until there are sound assets.
+			std::vector<float> blip((size_t)mixer.sampleRate() / 12);
+			for (size_t i = 0; i < blip.size(); ++i)
+			{
+				const float t = (float)i / (float)mixer.sampleRate();
+				blip[i] = SDL_sinf(2.0f * SDL_PI_F * 880.0f * t) * SDL_expf(-t * 40.0f);
+			}
+			model.spawnSound = mixer.addSound(blip.data(), blip.size(), 1, mixer.sampleRate());
+		}
+		// Streamed next to the mixer on its device; closed before it.
+		MusicStream music;
+		if (musicPath && mixer.device())
+			music.openFile(mixer.device(), musicPath, musicSettings);
+
+		EventBus bus;
+		model.connect(bus);
+		view.connect(bus);
+		saves.connect(bus);
+		mixer.connect(bus);
+		music.connect(bus);
+		Controler controler(bus, pacer, view.camera);
+
+		Uint64 last = SDL_GetTicksNS();
+		bool running = true;
+		while (running)
+		{
+			// Input is sampled right after this returns.
+			pacer.beginFrame(view.lastPresentNs(), view.lastSubmitNs());
+
+			SDL_Event event;
+			while (SDL_PollEvent(&event))
+				running = controler.handleEvent(event) && running;
+			// Phase point: everything input produced is delivered before the
+			// save poll and the simulation step.
+			bus.dispatchAll();
+
+			const Uint64 now = SDL_GetTicksNS();
+			const float dt = SDL_min((float)(now - last) / 1e9f, 0.1f);
+			last = now;
+
+			// Never blocks: a finished background load is swapped in here.
+			if (saves.poll(model))
+				SDL_Log("Loaded quicksave at tick %llu", (unsigned long long)model.tick);
+
+			model.update(dt);
+			for (size_t l = 0; l < lit.size(); ++l)
+			{
+				const size_t i = model.indexOf(lit[l]);
+				if (i == Model::NoEntity)
+					continue;
+				view.lighting.lights[l].x = model.posX[i];
+				view.lighting.lights[l].y = model.posY[i];
+			}
+			view.render(model, dt);
+			// Before present(): inline submission waits for vblank there, which
+			// is not work the pacer can schedule around.
+			pacer.endFrame();
+			view.present();
+		}
+	}
+
+	SDL_DestroyRenderer(renderer);
+	SDL_DestroyWindow(window);
+	SDL_Quit();
 	return 0;
-}
\ No newline at end of file
+}